@@ -296,4 +296,90 @@ private:
     T m_array[SIZE];
 };
 
+//! Unbounded FIFO made of linked chunks, for a single writer and a single reader.
+//! Items are indexed by serial numbers, which are never reset.
+//! A chunk is allocated by the writer every \a CHUNK_SIZE items, and freed by the reader.
+template <typename T, unsigned int CHUNK_SIZE = 8192>
+class atomic_spsc_chunked_queue {
+public:
+    atomic_spsc_chunked_queue() : m_tailChunk(new Chunk), m_headChunk(m_tailChunk), m_headChunkBase(0),
+        m_numPushed(0), m_numPopped(0), m_discardBefore(0), m_numDiscarded(0) {
+        m_tailChunk->next = nullptr;
+    }
+    ~atomic_spsc_chunked_queue() {
+        for(Chunk *chunk = m_headChunk; chunk;) {
+            Chunk *next = chunk->next;
+            delete chunk;
+            chunk = next;
+        }
+    }
+
+    //! Only from the writer.
+    void push(const T &t) {
+        uint64_t serial = m_numPushed;
+        if(serial && (serial % CHUNK_SIZE == 0)) {
+            //links a new chunk before publishing the item.
+            Chunk *chunk = new Chunk;
+            chunk->next = nullptr;
+            m_tailChunk->next = chunk;
+            m_tailChunk = chunk;
+        }
+        m_tailChunk->items[serial % CHUNK_SIZE] = t;
+        m_numPushed = serial + 1;
+    }
+    //! Only from the reader.
+    //! \return false if empty.
+    bool front(T *t) {
+        uint64_t pushed = m_numPushed;
+        uint64_t popped = m_numPopped;
+        uint64_t discard = std::min((uint64_t)m_discardBefore, pushed);
+        if(popped < discard) {
+            m_numDiscarded += discard - popped;
+            popped = discard;
+            m_numPopped = popped;
+        }
+        if(popped >= pushed)
+            return false;
+        //releases chunks already read. The next chunks have been linked by the writer.
+        while(popped >= m_headChunkBase + CHUNK_SIZE) {
+            Chunk *chunk = m_headChunk;
+            m_headChunk = chunk->next;
+            m_headChunkBase += CHUNK_SIZE;
+            delete chunk;
+        }
+        *t = m_headChunk->items[popped - m_headChunkBase];
+        return true;
+    }
+    //! Only from the reader, after front() succeeded.
+    void pop() {
+        m_numPopped = m_numPopped + 1;
+    }
+    //! From any thread. Items pushed so far will be skipped by the reader.
+    void clear() {
+        m_discardBefore = (uint64_t)m_numPushed;
+    }
+    //! # of items waiting, excluding those to be skipped after clear().
+    uint64_t size() const {
+        //loaded in this order, not to exceed \a pushed.
+        uint64_t popped = m_numPopped;
+        uint64_t discard = m_discardBefore;
+        uint64_t pushed = m_numPushed;
+        return pushed - std::max(popped, discard);
+    }
+    //! # of items skipped after clear().
+    uint64_t discarded() const {return m_numDiscarded;}
+private:
+    struct Chunk {
+        T items[CHUNK_SIZE];
+        atomic<Chunk*> next;
+    };
+    Chunk *m_tailChunk; //!< owned by the writer.
+    Chunk *m_headChunk; //!< owned by the reader.
+    uint64_t m_headChunkBase; //!< serial of the first item in \a m_headChunk.
+    atomic<uint64_t> m_numPushed; //!< serial of the next item.
+    atomic<uint64_t> m_numPopped; //!< serial of the front item.
+    atomic<uint64_t> m_discardBefore;
+    atomic<uint64_t> m_numDiscarded;
+};
+
 #endif /*ATOMIC_QUEUE_H_*/
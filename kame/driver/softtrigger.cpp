@@ -56,20 +56,21 @@ SoftwareTriggerManager::unregister(const shared_ptr<SoftwareTrigger> &p) {
 
 SoftwareTrigger::SoftwareTrigger(const char *label, unsigned int bits)
     : m_label(label), m_bits(bits),
-      m_risingEdgeMask(0u), m_fallingEdgeMask(0u) {
+      m_risingEdgeMask(0u), m_fallingEdgeMask(0u),
+      m_blankTerm(0), m_endOfBlank(0), m_freq(0.0),
+      m_numDropped(0), m_numDiscarded(0), m_forcedQueueSize(0) {
     clear_();
     m_isPersistentCoherent = false;
 }
 
 void
 SoftwareTrigger::clear_() {
-    fprintf(stderr, "Softtrigger clearred with %u + %lu points remaining.\n", m_fastQueue.size(), m_slowQueue.size());
-    uint64_t x;
-    while(FastQueue::key t = m_fastQueue.atomicFront(&x)) {
-        m_fastQueue.atomicPop(t);
-    }
-    m_slowQueue.clear();
-    m_slowQueueSize = 0;
+    fprintf(stderr, "Softtrigger clearred with %lu + %lu points remaining.\n",
+        (unsigned long)pendingStamps(), (unsigned long)m_forcedQueue.size());
+    //the reader will skip the stamps before this point.
+    m_queue.clear();
+    m_forcedQueue.clear();
+    m_forcedQueueSize = 0;
     m_lastThresholdRequested = 0;
 }
 bool
@@ -77,17 +78,12 @@ SoftwareTrigger::stamp(uint64_t cnt) {
     readBarrier();
     if(cnt < m_endOfBlank) return false;
     if(cnt == 0) return false; //ignore.
-    try {
-        m_fastQueue.push(cnt);
+    if(m_queue.size() >= MAX_PENDING_STAMPS) {
+        //the reader is too slow.
+        ++m_numDropped;
     }
-    catch (FastQueue::nospace_error&) {
-        XScopedLock<XMutex> lock(m_mutex);
-        fprintf(stderr, "Slow queue!\n");
-        m_slowQueue.push_back(cnt);
-        if(m_slowQueue.size() > 100000u)
-            m_slowQueue.pop_front();
-        else
-            ++m_slowQueueSize;
+    else {
+        m_queue.push(cnt);
     }
     m_endOfBlank = cnt + m_blankTerm;
     return true;
@@ -138,42 +134,35 @@ SoftwareTrigger::tryPopFront(uint64_t threshold, double freq__) {
     unsigned int gcd__ = gcd(freq_em, freq_rc);
 
     uint64_t cnt;
-    if(m_slowQueueSize) {
+    if(m_forcedQueueSize) {
         XScopedLock<XMutex> lock(m_mutex);
-        if(FastQueue::key t = m_fastQueue.atomicFront(&cnt)) {
-            if((cnt < m_slowQueue.front()) || !m_slowQueueSize) {
-                cnt = (cnt * (freq_rc / gcd__)) / (freq_em / gcd__);
+        if(m_forcedQueueSize) {
+            uint64_t forced = m_forcedQueue.front();
+            if( !m_queue.front( &cnt) || (forced < cnt)) {
+                cnt = (forced * (freq_rc / gcd__)) / (freq_em / gcd__);
                 if(cnt >= threshold)
                     return 0uLL;
-                if(m_fastQueue.atomicPop(t))
-                    return cnt;
-                return 0uLL;
+                m_forcedQueue.pop_front();
+                --m_forcedQueueSize;
+                return cnt;
             }
         }
-        if( !m_slowQueueSize)
-            return 0uLL;
-        cnt = m_slowQueue.front();
-        cnt = (cnt * (freq_rc / gcd__)) / (freq_em / gcd__);
-        if(cnt >= threshold)
-            return 0uLL;
-        m_slowQueue.pop_front();
-        --m_slowQueueSize;
-        return cnt;
     }
-    FastQueue::key t = m_fastQueue.atomicFront(&cnt);
+    bool exists = m_queue.front( &cnt);
     uint64_t thres_em = (threshold * (freq_em / gcd__)) / (freq_rc / gcd__);
     if(m_lastThresholdRequested < thres_em + lrint(0.2 / freq())) {
         //Caches trigger positions for future use within 0.5sec.
         m_lastThresholdRequested = thres_em + lrint(0.5 / freq());
         onTriggerRequested().talk(m_lastThresholdRequested);
     }
+    if( !exists)
+        return 0uLL;
     cnt = (cnt * (freq_rc / gcd__)) / (freq_em / gcd__);
-    if( !t || (cnt >= threshold)) {
+    if(cnt >= threshold) {
         return 0uLL;
     }
-    if(m_fastQueue.atomicPop(t))
-        return cnt;
-    return 0uLL;
+    m_queue.pop();
+    return cnt;
 }
 
 void
@@ -191,15 +180,13 @@ SoftwareTrigger::clear(uint64_t now, double freq__) {
 
     XScopedLock<XMutex> lock(m_mutex);
     uint64_t x;
-    while(FastQueue::key t = m_fastQueue.atomicFront(&x)) {
-        if(x <= now)
-            m_fastQueue.atomicPop(t);
-        else
-            break;
+    while(m_queue.front( &x) && (x <= now)) {
+        m_queue.pop();
+        ++m_numDiscarded;
     }
-    while(m_slowQueue.size() && (m_slowQueue.front() <= now)) {
-        m_slowQueue.pop_front();
-        --m_slowQueueSize;
+    while(m_forcedQueue.size() && (m_forcedQueue.front() <= now)) {
+        m_forcedQueue.pop_front();
+        --m_forcedQueueSize;
     }
 }
 void
@@ -210,7 +197,6 @@ SoftwareTrigger::forceStamp(uint64_t now, double freq__) {
     now = (now * (freq_em / gcd__)) / (freq_rc / gcd__);
 
     XScopedLock<XMutex> lock(m_mutex);
-    ++m_slowQueueSize;
-    m_slowQueue.push_front(now);
-    std::sort(m_slowQueue.begin(), m_slowQueue.end());
+    m_forcedQueue.insert(std::upper_bound(m_forcedQueue.begin(), m_forcedQueue.end(), now), now);
+    ++m_forcedQueueSize;
 }
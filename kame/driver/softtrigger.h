@@ -40,6 +40,7 @@ public:
     //! issues trigger anyway.
     void forceStamp(uint64_t now, double freq);
     //! issues trigger if possible.
+    //! This is lock-free, but must not be called concurrently, i.e., by a single writer.
     //! \return true if trigger is issued.
     bool stamp(uint64_t cnt);
     //! Edge triggering.
@@ -73,9 +74,19 @@ public:
     //! clears past time stamps.
     void clear(uint64_t now, double freq);
     //! \return if not, zero will be returned.
+    //! This is lock-free unless forced stamps exist, but must not be called concurrently, i.e., by a single reader.
     //! \param freq frequency of reader.
     //! \param threshold upper bound to be pop, unit in 1/\a freq (2nd param.).
     uint64_t tryPopFront(uint64_t threshold, double freq);
+
+    //! # of stamps lost because more than MAX_PENDING_STAMPS were waiting.
+    uint64_t droppedStamps() const {return m_numDropped;}
+    //! # of stamps cleared before being read.
+    uint64_t discardedStamps() const {return m_queue.discarded() + m_numDiscarded;}
+    //! # of stamps waiting to be read.
+    uint64_t pendingStamps() const {return m_queue.size();}
+
+    enum {MAX_PENDING_STAMPS = 1024 * 1024 * 4};
 private:
     void clear_();
     const XString m_label;
@@ -86,13 +97,13 @@ private:
     uint64_t m_lastThresholdRequested;
     uint64_t m_endOfBlank; //!< next stamp must not be less than this.
     double m_freq; //!< [Hz].
-    enum {QUEUE_SIZE = 8192};
-    typedef atomic_queue_reserved<uint64_t, QUEUE_SIZE> FastQueue;
-    FastQueue m_fastQueue; //!< recorded stamps.
-    typedef std::deque<uint64_t> SlowQueue;
-    SlowQueue m_slowQueue; //!< recorded stamps, when \a m_fastQueue is full.
-    atomic<unsigned int> m_slowQueueSize;
-    XMutex m_mutex; //!< for \a m_slowQueue.
+    typedef atomic_spsc_chunked_queue<uint64_t> Queue;
+    Queue m_queue; //!< recorded stamps.
+    atomic<uint64_t> m_numDropped, m_numDiscarded;
+    typedef std::deque<uint64_t> ForcedQueue;
+    ForcedQueue m_forcedQueue; //!< stamps by forceStamp(), sorted.
+    atomic<unsigned int> m_forcedQueueSize;
+    XMutex m_mutex; //!< for \a m_forcedQueue.
     STRGTalker m_tlkStart;
     TRTalker m_tlkTriggerRequested;
     bool m_isPersistentCoherent;
@@ -0,0 +1,138 @@
+/***************************************************************************
+		Copyright (C) 2002-2015 Kentaro Kitagawa
+		                   kitagawa@phys.s.u-tokyo.ac.jp
+
+		This program is free software; you can redistribute it and/or
+		modify it under the terms of the GNU Library General Public
+		License as published by the Free Software Foundation; either
+		version 2 of the License, or (at your option) any later version.
+
+		You should have received a copy of the GNU Library General
+		Public License and a list of authors along with this program;
+		see the files COPYING and AUTHORS.
+***************************************************************************/
+#ifndef CHUNKEDRING_H_
+#define CHUNKEDRING_H_
+
+#include "atomic.h"
+#include <memory>
+#include <vector>
+#include <algorithm>
+
+//! Append-only ring keeping the latest points, stored in chunks shared among copies.
+//! Copying is O(1), suitable for transactional payloads and snapshots.
+//! A copy sees its own points only, unaffected by appending to other copies.
+//! The last chunk is appended in place unless another copy has already appended to it.
+template <typename T, unsigned int CHUNK_SIZE = 1024>
+class chunked_ring {
+public:
+    chunked_ring() = default;
+
+    size_t size() const noexcept {return m_size;}
+    bool empty() const noexcept {return !m_size;}
+    void clear() noexcept {*this = chunked_ring();}
+
+    const T &operator[](size_t i) const noexcept {
+        i += m_head;
+        return ( *m_chunks)[i / CHUNK_SIZE]->data[i % CHUNK_SIZE];
+    }
+    const T &front() const noexcept {return ( *this)[0];}
+    const T &back() const noexcept {return ( *this)[m_size - 1];}
+
+    //! Appends \a x, and drops the oldest points beyond \a capacity.
+    void push_back(const T &x, size_t capacity = (size_t)-1) {
+        *claim(1) = x;
+        if(m_size > capacity)
+            dropFront(m_size - capacity);
+    }
+    //! Appends \a n points from \a pts, copied by chunks, and drops the oldest points beyond \a capacity.
+    void append(const T *pts, size_t n, size_t capacity = (size_t)-1) {
+        if(n > capacity) {
+            pts += n - capacity;
+            n = capacity;
+        }
+        while(n) {
+            if( !m_chunks || (m_tailFilled == CHUNK_SIZE))
+                addChunk();
+            size_t len = std::min(n, CHUNK_SIZE - m_tailFilled);
+            std::copy(pts, pts + len, claim(len));
+            pts += len;
+            n -= len;
+        }
+        if(m_size > capacity)
+            dropFront(m_size - capacity);
+    }
+    //! Replaces the points with \a n points from \a pts.
+    void assign(const T *pts, size_t n) {
+        clear();
+        append(pts, n);
+    }
+    //! Drops the oldest \a n points.
+    void dropFront(size_t n) {
+        if(n >= m_size) {
+            clear();
+            return;
+        }
+        size_t chunks_dropped = (m_head + n) / CHUNK_SIZE;
+        m_head = (m_head + n) % CHUNK_SIZE;
+        m_size -= n;
+        if(chunks_dropped)
+            m_chunks = std::make_shared<ChunkList>(m_chunks->begin() + chunks_dropped, m_chunks->end());
+    }
+    //! Reads points in [\a start, \a end) by contiguous spans, calling \a f(const T *span, size_t len).
+    template <class F>
+    void for_each_span(size_t start, size_t end, F f) const {
+        start += m_head;
+        end += m_head;
+        while(start < end) {
+            size_t len = std::min(end, (start / CHUNK_SIZE + 1) * CHUNK_SIZE) - start;
+            f( &( *m_chunks)[start / CHUNK_SIZE]->data[start % CHUNK_SIZE], len);
+            start += len;
+        }
+    }
+    template <class F>
+    void for_each_span(F f) const {for_each_span(0, m_size, f);}
+private:
+    //! Claims \a n slots in the last chunk, at most the rest of it, and returns the first one.
+    T *claim(size_t n) {
+        if( !m_chunks || (m_tailFilled == CHUNK_SIZE))
+            addChunk();
+        Chunk *tail = m_chunks->back().get();
+        if( !tail->filled.compare_set_strong((unsigned int)m_tailFilled, (unsigned int)(m_tailFilled + n))) {
+            //Another copy has appended to the chunk. Clones the visible part.
+            auto chunk = std::make_shared<Chunk>();
+            std::copy(tail->data, tail->data + m_tailFilled, chunk->data);
+            chunk->filled = m_tailFilled + n;
+            ownChunks().back() = chunk;
+            tail = chunk.get();
+        }
+        T *p = tail->data + m_tailFilled;
+        m_tailFilled += n;
+        m_size += n;
+        return p;
+    }
+    void addChunk() {
+        ownChunks().push_back(std::make_shared<Chunk>());
+        m_tailFilled = 0;
+    }
+
+    struct Chunk {
+        //! # of slots claimed by any of the copies.
+        atomic<unsigned int> filled = 0;
+        T data[CHUNK_SIZE];
+    };
+    typedef std::vector<shared_ptr<Chunk> > ChunkList;
+    shared_ptr<const ChunkList> m_chunks;
+    //! The chunk list to be modified, copied unless this copy is the only owner.
+    //! Otherwise grown in place, not to copy the whole list for every chunk filled.
+    ChunkList &ownChunks() {
+        if( !m_chunks || (m_chunks.use_count() > 1))
+            m_chunks = m_chunks ? std::make_shared<ChunkList>( *m_chunks) : std::make_shared<ChunkList>();
+        return const_cast<ChunkList&>( *m_chunks);
+    }
+    size_t m_head = 0; //!< offset of the first point in the first chunk.
+    size_t m_tailFilled = 0; //!< # of points in the last chunk seen by this copy.
+    size_t m_size = 0;
+};
+
+#endif /*CHUNKEDRING_H_*/
@@ -33,6 +33,17 @@ using std::max;
 
 #define PLOT_POINT_SIZE 5.0
 
+//! # of points in the smallest bucket of the LOD.
+#define LOD_BUCKET_SIZE 4u
+//! Points are decimated into envelopes above these.
+#define LOD_MIN_POINTS 4096
+#define LOD_MIN_POINTS_PER_COLUMN 8
+
+//! Points appended after the tree has been built are scanned linearly,
+//! up to PICK_MAX_TAIL or 1/PICK_MAX_TAIL_RATIO of the tree.
+#define PICK_MAX_TAIL 4096
+#define PICK_MAX_TAIL_RATIO 64
+
 #ifdef USE_QGLWIDGET
     #define PLOT_POINT_INTENS 0.5
     #define PLOT_LINE_INTENS 0.7
@@ -53,7 +64,8 @@ XGraph::XGraph(const char *name, bool runtime) :
     m_backGround(create<XHexNode>("BackGround", true)),
     m_titleColor(create<XHexNode>("TitleColor", true)),
     m_drawLegends(create<XBoolNode>("DrawLegends", true)),
-    m_persistence(create<XDoubleNode>("Persistence", true)) {
+    m_persistence(create<XDoubleNode>("Persistence", true)),
+    m_maxFPS(create<XDoubleNode>("MaxFPS", true)) {
 
     iterate_commit([=](Transaction &tr){
 		m_lsnPropertyChanged = tr[ *label()].onValueChanged().connect(*this,
@@ -64,6 +76,7 @@ XGraph::XGraph(const char *name, bool runtime) :
 		tr[ *persistence()].onValueChanged().connect(lsnPropertyChanged());
 		tr[ *drawLegends()] = true;
         tr[ *persistence()] = 0.3;
+        tr[ *maxFPS()] = 25.0;
 
 		tr[ *label()] = name;
 
@@ -133,8 +146,10 @@ XGraph::applyTheme(Transaction &tr, bool reset_to_default, Theme theme) {
 
 void
 XGraph::onPropertyChanged(const Snapshot &shot, XValueNodeBase *) {
-	Snapshot shot_this( *this);
-	shot_this.talk(shot_this[ *this].onUpdate(), this);
+	iterate_commit([=](Transaction &tr){
+		tr[ *this].m_propertySerial++; //invalidates the vertices of the plots.
+		tr.mark(tr[ *this].onUpdate(), this);
+	});
 }
 
 void
@@ -152,7 +167,7 @@ XGraph::setupRedraw(Transaction &tr, float resolution) {
 		for(auto it = plots_list.begin(); it != plots_list.end(); ++it) {
 			auto plot = static_pointer_cast<XPlot>( *it);
 			if(plot->fixScales(tr)) {
-				plot->snapshot(shot);
+				plot->takeSnapshot(shot);
 				plot->validateAutoScale(shot);
 			}
 		}
@@ -345,23 +360,115 @@ XPlot::valToGraphFast(const XGraph::ValPoint &pt, XGraph::GPoint *gr) const {
 	else
 		gr->w = pt.w;
 }
+//! \return false if the point is not drawn, e.g., a non-positive value on a log scale.
+static inline bool
+isPickable(const XGraph::GPoint &g) {
+	return std::isfinite(g.x) && std::isfinite(g.y) && std::isfinite(g.z) &&
+		(g.x != std::numeric_limits<XGraph::GFloat>::lowest()) &&
+		(g.y != std::numeric_limits<XGraph::GFloat>::lowest()) &&
+		(g.z != std::numeric_limits<XGraph::GFloat>::lowest());
+}
+bool
+XPlot::valToScreen(const Snapshot &shot, const XGraph::ValPoint &pt, XGraph::ScrPoint *scr) {
+	if( !fixScales(shot))
+		return false;
+	XGraph::GPoint g;
+	valToGraphFast(pt, &g);
+	if( !isPickable(g))
+		return false;
+	graphToScreenFast(g, scr);
+	return true;
+}
+bool
+XPlot::isPickIndexValid(const GeometryKey &key, bool tail_limited) const {
+	const auto &idx(m_pickIndex);
+	GeometryKey key_indexed = key;
+	key_indexed.origin = idx.key.origin;
+	key_indexed.size = idx.key.size;
+	uint64_t end = key.origin + key.size;
+	uint64_t end_indexed = idx.key.origin + idx.key.size;
+	return idx.valid && (idx.keySnapshots == idx.snapshots) &&
+		(key_indexed == idx.key) && (end >= end_indexed) && ( !tail_limited ||
+		(end - end_indexed <= std::max((uint64_t)idx.tree.size() / PICK_MAX_TAIL_RATIO, (uint64_t)PICK_MAX_TAIL)));
+}
+bool
+XPlot::isPickIndexSteady(const GeometryKey &key) const {
+	const auto &idx(m_pickIndex);
+	return ((idx.lastSnapshots == idx.snapshots) && (key == idx.lastKey)) ||
+		isPickIndexValid(key, false); //only points appended to the series are missed.
+}
+void
+XPlot::updatePickIndex(const Snapshot &shot) {
+	auto &idx(m_pickIndex);
+	if( !idx.wanted || !fixScales(shot))
+		return;
+	idx.wanted = false;
+	GeometryKey key = geometryKey(shot, 0.0f);
+	if(isPickIndexValid(key))
+		return;
+	bool steady = isPickIndexSteady(key);
+	idx.lastKey = key;
+	idx.lastSnapshots = idx.snapshots;
+	if( !steady)
+		return; //changed since the query, wanted again by the next query if kept.
+	idx.entries.clear();
+	idx.entries.reserve(m_ptsSnapped.size());
+	uint64_t i = m_ptsSnappedOrigin;
+	m_ptsSnapped.for_each_span([&](const XGraph::ValPoint *pts, size_t len) {
+		for(size_t j = 0; j < len; ++j, ++i) {
+			XGraph::GPoint g;
+			valToGraphFast(pts[j], &g);
+			if(isPickable(g))
+				idx.entries.push_back({{g.x, g.y, g.z}, i});
+		}
+	});
+	idx.tree.build(std::move(idx.entries));
+	idx.key = key;
+	idx.keySnapshots = idx.snapshots;
+	idx.valid = true;
+}
 int
-XPlot::findPoint(const Snapshot &shot, int start, const XGraph::GPoint &gmin, const XGraph::GPoint &gmax,
+XPlot::findPoint(const Snapshot &shot, const XGraph::GPoint &gmin, const XGraph::GPoint &gmax,
 				 XGraph::GFloat width, XGraph::ValPoint *val, XGraph::GPoint *g1) {
-	if(fixScales(shot)) {
-		for(unsigned int i = start; i < m_ptsSnapped.size(); i++) {
-            XGraph::ValPoint v;
-            XGraph::GPoint g2;
-			v = m_ptsSnapped[i];
-			valToGraphFast(v, &g2);
-			if(g2.distance2(gmin, gmax) < width*width) {
-				*val = v;
-				*g1 = g2;
-				return i;
-			}
+	if( !fixScales(shot))
+		return -1;
+	auto &idx(m_pickIndex);
+	uint64_t origin = m_ptsSnappedOrigin;
+	uint64_t end = origin + m_ptsSnapped.size();
+	//Points appended to the series after the tree has been built are scanned, unless many.
+	//Otherwise, all the points are scanned until the tree is rebuilt.
+	uint64_t end_indexed = origin;
+	GeometryKey key = geometryKey(shot, 0.0f);
+	bool use_tree = isPickIndexValid(key);
+	if(use_tree)
+		end_indexed = idx.key.origin + idx.key.size;
+	else {
+		//The tree is wanted once the points and scales are kept since the last query or frame,
+		//or if only points appended to the series are missed.
+		//Otherwise, e.g., while autoscaling, the scan costs less than the build.
+		if(isPickIndexSteady(key))
+			idx.wanted = true;
+		idx.lastKey = key;
+		idx.lastSnapshots = idx.snapshots;
+	}
+
+	const XGraph::GFloat p0[3] = {gmin.x, gmin.y, gmin.z}, p1[3] = {gmax.x, gmax.y, gmax.z};
+	PickTree::LineQuery query(p0, p1, width, origin);
+	if(use_tree)
+		idx.tree.search(query);
+	for(uint64_t i = std::max(end_indexed, origin); i < end; ++i) {
+		XGraph::GPoint g;
+		valToGraphFast(m_ptsSnapped[i - origin], &g);
+		if(isPickable(g)) {
+			const XGraph::GFloat pos[3] = {g.x, g.y, g.z};
+			query.test(pos, i);
 		}
-    }
-    return -1;
+	}
+	if( !query.isFound())
+		return -1;
+	*val = m_ptsSnapped[query.found - origin];
+	valToGraphFast( *val, g1);
+	return query.found - origin;
 }
 
 void
@@ -431,9 +538,10 @@ XPlot::drawGrid(const Snapshot &shot, XQGraphPainter *painter, bool drawzaxis) {
 }
 int
 XPlot::drawLegend(const Snapshot &shot, XQGraphPainter *painter, const XGraph::ScrPoint &spt, float dx, float dy) {
-    if(fixScales(shot)) {
+	//Only from the snapshot, leaving the scales cached for the geometry worker.
+	if(shared_ptr<XAxis>(shot[ *axisX()]) && shared_ptr<XAxis>(shot[ *axisY()])) {
 		bool colorplot = shot[ *colorPlot()];
-		bool hasweight = !!m_curAxisW;
+		bool hasweight = !!shared_ptr<XAxis>(shot[ *axisW()]);
 		unsigned int colorhigh = shot[ *colorPlotColorHigh()];
 		unsigned int colorlow = shot[ *colorPlotColorLow()];
 		float alpha1 = hasweight ? 0.2 : 1.0;
@@ -488,35 +596,94 @@ XPlot::drawLegend(const Snapshot &shot, XQGraphPainter *painter, const XGraph::S
     return -1;
 }
 
+bool
+XPlot::GeometryKey::operator==(const GeometryKey &x) const {
+	if((serial != x.serial) || (origin != x.origin) || (size != x.size) ||
+		(propertySerial != x.propertySerial) || (resolution != x.resolution) ||
+		!(scr0 == x.scr0) || !(len == x.len))
+		return false;
+	for(int i = 0; i < 4; ++i) {
+		if((axes[i] != x.axes[i]) || (mins[i] != x.mins[i]) || (maxs[i] != x.maxs[i]))
+			return false;
+	}
+	return true;
+}
+XPlot::GeometryKey
+XPlot::geometryKey(const Snapshot &shot, float resolution) const {
+	GeometryKey key;
+	key.serial = m_ptsSnappedSerial;
+	key.origin = m_ptsSnappedOrigin;
+	key.size = m_ptsSnapped.size();
+	if(auto graph = m_graph.lock())
+		key.propertySerial = shot[ *graph].propertySerial();
+	key.resolution = resolution;
+	const XAxis *axes[] = {m_curAxisX.get(), m_curAxisY.get(), m_curAxisZ.get(), m_curAxisW.get()};
+	for(int i = 0; i < 4; ++i) {
+		key.axes[i] = axes[i];
+		if(axes[i]) {
+			key.mins[i] = axes[i]->fixedMin();
+			key.maxs[i] = axes[i]->fixedMax();
+		}
+	}
+	key.scr0 = m_scr0;
+	key.len = m_len;
+	return key;
+}
+
 int
-XPlot::drawPlot(const Snapshot &shot, XQGraphPainter *painter) {
+XPlot::drawPlot(const Snapshot &shot, XPlotGeometry *output, float resolution) {
     if(fixScales(shot)) {
+		//Points having a serial, i.e., a series or XWaveNGraph, are known to be unchanged, unlike those of XFuncPlot.
+		GeometryKey key = geometryKey(shot, resolution);
+		if(key.serial && (key == m_geometryKey)) {
+			output->append(m_geometryCached);
+			return 1;
+		}
+		m_geometryKey = GeometryKey();
+		XPlotGeometry *geometry = &m_geometryCached;
+		geometry->clear();
 		bool colorplot = shot[ *colorPlot()];
 		bool hasweight = !!m_curAxisW;
-		int cnt = m_ptsSnapped.size();
+		uint64_t i0, i1;
+		bool decimated = decimatePoints(resolution, &i0, &i1);
+		int cnt = decimated ? m_ptsDecimated.size() : (i1 - i0);
 		m_canvasPtsSnapped.resize(cnt);
 		tCanvasPoint *cpt;
 		{
-			XGraph::ScrPoint s1;
-			XGraph::GPoint g1;
 			unsigned int colorhigh = shot[ *colorPlotColorHigh()];
 			unsigned int colorlow = shot[ *colorPlotColorLow()];
 			unsigned int linecolor = shot[ *lineColor()];
+			using PlotKernels::AxisMap;
+			const AxisMap maps[] = {m_curAxisX->axisMap(), m_curAxisY->axisMap(),
+				m_curAxisZ ? m_curAxisZ->axisMap() : AxisMap::constant(0.0f),
+				m_curAxisW ? m_curAxisW->axisMap() : AxisMap::identity()};
+			PlotKernels::Arrays &g(m_batch.graph);
+			m_batch.resize(cnt);
+			size_t k = 0;
+			auto transform = [&](const XGraph::ValPoint *pts, size_t len) {
+				PlotKernels::valToGraph(pts, len, maps, g, k);
+				k += len;
+			};
+			if(decimated) {
+				if(cnt)
+					transform( &m_ptsDecimated[0], cnt);
+			}
+			else {
+				//directly from the chunks.
+				m_ptsSnapped.for_each_span(i0, i1, transform);
+			}
+			const float scr0[] = {m_scr0.x, m_scr0.y, m_scr0.z};
+			const float len[] = {m_len.x, m_len.y, m_len.z};
+			PlotKernels::graphToScreen(m_batch, cnt, scr0, len,
+				colorplot ? (hasweight ? g.w.data() : g.z.data()) : nullptr,
+				colorplot ? colorlow : linecolor, colorhigh);
+			const PlotKernels::Arrays &s(m_batch.screen);
 			cpt = &m_canvasPtsSnapped[0];
 			for(int i = 0; i < cnt; ++i) {
-				XGraph::ValPoint pt = m_ptsSnapped[i];
-				valToGraphFast(pt, &g1);
-				graphToScreenFast(g1, &s1);
-				cpt->scr = s1;
-				cpt->graph = g1;
-				cpt->insidecube = isPtIncluded(g1);
-				if(colorplot) {
-					cpt->color = blendColor(colorlow, colorhigh, 
-											hasweight ? cpt->graph.w : cpt->graph.z);
-				}
-				else {
-					cpt->color = linecolor;
-				}
+				cpt->graph = XGraph::GPoint(g.x[i], g.y[i], g.z[i], g.w[i]);
+				cpt->scr = XGraph::ScrPoint(s.x[i], s.y[i], s.z[i], s.w[i]);
+				cpt->insidecube = !m_batch.outcodes[i];
+				cpt->color = m_batch.colors[i];
 				cpt++;
 			}
 		}
@@ -527,8 +694,8 @@ XPlot::drawPlot(const Snapshot &shot, XQGraphPainter *painter) {
 			m_curAxisY->axisToScreen(shot, g0y, &s2);
 			double s0y = s2.y;
 			float alpha = max(0.0f, min((float)(shot[ *intensity()] * PLOT_BAR_INTENS), 1.0f));
-			painter->setColor(shot[ *barColor()], alpha );
-			painter->beginLine(1.0);
+			geometry->setColor(shot[ *barColor()], alpha );
+			geometry->beginLine(1.0);
 			cpt = &m_canvasPtsSnapped[0];
 			for(int i = 0; i < cnt; ++i) {
 				pt2 = *cpt;
@@ -536,58 +703,183 @@ XPlot::drawPlot(const Snapshot &shot, XQGraphPainter *painter) {
 				pt2.scr.y = s0y;
 				pt2.insidecube = isPtIncluded(pt2.graph);
 				if(clipLine( *cpt, pt2, &s1, &s2, false, NULL, NULL, NULL, NULL)) {
-					if(colorplot || hasweight) painter->setColor(cpt->color, alpha * cpt->scr.w); 
-					painter->setVertex(s1);
-					painter->setVertex(s2);
+					if(colorplot || hasweight) geometry->setColor(cpt->color, alpha * cpt->scr.w); 
+					geometry->setVertex(s1);
+					geometry->setVertex(s2);
 				}
 				cpt++;
 			}
-			painter->endLine();
+			geometry->endLine();
 		}
 		if(shot[ *drawLines()]) {
 			float alpha = max(0.0f, min((float)(shot[ *intensity()] * PLOT_LINE_INTENS), 1.0f));
-			painter->setColor(shot[ *lineColor()], alpha );
-			painter->beginLine(1.0);
+			geometry->setColor(shot[ *lineColor()], alpha );
+			geometry->beginLine(1.0);
 			XGraph::ScrPoint s1, s2;
 			cpt = &m_canvasPtsSnapped[0];
 			unsigned int color1, color2;
 			float alpha1, alpha2;
 			for(int i = 1; i < cnt; ++i) {
-				if(clipLine( *cpt, *(cpt + 1), &s1, &s2, colorplot || hasweight,
+				if((m_batch.segments[i - 1] != PlotKernels::SEGMENT_OUTSIDE) &&
+					clipLine( *cpt, *(cpt + 1), &s1, &s2, colorplot || hasweight,
 					&color1, &color2, &alpha1, &alpha2)) {
-					if(colorplot || hasweight) painter->setColor(color1, alpha*alpha1);
-					painter->setVertex(s1);
-					if(colorplot || hasweight) painter->setColor(color2, alpha*alpha2);
-					painter->setVertex(s2);
+					if(colorplot || hasweight) geometry->setColor(color1, alpha*alpha1);
+					geometry->setVertex(s1);
+					if(colorplot || hasweight) geometry->setColor(color2, alpha*alpha2);
+					geometry->setVertex(s2);
 				}
 				cpt++;
 			}
-			painter->endLine();
+			geometry->endLine();
 		}
 		if(shot[ *drawPoints()]) {
 			float alpha = max(0.0f, min((float)(shot[ *intensity()] * PLOT_POINT_INTENS), 1.0f));
-			painter->setColor(shot[ *pointColor()], alpha );
-			painter->beginPoint(PLOT_POINT_SIZE);
+			geometry->setColor(shot[ *pointColor()], alpha );
+			geometry->beginPoint(PLOT_POINT_SIZE);
 			unsigned int pointcolor = shot[ *pointColor()];
 			cpt = &m_canvasPtsSnapped[0];
 			for(int i = 0; i < cnt; ++i) {
 				if(cpt->insidecube) {
 					if(colorplot)
-						painter->setColor(cpt->color, alpha * cpt->scr.w);
+						geometry->setColor(cpt->color, alpha * cpt->scr.w);
 					else
 						if(hasweight)
-							painter->setColor(pointcolor, alpha * cpt->scr.w);
-					painter->setVertex(cpt->scr);
+							geometry->setColor(pointcolor, alpha * cpt->scr.w);
+					geometry->setVertex(cpt->scr);
 				}
 				cpt++;
 			}
-			painter->endPoint();
+			geometry->endPoint();
 		}
+		m_geometryKey = key;
+		output->append(m_geometryCached);
 		return 0;
 	}
 	return -1;
 }
 
+void
+XPlot::updateLOD() {
+	uint64_t origin = m_ptsSnappedOrigin;
+	uint64_t end = origin + m_ptsSnapped.size();
+	if( !m_ptsSnappedSerial || (m_ptsSnappedSerial != m_lod.serial) ||
+		(origin < m_lod.origin) || (end < m_lod.end) || (origin > m_lod.end)) {
+		//not appended, rebuilds all.
+		m_lod = LOD();
+		m_lod.serial = m_ptsSnappedSerial;
+		m_lod.origin = m_lod.end = m_lod.lastDescent = origin;
+	}
+	for(uint64_t i = std::max(m_lod.end, origin + 1); i < end; ++i) {
+		if(m_ptsSnapped[i - origin].x < m_ptsSnapped[i - origin - 1].x)
+			m_lod.lastDescent = i;
+	}
+	while((LOD_BUCKET_SIZE << m_lod.levels.size()) * 2 <= m_ptsSnapped.size())
+		m_lod.levels.emplace_back();
+	for(unsigned int l = 0; l < m_lod.levels.size(); ++l) {
+		LODLevel &level(m_lod.levels[l]);
+		uint64_t size = LOD_BUCKET_SIZE << l;
+		//drops buckets at the head, even partially.
+		while(level.buckets.size() && (level.first * size < origin)) {
+			level.buckets.pop_front();
+			level.first++;
+		}
+		if(level.buckets.empty())
+			level.first = (origin + size - 1) / size;
+		for(uint64_t b = level.first + level.buckets.size(); (b + 1) * size <= end; ++b) {
+			LODBucket bucket;
+			if(l == 0) {
+				bucket.imin = bucket.imax = b * size;
+				for(uint64_t i = b * size + 1; i < (b + 1) * size; ++i) {
+					double y = m_ptsSnapped[i - origin].y;
+					if(y < m_ptsSnapped[bucket.imin - origin].y) bucket.imin = i;
+					if(y > m_ptsSnapped[bucket.imax - origin].y) bucket.imax = i;
+				}
+			}
+			else {
+				//merges two buckets at the lower level.
+				const LODLevel &lower(m_lod.levels[l - 1]);
+				const LODBucket &b1(lower.buckets[2 * b - lower.first]), &b2(lower.buckets[2 * b + 1 - lower.first]);
+				bucket = b1;
+				if(m_ptsSnapped[b2.imin - origin].y < m_ptsSnapped[b1.imin - origin].y) bucket.imin = b2.imin;
+				if(m_ptsSnapped[b2.imax - origin].y > m_ptsSnapped[b1.imax - origin].y) bucket.imax = b2.imax;
+			}
+			level.buckets.push_back(bucket);
+		}
+	}
+	m_lod.origin = origin;
+	m_lod.end = end;
+}
+
+bool
+XPlot::decimatePoints(float resolution, uint64_t *i0, uint64_t *i1) {
+	updateLOD();
+	*i0 = 0;
+	*i1 = m_ptsSnapped.size();
+	if(m_ptsSnapped.size() < LOD_MIN_POINTS)
+		return false;
+	if(m_curAxisZ || (m_lod.lastDescent > m_lod.origin))
+		return false; //X is not monotonic.
+	//points in view, and the neighbors outside.
+	auto partition_point = [this](uint64_t start, uint64_t end, XGraph::GFloat pos, bool inclusive) {
+		while(start < end) {
+			uint64_t mid = start + (end - start) / 2;
+			XGraph::GFloat x = m_curAxisX->valToAxis(m_ptsSnapped[mid].x);
+			if((x < pos) || (inclusive && (x == pos)))
+				start = mid + 1;
+			else
+				end = mid;
+		}
+		return start;
+	};
+	uint64_t it0 = partition_point(0, m_ptsSnapped.size(), 0.0, false);
+	uint64_t it1 = partition_point(it0, m_ptsSnapped.size(), 1.0, true);
+	*i0 = (it0 > 0) ? it0 - 1 : 0;
+	*i1 = std::min(it1 + 1, (uint64_t)m_ptsSnapped.size());
+	double columns = std::max(1.0f, std::fabs(m_len.x) / resolution);
+	double pts_per_column = ( *i1 - *i0) / columns;
+	if(pts_per_column < LOD_MIN_POINTS_PER_COLUMN)
+		return false;
+	unsigned int l = 0;
+	while((l + 1 < m_lod.levels.size()) && ((LOD_BUCKET_SIZE << (l + 1)) <= pts_per_column))
+		++l;
+	const LODLevel &level(m_lod.levels[l]);
+	uint64_t size = LOD_BUCKET_SIZE << l;
+	m_ptsDecimated.clear();
+	auto emit = [this](uint64_t imin, uint64_t imax) {
+		m_ptsDecimated.push_back(m_ptsSnapped[std::min(imin, imax)]);
+		if(imin != imax)
+			m_ptsDecimated.push_back(m_ptsSnapped[std::max(imin, imax)]);
+	};
+	//envelope of the partial bucket, from the points.
+	auto emit_points = [&](uint64_t start, uint64_t end) {
+		if(start >= end)
+			return;
+		uint64_t imin = start, imax = start;
+		for(uint64_t i = start + 1; i < end; ++i) {
+			if(m_ptsSnapped[i].y < m_ptsSnapped[imin].y) imin = i;
+			if(m_ptsSnapped[i].y > m_ptsSnapped[imax].y) imax = i;
+		}
+		emit(imin, imax);
+	};
+	//in the series.
+	uint64_t origin = m_lod.origin;
+	uint64_t b0 = (origin + *i0 + size - 1) / size, b1 = (origin + *i1) / size;
+	m_ptsDecimated.push_back(m_ptsSnapped[ *i0]);
+	if(b0 >= b1) {
+		emit_points( *i0, *i1);
+	}
+	else {
+		emit_points( *i0, b0 * size - origin);
+		for(uint64_t b = b0; b < b1; ++b) {
+			const LODBucket &bucket(level.buckets[b - level.first]);
+			emit(bucket.imin - origin, bucket.imax - origin);
+		}
+		emit_points(b1 * size - origin, *i1);
+	}
+	m_ptsDecimated.push_back(m_ptsSnapped[ *i1 - 1]);
+	return true;
+}
+
 inline unsigned int
 XPlot::blendColor(unsigned int c1, unsigned int c2, float t) const {
     unsigned char c1red = qRed((QRgb)c1);
@@ -701,51 +993,45 @@ XPlot::validateAutoScale(const Snapshot &shot) {
 	bool autoscale_y = shot[ *m_curAxisY->autoScale()];
 	bool autoscale_z = m_curAxisZ ? shot[ *m_curAxisZ->autoScale()] : false;
 	bool autoscale_w = m_curAxisW ? shot[ *m_curAxisW->autoScale()] : false;
-	for(unsigned int i = 0; i < m_ptsSnapped.size(); ++i) {
-		XGraph::ValPoint &pt = m_ptsSnapped[i];
-		bool included = true;
-		included = included && (autoscale_x || m_curAxisX->isIncluded(pt.x));
-	    included = included && (autoscale_y || m_curAxisY->isIncluded(pt.y));
-	    if(m_curAxisZ)
-	        included = included && (autoscale_z || m_curAxisZ->isIncluded(pt.z));
-	    if(m_curAxisW)
-	        included = included && (autoscale_w || m_curAxisW->isIncluded(pt.w));
-	    else
-	        included = included && (pt.w > (XGraph::VFloat)1e-20);
-	    if(included) {
-	        m_curAxisX->tryInclude(pt.x);
-	        m_curAxisY->tryInclude(pt.y);
-	        if(m_curAxisZ)
-	            m_curAxisZ->tryInclude(pt.z);
-	        if(m_curAxisW)
-	            m_curAxisW->tryInclude(pt.w);
-	    }
-	}
+	m_ptsSnapped.for_each_span([&](const XGraph::ValPoint *pts, size_t len) {
+		for(size_t i = 0; i < len; ++i) {
+			const XGraph::ValPoint &pt = pts[i];
+			bool included = true;
+			included = included && (autoscale_x || m_curAxisX->isIncluded(pt.x));
+			included = included && (autoscale_y || m_curAxisY->isIncluded(pt.y));
+			if(m_curAxisZ)
+				included = included && (autoscale_z || m_curAxisZ->isIncluded(pt.z));
+			if(m_curAxisW)
+				included = included && (autoscale_w || m_curAxisW->isIncluded(pt.w));
+			else
+				included = included && (pt.w > (XGraph::VFloat)1e-20);
+			if(included) {
+				m_curAxisX->tryInclude(pt.x);
+				m_curAxisY->tryInclude(pt.y);
+				if(m_curAxisZ)
+					m_curAxisZ->tryInclude(pt.z);
+				if(m_curAxisW)
+					m_curAxisW->tryInclude(pt.w);
+			}
+		}
+	});
 	return 0;
 }
 
 void
 XXYPlot::clearAllPoints(Transaction &tr) {
     const Snapshot &shot(tr);
-    tr[ *this].points().clear();
-//    tr[ *this].points().shrink_to_fit();
-//    tr[ *this].points().reserve(shot[ *maxCount()]);
-    tr[ *this].m_startPos = 0;
+    tr[ *this].clearPoints();
     shared_ptr<XGraph> graph(m_graph.lock());
 	tr.mark(shot[ *graph].onUpdate(), graph.get());
 }
 
 void
 XXYPlot::snapshot(const Snapshot &shot) {
-    const auto &points(shot[ *this].points());
-    int offset = shot[ *this].m_startPos;
-    int cnt = (int)points.size();
-	m_ptsSnapped.resize(cnt);
-    int j = offset;
-    for(int i = 0; i < cnt; ++i) {
-        m_ptsSnapped[i] = points[j % cnt];
-        ++j;
-	}
+    //shares the chunks.
+    m_ptsSnapped = shot[ *this].points();
+    m_ptsSnappedSerial = shot[ *this].m_serial;
+    m_ptsSnappedOrigin = shot[ *this].m_count - m_ptsSnapped.size();
 }
 void
 XXYPlot::addPoint(Transaction &tr,
@@ -755,39 +1041,11 @@ XXYPlot::addPoint(Transaction &tr,
 	shared_ptr<XGraph> graph(m_graph.lock());
 
     const Snapshot &shot(tr);
-    auto &points(tr[ *this].points());
-    unsigned int offset = shot[ *this].m_startPos;
     unsigned int maxcount = shot[ *maxCount()];
-    if((offset && (points.size() < maxcount)) || (points.size() > maxcount)) {
-    //maxcount has changed. reorders.
-        auto buf = points;
-        int j = offset;
-        if(points.size() > maxcount) {
-        //maxcount has decreased.
-            j += points.size() - maxcount;
-            j = j % points.size();
-            points.resize(maxcount);
-        }
-        for(int i = 0; i < points.size(); ++i) {
-            points[i] = buf[j % buf.size()];
-            ++j;
-        }
-        offset = 0;
-        tr[ *this].m_startPos = 0;
-    }
+    //the oldest points are dropped, also when maxcount has decreased.
+    tr[ *this].m_points.push_back(npt, maxcount);
+    tr[ *this].m_count++;
 
-
-    if(points.size() == maxcount) {
-        unsigned int startpos = offset + 1;
-        if(startpos >= points.size())
-            startpos = 0;
-        tr[ *this].m_startPos = startpos;
-        if(points.size())
-            points[offset] = npt;
-    }
-    else {
-        points.push_back(npt);
-    }
 	tr.mark(shot[ *graph].onUpdate(), graph.get());
 }
 
@@ -994,6 +1252,13 @@ XAxis::valToAxis(XGraph::VFloat x) {
 	return pos;
 }
 
+PlotKernels::AxisMap
+XAxis::axisMap() const {
+	if(m_bLogscaleFixed)
+		return PlotKernels::AxisMap::log(m_minFixed, m_maxFixed);
+	return PlotKernels::AxisMap::linear(m_minFixed, m_maxFixed);
+}
+
 XGraph::VFloat
 XAxis::axisToVal(XGraph::GFloat pos, XGraph::GFloat axis_prec) const {
 	XGraph::VFloat x = 0;
@@ -1238,12 +1503,13 @@ XFuncPlot::XFuncPlot(const char *name, bool runtime, Transaction &tr_graph, cons
 void
 XFuncPlot::snapshot(const Snapshot &shot) {
 	unsigned int cnt = (unsigned int)shot[ *maxCount()];
-	m_ptsSnapped.resize(cnt);
+	std::vector<XGraph::ValPoint> pts(cnt);
 	for(unsigned int i = 0; i < cnt; ++i) {
-		XGraph::ValPoint &pt(m_ptsSnapped[i]);
+		XGraph::ValPoint &pt(pts[i]);
 		pt.x = m_curAxisX->axisToVal((XGraph::GFloat)i / cnt);
 		pt.y = func(pt.x);
 		pt.z = 0.0;
 	}
+	m_ptsSnapped.assign(pts.data(), cnt); //filled at once, not point by point.
 }
 
@@ -20,6 +20,11 @@
 
 #include <vector>
 #include <deque>
+#include <cmath>
+#include <cstdint>
+#include "chunkedring.h"
+#include "plotkernels.h"
+#include "picktree.h"
 
 #include <qcolor.h>
 #define clWhite (unsigned int)QColor(Qt::white).rgb()
@@ -112,6 +117,8 @@ public:
 	typedef Vector4<SFloat> ScrPoint;
 	typedef Vector4<GFloat> GPoint;
 	typedef Vector4<VFloat> ValPoint;
+	//! Points shared among payloads and snapshots in chunks.
+	typedef chunked_ring<ValPoint> ValPointRing;
  
 	//! Fixes axes and performs autoscaling of the axes.
 	//! Call this function before redrawal of the graph.
@@ -135,14 +142,24 @@ public:
 	const shared_ptr<XBoolNode> &drawLegends() const {return m_drawLegends;}
 
 	const shared_ptr<XDoubleNode> &persistence() const {return m_persistence;}
+	//! Frames per second at most, merging updates in between. Unlimited if zero.
+	const shared_ptr<XDoubleNode> &maxFPS() const {return m_maxFPS;}
 
 	const shared_ptr<Listener> &lsnPropertyChanged() const {return m_lsnPropertyChanged;}
 
+	//! Guards the scales and the points cached in the axes and plots by setupRedraw(),
+	//! which are shared by the painter in the GUI thread and its geometry worker.
+	XRecursiveMutex &drawingMutex() const {return m_drawingMutex;}
+
 	struct Payload : public XNode::Payload {
         Talker<XGraph*> &onUpdate() {return m_tlkOnUpdate;}
         const Talker<XGraph*> &onUpdate() const {return m_tlkOnUpdate;}
+        //! Changes after the properties of the graph, axes, or plots have changed.
+        unsigned int propertySerial() const {return m_propertySerial;}
 	private:
+        friend class XGraph;
         TalkerOnce<XGraph*> m_tlkOnUpdate;
+        unsigned int m_propertySerial = 0;
 	};
 
 protected:
@@ -156,12 +173,80 @@ private:
 	const shared_ptr<XHexNode> m_titleColor;
 	const shared_ptr<XBoolNode> m_drawLegends;
 	const shared_ptr<XDoubleNode> m_persistence;
+	const shared_ptr<XDoubleNode> m_maxFPS;
 
 	shared_ptr<Listener> m_lsnPropertyChanged;
 
+	mutable XRecursiveMutex m_drawingMutex;
+
     static Theme s_theme;
 };
 
+//! Vertices of plots ready for the GPU, built without an OpenGL context, e.g. in a worker thread.
+//! Drawn by XQGraphPainter with a single call per command.
+class XPlotGeometry {
+public:
+	enum class Primitive {Lines, Points};
+	//! Interleaved array for glDrawArrays().
+	struct Vertex {
+		float x, y, z;
+		uint8_t rgba[4];
+	};
+	struct Command {
+		Primitive primitive;
+		float size; //!< line width or point size, in logical pixels.
+		int first;
+		int count;
+	};
+	std::vector<Vertex> vertices;
+	std::vector<Command> commands;
+
+	//! Keeps the capacity.
+	void clear() {vertices.clear(); commands.clear();}
+	//! Appends all the primitives of \a x.
+	void append(const XPlotGeometry &x) {
+		int offset = vertices.size();
+		vertices.insert(vertices.end(), x.vertices.begin(), x.vertices.end());
+		for(auto cmd: x.commands) {
+			cmd.first += offset;
+			commands.push_back(cmd);
+		}
+	}
+
+	//! Quantizes as XQGraphPainter::setColor().
+	void setColor(unsigned int rgb, float a = 1.0f) {
+		m_color[0] = toUbyte(qRed(rgb) / 256.0f); m_color[1] = toUbyte(qGreen(rgb) / 256.0f);
+		m_color[2] = toUbyte(qBlue(rgb) / 256.0f); m_color[3] = toUbyte(a);
+	}
+	//! Only between begin*() and end*().
+	void setVertex(const XGraph::ScrPoint &p) {
+		vertices.push_back({p.x, p.y, p.z, {m_color[0], m_color[1], m_color[2], m_color[3]}});
+	}
+	void beginLine(double size = 1.0) {begin(Primitive::Lines, size);}
+	void endLine() {end();}
+	void beginPoint(double size = 1.0) {begin(Primitive::Points, size);}
+	void endPoint() {end();}
+
+	static uint8_t toUbyte(float x) {
+		return lrintf(std::min(1.0f, std::max(0.0f, x)) * 255.0f);
+	}
+private:
+	void begin(Primitive primitive, double size) {
+		m_primitive = primitive;
+		m_size = size;
+		m_first = vertices.size();
+	}
+	void end() {
+		int count = vertices.size() - m_first;
+		if(count)
+			commands.push_back({m_primitive, m_size, m_first, count});
+	}
+	Primitive m_primitive = Primitive::Lines;
+	float m_size = 1.0f;
+	int m_first = 0;
+	uint8_t m_color[4] = {0, 0, 0, 255};
+};
+
 class DECLSPEC_KAME XPlot : public XNode {
 public:
 	XPlot(const char *name, bool runtime, Transaction &tr_graph, const shared_ptr<XGraph> &graph);
@@ -177,6 +262,8 @@ public:
     void screenToGraph(const Snapshot &shot, const XGraph::ScrPoint &pt, XGraph::GPoint *g) const;
     void graphToScreen(const Snapshot &shot, const XGraph::GPoint &pt, XGraph::ScrPoint *scr);
     void graphToVal(const Snapshot &shot, const XGraph::GPoint &pt, XGraph::ValPoint *val);
+    //! \return false if the point is not drawn, e.g., a non-positive value on a log scale.
+    bool valToScreen(const Snapshot &shot, const XGraph::ValPoint &pt, XGraph::ScrPoint *scr);
 
 	const shared_ptr<XStringNode> &label() const {return m_label;}
   
@@ -205,8 +292,11 @@ public:
 
 	//! auto-scale
 	virtual int validateAutoScale(const Snapshot &shot);
-	//! Draws points from snapshot
-	int drawPlot(const Snapshot &shot, XQGraphPainter *painter);
+	//! Builds the vertices of the points from snapshot, without an OpenGL context.
+	//! The vertices are reused unless the points, scales, or properties have changed.
+	//! \param resolution minimum resolution of screen coordinate.
+	//! \return 0 if built, 1 if reused, -1 if the axes are missing.
+	int drawPlot(const Snapshot &shot, XPlotGeometry *geometry, float resolution);
 	//! Draws a point for legneds.
 	//! \a spt the center of the point.
 	//! \a dx,dy the size of the area.
@@ -214,9 +304,26 @@ public:
 	void drawGrid(const Snapshot &shot, XQGraphPainter *painter, bool drawzaxis = true);
 	//! Takes a snap-shot all points for rendering
 	virtual void snapshot(const Snapshot &shot) = 0;
+	//! Calls snapshot(), and invalidates the index for findPoint().
+	void takeSnapshot(const Snapshot &shot) {
+		snapshot(shot);
+		if( !m_ptsSnappedSerial)
+			m_pickIndex.snapshots++; //points having a serial are tracked by it instead.
+	}
   
-	//! \return found index, if not return -1 
-	int findPoint(const Snapshot &shot, int start, const XGraph::GPoint &gmin, const XGraph::GPoint &gmax,
+	//! Builds the index for findPoint() if it has been missed since the points or scales changed,
+	//! and they have been kept since then.
+	//! Call it in the thread building the geometry, with XGraph::drawingMutex() locked.
+	void updatePickIndex(const Snapshot &shot);
+	//! \return true if findPoint() has missed the index while the points and scales are kept,
+	//! to be built by updatePickIndex().
+	bool isPickIndexWanted() const {return m_pickIndex.wanted;}
+	//! Finds the point nearest to a line, e.g., a ray under the pointer,
+	//! with the k-d tree in graph coordinates, or by scanning the points if it is out of date.
+	//! \param gmin,gmax two points on the line, or the same point.
+	//! \param width maximum distance from the line.
+	//! \return found index, if not return -1
+	int findPoint(const Snapshot &shot, const XGraph::GPoint &gmin, const XGraph::GPoint &gmax,
 				  XGraph::GFloat width, XGraph::ValPoint *val, XGraph::GPoint *g1);
 
 	//! \return success or not
@@ -227,7 +334,12 @@ protected:
 
 	XGraph::ScrPoint m_scr0;
 	XGraph::ScrPoint m_len;
-	std::vector<XGraph::ValPoint> m_ptsSnapped;
+	XGraph::ValPointRing m_ptsSnapped;
+	//! Identifies \a m_ptsSnapped as a series for the incremental update of the LOD, set by snapshot().
+	//! \a m_ptsSnappedSerial is zero unless the points are a part of a series appended,
+	//! or known to be unchanged, e.g., by XWaveNGraph, and changes when they are modified otherwise.
+	//! \a m_ptsSnappedOrigin is the # of points dropped from the head of the series.
+	uint64_t m_ptsSnappedSerial = 0, m_ptsSnappedOrigin = 0;
   
 private:
 	struct tCanvasPoint {
@@ -272,6 +384,67 @@ private:
 		XQGraphPainter *painter, shared_ptr<XAxis> &axis1, shared_ptr<XAxis> &axis2);
 
 	std::vector<tCanvasPoint> m_canvasPtsSnapped; 
+	//! Working arrays for transforming the points in drawPlot().
+	PlotKernels::Batch m_batch;
+
+	//! Level of detail. Min/max envelope over consecutive points having monotonic X,
+	//! which is drawn instead of all the points when many points share a pixel column.
+	struct LODBucket {
+		uint64_t imin, imax; //!< indices in the series of the points having min./max. Y.
+	};
+	struct LODLevel {
+		uint64_t first = 0; //!< index of the front bucket.
+		std::deque<LODBucket> buckets; //!< only those entirely in \a m_ptsSnapped.
+	};
+	struct LOD {
+		uint64_t serial = 0;
+		uint64_t origin = 0, end = 0; //!< range in the series.
+		uint64_t lastDescent = 0; //!< index in the series where X decreases last.
+		std::vector<LODLevel> levels; //!< a bucket at level \a l covers LOD_BUCKET_SIZE << l points.
+	};
+	LOD m_lod;
+	//! Follows \a m_ptsSnapped, building buckets for the appended points only.
+	void updateLOD();
+	//! Finds points to be drawn.
+	//! \return true if envelopes at the current zoom are stored in \a m_ptsDecimated,
+	//! otherwise points in view are [\a i0, \a i1) of \a m_ptsSnapped.
+	bool decimatePoints(float resolution, uint64_t *i0, uint64_t *i1);
+	std::vector<XGraph::ValPoint> m_ptsDecimated;
+	//! Identifies the vertices built by drawPlot().
+	struct GeometryKey {
+		uint64_t serial = 0, origin = 0, size = 0; //!< of \a m_ptsSnapped.
+		unsigned int propertySerial = 0;
+		float resolution = 0.0f;
+		const XAxis *axes[4] = {};
+		XGraph::VFloat mins[4] = {}, maxs[4] = {}; //!< fixed scales.
+		XGraph::ScrPoint scr0, len;
+		bool operator==(const GeometryKey &x) const;
+	};
+	GeometryKey geometryKey(const Snapshot &shot, float resolution) const;
+	GeometryKey m_geometryKey;
+	XPlotGeometry m_geometryCached;
+	//! Index of \a m_ptsSnapped for findPoint().
+	//! Guarded by XGraph::drawingMutex().
+	struct PickIndex {
+		bool valid = false;
+		bool wanted = false; //!< set by findPoint() when it is out of date, but steady.
+		uint64_t snapshots = 0; //!< incremented by takeSnapshot(), unless the points have a serial.
+		//! For which the graph coordinates are valid, and the points indexed.
+		//! Indices of the entries are in the series, i.e., offset by \a m_ptsSnappedOrigin in \a m_ptsSnapped.
+		GeometryKey key;
+		uint64_t keySnapshots = 0;
+		//! Of the last query or frame missing the tree.
+		GeometryKey lastKey;
+		uint64_t lastSnapshots = 0;
+		PickTree tree;
+		std::vector<PickTree::Entry> entries; //!< storage for the next build.
+	};
+	PickIndex m_pickIndex;
+	//! \return true if the tree covers the points but those appended to the series lately.
+	//! \param tail_limited if false, however many points are appended.
+	bool isPickIndexValid(const GeometryKey &key, bool tail_limited = true) const;
+	//! \return true if \a key is kept since the last miss, or has only points appended since the build.
+	bool isPickIndexSteady(const GeometryKey &key) const;
     inline void graphToScreenFast(const XGraph::GPoint &pt, XGraph::ScrPoint *scr) const;
     inline void valToGraphFast(const XGraph::ValPoint &pt, XGraph::GPoint *gr) const;
     inline unsigned int blendColor(unsigned int c1, unsigned int c2, float t) const;
@@ -290,6 +463,8 @@ public:
     int drawAxis(const Snapshot &shot, XQGraphPainter *painter);
 	//! obtains axis pos from value
     XGraph::GFloat valToAxis(XGraph::VFloat value);
+	//! obtains the mapping of valToAxis() for batches of values
+    PlotKernels::AxisMap axisMap() const;
 	//! obtains value from position on axis
 	//! \param pos normally, 0 < \a pos < 1
 	//! \param axis_prec precision on axis. if > 0, value will be rounded
@@ -401,12 +576,17 @@ public:
 		XGraph::VFloat x, XGraph::VFloat y, XGraph::VFloat z = 0.0, XGraph::VFloat weight = 1.0);
 
     struct Payload : public XNode::Payload {
-        Payload() : XNode::Payload(), m_startPos(0) {}
-        std::vector<XGraph::ValPoint> &points() {return m_points;}
-        const std::vector<XGraph::ValPoint> &points() const {return m_points;}
-        unsigned int m_startPos;
+        //! The latest points up to maxCount(). Copying is O(1).
+        const XGraph::ValPointRing &points() const {return m_points;}
+        //! Starts a new series.
+        void clearPoints() {m_points.clear(); m_serial++; m_count = 0;}
+        //! Appends a point without limiting the # of points, unlike XXYPlot::addPoint().
+        void appendPoint(const XGraph::ValPoint &pt) {m_points.push_back(pt); m_count++;}
     private:
-        std::vector<XGraph::ValPoint> m_points;
+        friend class XXYPlot;
+        XGraph::ValPointRing m_points;
+        uint64_t m_serial = 1; //!< changes when the series is cleared.
+        uint64_t m_count = 0; //!< # of points appended in the series.
     };
 protected:
 	//! Takes a snap-shot all points for rendering
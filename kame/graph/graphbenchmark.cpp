@@ -0,0 +1,149 @@
+/***************************************************************************
+		Copyright (C) 2002-2015 Kentaro Kitagawa
+		                   kitagawa@phys.s.u-tokyo.ac.jp
+
+		This program is free software; you can redistribute it and/or
+		modify it under the terms of the GNU Library General Public
+		License as published by the Free Software Foundation; either
+		version 2 of the License, or (at your option) any later version.
+
+		You should have received a copy of the GNU Library General
+		Public License and a list of authors along with this program;
+		see the files COPYING and AUTHORS.
+***************************************************************************/
+#include "graphbenchmark.h"
+#include "graph.h"
+#include "graphwidget.h"
+#include "graphpainter.h"
+
+#include <QApplication>
+#include <QImage>
+#include <QStringList>
+#ifndef USE_QGLWIDGET
+    #include <QOpenGLContext>
+#endif
+
+int
+runGraphBenchmark(const QString &spec) {
+    int num_plots = 4, num_points = 100000, num_frames = 100;
+    int width = 1024, height = 768;
+    QString color = "none", image_file;
+    for(auto &&opt: spec.split(',', QString::SkipEmptyParts)) {
+        QString key = opt.section('=', 0, 0).trimmed(), value = opt.section('=', 1).trimmed();
+        if(key == "plots")
+            num_plots = value.toInt();
+        else if(key == "points")
+            num_points = value.toInt();
+        else if(key == "frames")
+            num_frames = value.toInt();
+        else if(key == "color")
+            color = value;
+        else if(key == "image")
+            image_file = value;
+        else if(key == "size") {
+            width = value.section('x', 0, 0).toInt();
+            height = value.section('x', 1, 1).toInt();
+        }
+        else {
+            fprintf(stderr, "Unknown option %s.\n", key.toLocal8Bit().data());
+            return -1;
+        }
+    }
+    if((num_plots <= 0) || (num_points <= 0) || (num_frames <= 0) || (width <= 0) || (height <= 0) ||
+        ((color != "none") && (color != "z") && (color != "weight"))) {
+        fprintf(stderr, "Invalid options %s.\n", spec.toLocal8Bit().data());
+        return -1;
+    }
+
+    auto graph = XNode::createOrphan<XGraph>("GraphBenchmark", false);
+    std::vector<shared_ptr<XXYPlot>> plots;
+    //A noisy trace with a phase per plot, as a DSO waveform.
+    auto point = [&](int plot, long i) {
+        double x = (double)i / num_points;
+        double y = sin(2.0 * M_PI * (8.0 * x + (double)plot / num_plots)) + 0.2 * (rand() / (double)RAND_MAX - 0.5);
+        double z = 0.5 + 0.5 * y; //for the color.
+        return XGraph::ValPoint(x, y + 2.5 * plot, z, z);
+    };
+    graph->iterate_commit([&](Transaction &tr){
+        plots.clear();
+        tr[ *graph->label()] = formatString("%d plots x %d points", num_plots, num_points);
+        tr[ *graph->maxFPS()] = 0.0; //as fast as possible.
+        tr[ *graph->persistence()] = 0.0;
+        const XNode::NodeList &axes_list( *tr.list(graph->axes()));
+        auto axisx = static_pointer_cast<XAxis>(axes_list.at(0));
+        auto axisy = static_pointer_cast<XAxis>(axes_list.at(1));
+        shared_ptr<XAxis> axisz, axisw;
+        if(color == "z")
+            axisz = graph->axes()->create<XAxis>(tr, "Z Axis", true,
+                XAxis::AxisDirection::Z, true, ref(tr), graph);
+        if(color == "weight") {
+            axisw = graph->axes()->create<XAxis>(tr, "Weight", true,
+                XAxis::AxisDirection::Weight, true, ref(tr), graph);
+            tr[ *axisw->autoScale()] = false;
+            tr[ *axisw->minValue()] = 0.0;
+            tr[ *axisw->maxValue()] = 1.0;
+        }
+        for(int p = 0; p < num_plots; ++p) {
+            auto plot = graph->plots()->create<XXYPlot>(tr, formatString("Plot%d", p).c_str(), true, ref(tr), graph);
+            tr[ *plot->label()] = formatString("Plot%d", p);
+            tr[ *plot->axisX()] = axisx;
+            tr[ *plot->axisY()] = axisy;
+            if(axisz)
+                tr[ *plot->axisZ()] = axisz;
+            if(axisw)
+                tr[ *plot->axisW()] = axisw;
+            tr[ *plot->colorPlot()] = (color != "none");
+            tr[ *plot->maxCount()] = num_points;
+            tr[ *plot].clearPoints();
+            for(long i = 0; i < num_points; ++i)
+                tr[ *plot].appendPoint(point(p, i));
+            plots.push_back(plot);
+        }
+        graph->applyTheme(tr, true);
+        tr.mark(tr[ *graph].onUpdate(), graph.get());
+    });
+
+    XQGraph widget;
+    widget.resize(width, height);
+    widget.setGraph(graph);
+    if( !widget.renderFrame()) {
+        fprintf(stderr, "No OpenGL context available.\n");
+        return -1;
+    }
+#ifndef USE_QGLWIDGET
+    widget.makeCurrent();
+    if(auto context = QOpenGLContext::currentContext())
+        printf("%s, %s\n", context->functions()->glGetString(GL_RENDERER),
+            context->functions()->glGetString(GL_VERSION));
+    widget.doneCurrent();
+#endif
+
+    double frame_time = 0.0;
+    for(long k = 0; k < num_frames; ++k) {
+        XTime time_started = XTime::now();
+        graph->iterate_commit([&](Transaction &tr){
+            for(int p = 0; p < num_plots; ++p) {
+                XGraph::ValPoint pt = point(p, num_points + k);
+                plots[p]->addPoint(tr, pt.x, pt.y, pt.z, pt.w);
+            }
+        });
+        widget.renderFrame(); //the pixels are not read back here.
+        frame_time += XTime::now() - time_started;
+        qApp->processEvents(); //repaint requests.
+    }
+    XQGraphPainter::RenderStats stats = widget.painter()->renderStats();
+    //reads the last frame back once, out of the timed loop.
+    XTime time_started = XTime::now();
+    QImage image = widget.renderOffscreen();
+    double grab_time = XTime::now() - time_started;
+    if(image_file.length() && !image.save(image_file))
+        fprintf(stderr, "Could not save %s.\n", image_file.toLocal8Bit().data());
+    printf("%d plots x %d points, color=%s, %dx%d, %d frames\n", num_plots, num_points,
+        color.toLocal8Bit().data(), width, height, num_frames);
+    printf("frame %.2f ms, geometry %.2f ms, upload %.2f ms, paint %.2f ms\n",
+        frame_time / num_frames * 1e3, stats.buildTime * 1e3, stats.uploadTime * 1e3, stats.paintTime * 1e3);
+    printf("%u frames built, %u painted, %u plots built and %u reused in the last frame\n",
+        stats.framesBuilt, stats.framesPainted, stats.plotsBuilt, stats.plotsReused);
+    printf("grabbing the image %.2f ms, not included above\n", grab_time * 1e3);
+    return 0;
+}
@@ -0,0 +1,34 @@
+/***************************************************************************
+		Copyright (C) 2002-2015 Kentaro Kitagawa
+		                   kitagawa@phys.s.u-tokyo.ac.jp
+
+		This program is free software; you can redistribute it and/or
+		modify it under the terms of the GNU Library General Public
+		License as published by the Free Software Foundation; either
+		version 2 of the License, or (at your option) any later version.
+
+		You should have received a copy of the GNU Library General
+		Public License and a list of authors along with this program;
+		see the files COPYING and AUTHORS.
+***************************************************************************/
+#ifndef GRAPHBENCHMARK_H_
+#define GRAPHBENCHMARK_H_
+
+#include "support.h"
+
+class QString;
+
+//! Renders a graph having synthetic plots offscreen, and prints the times per frame.
+//! Each frame appends a point to every plot, as a running measurement does.
+//! A frame time covers the commit, the geometry, the upload and the paint, finished by glFinish().
+//! The image is read back only once after the timed frames.
+//! Invoked by "kame --graphbench <spec>", or by the graphbench target of the build.
+//! The widget renders into the framebuffer object of the GL context which Qt provides,
+//! hence no display is needed only if the platform plugin can create a context without it,
+//! e.g. QT_QPA_PLATFORM=offscreen with an EGL-enabled Qt, or under xvfb-run.
+//! \param spec comma-separated options, e.g. "plots=4,points=100000,color=weight,frames=100,size=1024x768".
+//! \a color is one of none, z, and weight. "image=<file>" saves the last frame.
+//! \return exit code.
+DECLSPEC_KAME int runGraphBenchmark(const QString &spec);
+
+#endif /*GRAPHBENCHMARK_H_*/
@@ -36,6 +36,8 @@ XQGraphDialogConnector::XQGraphDialogConnector
     m_pItem->m_dblIntensity->setSingleStep(0.1);
     m_pItem->m_dblPersistence->setRange(0.0, 1.5);
     m_pItem->m_dblPersistence->setSingleStep(0.1);
+    m_pItem->m_dblMaxFPS->setRange(0.0, 200.0);
+    m_pItem->m_dblMaxFPS->setSingleStep(5.0);
 
     m_conBackGround = xqcon_create<XColorConnector>
 					(graph->backGround(), m_pItem->m_clrBackGroundColor);
@@ -43,6 +45,7 @@ XQGraphDialogConnector::XQGraphDialogConnector
 					 (graph->drawLegends(), m_pItem->m_ckbDrawLegends);
     m_conPersistence = xqcon_create<XQDoubleSpinBoxConnector>
                      (graph->persistence(), m_pItem->m_dblPersistence, m_pItem->m_slPersistence);
+    m_conMaxFPS = xqcon_create<XQDoubleSpinBoxConnector>(graph->maxFPS(), m_pItem->m_dblMaxFPS);
     m_conPlots = xqcon_create<XQListWidgetConnector>(m_selPlot, m_pItem->lbPlots, Snapshot( *graph));
     m_conAxes = xqcon_create<XQListWidgetConnector>(m_selAxis, m_pItem->lbAxes, Snapshot( *graph));
 
@@ -17,8 +17,11 @@
 #include <QFont>
 #include <QFontMetrics>
 #include <QPainter>
+#include <QTimer>
 
 #define SELECT_WIDTH 0.02
+#define PENDING_INPUT_RETRY 20 //[ms]
+#define PICKED_POINT_SIZE 8.0
 #define SELECT_DEPTH 0.1
 
 using std::min;
@@ -116,8 +119,89 @@ XQGraphPainter::findPlane(const Snapshot &shot, const XGraph::ScrPoint &s1,
     return plot_found;
 }
 
+shared_ptr<XPlot>
+XQGraphPainter::selectPoint(const Snapshot &shot, int x, int y, int dx, int dy,
+							XGraph::ValPoint *val) {
+	//the ray from the near plane to the far plane, and the clipping width.
+	XGraph::ScrPoint s1, s2, sdx, sdy;
+	if(windowToScreen(x, y, 0.0, &s1) || windowToScreen(x, y, 1.0, &s2) ||
+		windowToScreen(x + dx, y, 0.0, &sdx) || windowToScreen(x, y + dy, 0.0, &sdy))
+		return {};
+	double dmin = std::max(sdx.distance2(s1), sdy.distance2(s1));
+	shared_ptr<XPlot> plot_found;
+	if(shot.size(m_graph->plots())) {
+		const auto &plots_list( *shot.list(m_graph->plots()));
+		for(auto it = plots_list.begin(); it != plots_list.end(); it++) {
+			shared_ptr<XPlot> plot = dynamic_pointer_cast<XPlot>( *it);
+			if( !shot[ *plot->axisX()] || !shot[ *plot->axisY()])
+				continue;
+			XGraph::GPoint g1, g2, gdx, gdy;
+			plot->screenToGraph(shot, s1, &g1);
+			plot->screenToGraph(shot, s2, &g2);
+			plot->screenToGraph(shot, sdx, &gdx);
+			plot->screenToGraph(shot, sdy, &gdy);
+			XGraph::GFloat width = sqrt(std::max(gdx.distance2(g1), gdy.distance2(g1)));
+			XGraph::ValPoint v;
+			XGraph::GPoint g;
+			int found = plot->findPoint(shot, g1, g2, width, &v, &g);
+			if(plot->isPickIndexWanted())
+				m_worker->request(); //to build the index in the worker.
+			if(found < 0)
+				continue;
+			//compares the plots on the screen.
+			XGraph::ScrPoint s;
+			plot->graphToScreen(shot, g, &s);
+			double d = s.distance2(s1, s2);
+			if(d < dmin) {
+				dmin = d;
+				plot_found = plot;
+				*val = v;
+			}
+		}
+	}
+	return plot_found;
+}
+
 void
 XQGraphPainter::selectObjs(int x, int y, SelectionState state, SelectionMode mode) {
+	if(m_pendingSelections.size() && (state == SelectionState::Selecting) &&
+		(m_pendingSelections.back().state == SelectionState::Selecting))
+		m_pendingSelections.back() = {x, y, state, mode}; //only the last move matters.
+	else
+		m_pendingSelections.push_back({x, y, state, mode});
+	processPendingInput();
+}
+void
+XQGraphPainter::retryPendingInput() {
+	m_isPendingInputScheduled = false;
+	processPendingInput();
+}
+void
+XQGraphPainter::processPendingInput() {
+	if(m_pendingSelections.empty() && (m_pendingZoom == 1.0))
+		return;
+	//The worker holds the lock while building a frame.
+	XScopedTryLock<XRecursiveMutex> lock(m_graph->drawingMutex()); //for the scales of the axes and plots.
+	if( !lock) {
+		if( !m_isPendingInputScheduled) {
+			m_isPendingInputScheduled = true;
+			QTimer::singleShot(PENDING_INPUT_RETRY, m_pItem, SLOT(processPendingInput()));
+		}
+		return;
+	}
+	while(m_pendingSelections.size()) {
+		PendingSelection sel = m_pendingSelections.front();
+		m_pendingSelections.pop_front();
+		selectObjs_(sel.x, sel.y, sel.state, sel.mode);
+	}
+	if(m_pendingZoom != 1.0) {
+		double zoomscale = m_pendingZoom;
+		m_pendingZoom = 1.0;
+		zoom_(zoomscale);
+	}
+}
+void
+XQGraphPainter::selectObjs_(int x, int y, SelectionState state, SelectionMode mode) {
 	m_pointerLastPos[0] = x;
 	m_pointerLastPos[1] = y;
 
@@ -179,6 +263,10 @@ XQGraphPainter::selectObjs(int x, int y, SelectionState state, SelectionMode mod
                         &m_finishScrPos, &m_finishScrDX, &m_finishScrDY);
 		if(z < 1.0)
             m_foundPlane = findPlane(Snapshot( *m_graph), m_finishScrPos, &m_foundPlaneAxis1, &m_foundPlaneAxis2);
+        m_foundPoint = selectPoint(Snapshot( *m_graph), x, y,
+                        (int)(SELECT_WIDTH * m_pItem->width()),
+                        (int)(SELECT_WIDTH * m_pItem->height()),
+                        &m_foundPointVal);
 		break;
     case SelectionMode::SelPlane:
         selectPlane(x, y,
@@ -320,6 +408,11 @@ XQGraphPainter::wheel(int x, int y, double deg)
 }
 void
 XQGraphPainter::zoom(double zoomscale, int , int ) {
+	m_pendingZoom *= zoomscale;
+	processPendingInput();
+}
+void
+XQGraphPainter::zoom_(double zoomscale) {
 	XGraph::ScrPoint s1(0.5, 0.5, 0.5);
   
 	m_graph->iterate_commit([=](Transaction &tr){
@@ -334,10 +427,26 @@ XQGraphPainter::zoom(double zoomscale, int , int ) {
 		m_graph->zoomAxes(tr, resScreen(), zoomscale, s1);
     });
 }
+XQGraphPainter::RenderStats
+XQGraphPainter::renderStats() const {
+    RenderStats stats;
+    m_worker->stats( &stats);
+    stats.framesPainted = m_framesPainted;
+    stats.paintTime = m_paintTime;
+    stats.uploadTime = m_uploadTime;
+    return stats;
+}
+void
+XQGraphPainter::setVisible(bool visible) {
+    m_worker->setVisible(visible);
+}
+bool
+XQGraphPainter::waitForFrame(double timeout) {
+    return m_worker->waitForFrame(timeout);
+}
 void
 XQGraphPainter::onRedraw(const Snapshot &, XGraph *graph) {
-    m_bIsRedrawNeeded = true;
-    requestRepaint(); //may defer update.
+    m_worker->request(); //repaints when the geometry is ready.
 }
 void
 XQGraphPainter::drawOnScreenObj(const Snapshot &shot) {
@@ -362,6 +471,24 @@ XQGraphPainter::drawOnScreenObj(const Snapshot &shot) {
 		else {
 			msg = i18n("R-DBL-CLICK TO SHOW HELP");
 		}
+		if(m_foundPoint) {
+			shared_ptr<XAxis> axisx = shot[ *m_foundPoint->axisX()];
+			shared_ptr<XAxis> axisy = shot[ *m_foundPoint->axisY()];
+			if(axisx && axisy) {
+				msg += QString(" %1: (%2, %3)")
+					.arg(m_foundPoint->getLabel().c_str())
+					.arg(axisx->valToString(m_foundPointVal.x).c_str())
+					.arg(axisy->valToString(m_foundPointVal.y).c_str());
+				//follows the scales changed since the point was found.
+				XGraph::ScrPoint s;
+				if(m_foundPoint->valToScreen(shot, m_foundPointVal, &s)) {
+					beginPoint(PICKED_POINT_SIZE);
+					setColor(clRed, 0.6);
+					setVertex(s);
+					endPoint();
+				}
+			}
+		}
 		break;
     case SelectionMode::SelPlane:
 		if(m_foundPlane && !(m_startScrPos == m_finishScrPos) ) {
@@ -589,13 +716,152 @@ XQGraphPainter::drawOnScreenHelp(const Snapshot &shot, QPainter *qpainter) {
 	drawText(XGraph::ScrPoint(x, y, z), i18n("Double Click Left Button : Show Dialog"));
 	y += dy;
 	drawText(XGraph::ScrPoint(x, y, z), i18n("Double Click Right Button : This Help"));
+
+	RenderStats stats = renderStats();
+	defaultFont();
+	m_curFontSize -= 2;
+	m_curAlign = Qt::AlignTop | Qt::AlignLeft;
+	drawText(XGraph::ScrPoint(0.01, 0.99, z),
+		formatString("Paint %.1f ms (upload %.1f ms), geometry %.1f ms (%u plots built, %u reused), %u frames for %u updates",
+		stats.paintTime * 1e3, stats.uploadTime * 1e3, stats.buildTime * 1e3, stats.plotsBuilt, stats.plotsReused,
+		stats.framesBuilt, stats.framesBuilt + stats.updatesMerged));
 }
 
-Snapshot
-XQGraphPainter::startDrawing() {
-    return m_graph->iterate_commit([=](Transaction &tr){
-		m_graph->setupRedraw(tr, resScreen());
-    });
+void
+XQGraphPainter::GeometryWorker::setResolution(float resolution) {
+	XScopedLock<XCondition> lock(m_cond);
+	m_resolution = resolution;
+}
+void
+XQGraphPainter::GeometryWorker::setVisible(bool visible) {
+	XScopedLock<XCondition> lock(m_cond);
+	m_isVisible = visible;
+	if(visible && m_isRequested)
+		kick(); //deferred updates.
+}
+void
+XQGraphPainter::GeometryWorker::request() {
+	XScopedLock<XCondition> lock(m_cond);
+	if(m_isRequested)
+		m_stats.updatesMerged++;
+	m_isRequested = true;
+	if( !m_isVisible) {
+		m_stats.updatesWhileHidden++;
+		return;
+	}
+	kick();
+}
+void
+XQGraphPainter::GeometryWorker::kick() {
+	if(m_resolution <= 0.0f)
+		return; //not shown yet.
+	if(m_isRunning) {
+		m_cond.broadcast(); //also wakes up waitForFrame().
+		return;
+	}
+	m_isRunning = true;
+	m_thread.reset(new XThread{shared_from_this(), &GeometryWorker::work});
+}
+void
+XQGraphPainter::GeometryWorker::stats(RenderStats *stats) {
+	XScopedLock<XCondition> lock(m_cond);
+	stats->framesBuilt = m_stats.framesBuilt;
+	stats->updatesMerged = m_stats.updatesMerged;
+	stats->updatesWhileHidden = m_stats.updatesWhileHidden;
+	stats->plotsBuilt = m_stats.plotsBuilt;
+	stats->plotsReused = m_stats.plotsReused;
+	stats->buildTime = m_stats.buildTime;
+}
+bool
+XQGraphPainter::GeometryWorker::waitForFrame(double timeout) {
+	XTime time_started = XTime::now();
+	XScopedLock<XCondition> lock(m_cond);
+	while( !m_published) {
+		if( !m_isBuilding && !(m_isRequested && m_isVisible && (m_resolution > 0.0f)))
+			return false; //nothing to be built.
+		double rest = timeout - (XTime::now() - time_started);
+		if(rest <= 0)
+			return false;
+		m_cond.wait(std::max(1000L, lrint(rest * 1e6)));
+	}
+	return true;
+}
+shared_ptr<XQGraphPainter::Frame>
+XQGraphPainter::GeometryWorker::takeFrame() {
+	XScopedLock<XCondition> lock(m_cond);
+	return std::move(m_published);
+}
+void
+XQGraphPainter::GeometryWorker::recycle(shared_ptr<Frame> &&frame) {
+	XScopedLock<XCondition> lock(m_cond);
+	if( !m_spare)
+		m_spare = std::move(frame);
+}
+void
+XQGraphPainter::GeometryWorker::work(const atomic<bool> &terminated) {
+	for(;;) {
+		double max_fps = Snapshot( *m_graph)[ *m_graph->maxFPS()];
+		float resolution;
+		shared_ptr<Frame> frame;
+		{
+			XScopedLock<XCondition> lock(m_cond);
+			if( !m_isRequested)
+				m_cond.wait(1000000); //awaits the next update for 1 sec.
+			//Updates arriving until the next frame is due are merged.
+			while(m_isRequested && m_isVisible && (max_fps > 0) && !terminated) {
+				double rest = 1.0 / max_fps - (XTime::now() - m_timeFrameStarted);
+				if(rest <= 0)
+					break;
+				m_cond.wait(std::max(1000L, lrint(rest * 1e6)));
+			}
+			if( !m_isRequested || !m_isVisible || terminated) {
+				m_isRunning = false;
+				return; //idle, or hidden.
+			}
+			m_isRequested = false;
+			m_isBuilding = true;
+			resolution = m_resolution;
+			frame = std::move(m_spare);
+		}
+		m_timeFrameStarted = XTime::now();
+		unsigned int plots_built = 0, plots_reused = 0;
+		{
+			XScopedLock<XRecursiveMutex> lock(m_graph->drawingMutex());
+			Snapshot shot = m_graph->iterate_commit([=](Transaction &tr){
+				m_graph->setupRedraw(tr, resolution);
+			});
+			if(frame)
+				frame->shot = shot;
+			else
+				frame = std::make_shared<Frame>(shot);
+			frame->geometry.clear();
+			if(shot.size(m_graph->plots())) {
+				const auto &plots_list( *shot.list(m_graph->plots()));
+				for(auto it = plots_list.begin(); it != plots_list.end(); it++) {
+					auto plot = static_pointer_cast<XPlot>( *it);
+					switch(plot->drawPlot(shot, &frame->geometry, resolution)) {
+					case 0: plots_built++; break;
+					case 1: plots_reused++; break;
+					default: break;
+					}
+					plot->updatePickIndex(shot); //if missed by the pointer.
+				}
+			}
+			//Published with the scales, before they are set up again.
+			XScopedLock<XCondition> lock_cond(m_cond);
+			if(m_published && !m_spare)
+				m_spare = std::move(m_published); //not taken, superseded.
+			m_published = frame;
+			m_isBuilding = false;
+			m_cond.broadcast();
+			m_stats.framesBuilt++;
+			m_stats.plotsBuilt = plots_built;
+			m_stats.plotsReused = plots_reused;
+			double t = XTime::now() - m_timeFrameStarted;
+			m_stats.buildTime = (m_stats.framesBuilt > 1) ? (0.9 * m_stats.buildTime + 0.1 * t) : t;
+		}
+		m_tlkRepaint.talk(frame->shot);
+	}
 }
 void
 XQGraphPainter::drawOffScreenPlaneMarkers(const Snapshot &shot) {
@@ -682,16 +948,6 @@ XQGraphPainter::drawOffScreenGrids(const Snapshot &shot) {
 	}
 }
 void
-XQGraphPainter::drawOffScreenPoints(const Snapshot &shot) {
-	if(shot.size(m_graph->plots())) {
-		const auto &plots_list( *shot.list(m_graph->plots()));
-		for(auto it = plots_list.begin(); it != plots_list.end(); it++) {
-			auto plot = static_pointer_cast<XPlot>( *it);
-			plot->drawPlot(shot, this);
-		}
-	}
-}
-void
 XQGraphPainter::drawOffScreenAxes(const Snapshot &shot) {
 	if(shot.size(m_graph->axes())) {
 		const auto &axes_list( *shot.list(m_graph->axes()));
@@ -18,6 +18,8 @@
 #include "graphwidget.h"
 
 #include <Qt>
+#include <functional>
+#include <deque>
 
 #ifdef USE_QGLWIDGET
     #include <qgl.h>
@@ -44,10 +46,16 @@ public:
  //! Selections  
  enum class SelectionMode {SelNone, SelPoint, SelAxis, SelPlane, TiltTracking};
  enum class SelectionState {SelStart, SelFinish, Selecting};
+ //! Deferred, as well as zoom(), while \a GeometryWorker is building a frame, not to wait for it.
  void selectObjs(int x, int y, SelectionState state, SelectionMode mode = SelectionMode::SelNone);
  
  void wheel(int x, int y, double deg);
  void zoom(double zoomscale, int x, int y);
+ //! Performs the deferred selections and zooming, unless XGraph::drawingMutex() is busy.
+ //! Call it with the GL context current.
+ void processPendingInput();
+ //! Called by the timer set by processPendingInput().
+ void retryPendingInput();
  void showHelp();
  
  //! view
@@ -59,19 +67,19 @@ public:
  //! drawings
  
  void setColor(float r, float g, float b, float a = 1.0f) {
-    glColor4f(r, g, b, a );
+    setVertexColor(r, g, b, a);
     m_curTextColor = QColor(lrintf(r * 256.0), lrintf(g * 256.0), lrintf(b * 256.0), a).rgba();
 }
  void setColor(unsigned int rgb, float a = 1.0f) {
-    QColor qc = QRgb(rgb);
-    glColor4f(qc.red() / 256.0, qc.green() / 256.0, qc.blue() / 256.0, a );
-    qc.setAlpha(lrintf(a * 255));
-    m_curTextColor = qc.rgba();
+    setVertexColor(qRed(rgb) / 256.0f, qGreen(rgb) / 256.0f, qBlue(rgb) / 256.0f, a);
+    m_curTextColor = qRgba(qRed(rgb), qGreen(rgb), qBlue(rgb), lrintf(a * 255));
 }
+ //! Only between begin*() and end*().
  void setVertex(const XGraph::ScrPoint &p) {
-    glVertex3f(p.x, p.y, p.z);
+    m_staging.vertices.push_back({p.x, p.y, p.z, {m_curColor[0], m_curColor[1], m_curColor[2], m_curColor[3]}});
  }
  
+ //! Vertices between begin*() and end*() are drawn at once by a single call, from a vertex buffer object.
  void beginLine(double size = 1.0);
  void endLine();
  
@@ -99,6 +107,24 @@ public:
  
  //! minimum resolution of screen coordinate.
  float resScreen();
+ //! Render time statistics of this graph.
+ struct RenderStats {
+     unsigned int framesBuilt = 0; //!< by the geometry worker.
+     unsigned int updatesMerged = 0; //!< updates merged into the frames built.
+     unsigned int updatesWhileHidden = 0; //!< updates deferred until shown.
+     unsigned int plotsBuilt = 0, plotsReused = 0; //!< in the last frame.
+     double buildTime = 0.0; //!< [s] for setupRedraw() and the geometry, averaged over the last frames.
+     unsigned int framesPainted = 0;
+     double paintTime = 0.0; //!< [s] in paintGL(), averaged over the last frames.
+     double uploadTime = 0.0; //!< [s] for uploading the vertices in paintGL(), averaged.
+ };
+ RenderStats renderStats() const;
+ //! No frame is built while hidden or minimized.
+ void setVisible(bool visible);
+ //! Waits for a frame requested by updates of the graph, to be painted next.
+ //! \param timeout [s].
+ //! \return false if no frame is to be built, or timed out.
+ bool waitForFrame(double timeout);
  //! openGL stuff
  void initializeGL ();
  void resizeGL ( int width, int height );
@@ -123,22 +149,73 @@ private:
 					XGraph::ScrPoint *scr, XGraph::ScrPoint *dsdx, XGraph::ScrPoint *dsdy );
  double selectAxis(int x, int y, int dx, int dy,
 				   XGraph::ScrPoint *scr, XGraph::ScrPoint *dsdx, XGraph::ScrPoint *dsdy );
- double selectPoint(int x, int y, int dx, int dy,
-					XGraph::ScrPoint *scr, XGraph::ScrPoint *dsdx, XGraph::ScrPoint *dsdy );
+ //! Finds the point nearest to the ray under the pointer, by XPlot::findPoint() instead of GL selection.
+ //! Requests a frame if the index of a plot is out of date but steady, to be built by \a GeometryWorker.
+ //! \param val the value of the point.
+ //! \return the plot found.
+ shared_ptr<XPlot> selectPoint(const Snapshot &shot, int x, int y, int dx, int dy,
+					XGraph::ValPoint *val);
  
  shared_ptr<Listener> m_lsnRedraw;
  void onRedraw(const Snapshot &shot, XGraph *graph);
  
  shared_ptr<Listener> m_lsnRepaint;
- Transactional::TalkerOnce<Snapshot> m_tlkRepaint;
  void requestRepaint();
  void onRepaint(const Snapshot &shot);
+
+ //! Geometry of the plots, with the snapshot of the graph for which the scales have been set up.
+ struct Frame {
+     explicit Frame(const Snapshot &shot) : shot(shot) {}
+     Snapshot shot;
+     XPlotGeometry geometry;
+ };
+ //! Builds frames in a thread started on demand, exiting when idle, and publishes the latest one.
+ //! Not holding the painter, which must be destroyed in the GUI thread with the GL context.
+ class GeometryWorker : public enable_shared_from_this<GeometryWorker> {
+ public:
+     explicit GeometryWorker(const shared_ptr<XGraph> &graph) : m_graph(graph) {}
+     //! Starts or wakes up the thread, to build a frame from the latest graph.
+     void request();
+     //! \param resolution minimum resolution of screen coordinate.
+     void setResolution(float resolution);
+     //! Requests are deferred while invisible.
+     void setVisible(bool visible);
+     //! \return the frame published since the last call, or null.
+     //! Call it with XGraph::drawingMutex() locked, for the scales cached in the axes and plots.
+     shared_ptr<Frame> takeFrame();
+     //! Returns a frame no longer shown, in order to reuse its storage.
+     void recycle(shared_ptr<Frame> &&frame);
+     //! Talked when a frame is published.
+     Transactional::TalkerOnce<Snapshot> &tlkRepaint() {return m_tlkRepaint;}
+     //! Fills the statistics of the frames built.
+     void stats(RenderStats *stats);
+     //! \sa XQGraphPainter::waitForFrame().
+     bool waitForFrame(double timeout);
+ private:
+     //! Starts or wakes up the thread. Call it with \a m_cond locked.
+     void kick();
+     void work(const atomic<bool> &terminated);
+     const shared_ptr<XGraph> m_graph;
+     Transactional::TalkerOnce<Snapshot> m_tlkRepaint;
+     unique_ptr<XThread> m_thread;
+     XCondition m_cond;
+     bool m_isRequested = false, m_isRunning = false; //!< guarded by m_cond.
+     bool m_isBuilding = false; //!< guarded by m_cond.
+     float m_resolution = 0.0f; //!< guarded by m_cond.
+     bool m_isVisible = true; //!< guarded by m_cond.
+     shared_ptr<Frame> m_published, m_spare; //!< guarded by m_cond.
+     RenderStats m_stats; //!< guarded by m_cond.
+     XTime m_timeFrameStarted; //!< for the frame-rate limit.
+ };
+ const shared_ptr<GeometryWorker> m_worker;
+ //! Being shown, whose vertices have been moved to \a m_points.
+ shared_ptr<Frame> m_frame;
+ //! Moves the vertices to \a m_points, and uploads them.
+ void uploadGeometry(XPlotGeometry &geometry);
  
- //! Draws plots, axes.
-Snapshot startDrawing();
+ //! Draws axes etc. with the scales set up by \a GeometryWorker.
  void drawOffScreenGrids(const Snapshot &shot);
  void drawOffScreenPlaneMarkers(const Snapshot &shot); //!< for \a selectGL()
- void drawOffScreenPoints(const Snapshot &shot);
  void drawOffScreenAxes(const Snapshot &shot);
  void drawOffScreenAxisMarkers(const Snapshot &shot); //!< for \a selectGL()
  //! depends on viewpoint
@@ -150,9 +227,22 @@ Snapshot startDrawing();
  const shared_ptr<XGraph> m_graph;
  XQGraph *const m_pItem;
  
+ struct PendingSelection {
+     int x, y;
+     SelectionState state;
+     SelectionMode mode;
+ };
+ std::deque<PendingSelection> m_pendingSelections; //!< in order, moves coalesced.
+ double m_pendingZoom = 1.0;
+ bool m_isPendingInputScheduled = false;
+ void selectObjs_(int x, int y, SelectionState state, SelectionMode mode);
+ void zoom_(double zoomscale);
+
  shared_ptr<XPlot> m_foundPlane;
  shared_ptr<XAxis> m_foundPlaneAxis1, m_foundPlaneAxis2;
  shared_ptr<XAxis> m_foundAxis;
+ shared_ptr<XPlot> m_foundPoint; //!< plot having the point under the pointer.
+ XGraph::ValPoint m_foundPointVal; //!< drawn at the screen coordinate for the current scales.
  
  shared_ptr<XAxis> findAxis(const Snapshot &shot, const XGraph::ScrPoint &s1);
  shared_ptr<XPlot> findPlane(const Snapshot &shot, const XGraph::ScrPoint &s1,
@@ -166,11 +256,12 @@ Snapshot startDrawing();
  int m_tiltLastPos[2];
  int m_pointerLastPos[2];
  
- double selectGL(int x, int y, int dx, int dy, GLint list,
+ //! \param draw draws objects to be selected.
+ double selectGL(int x, int y, int dx, int dy, const std::function<void()> &draw,
 				 XGraph::ScrPoint *scr, XGraph::ScrPoint *dsdx, XGraph::ScrPoint *dsdy );
  void setInitView();
  
- GLint m_listpoints, m_listaxes,
+ GLint m_listaxes,
     m_listaxismarkers, m_listgrids, m_listplanemarkers;
  
  atomic<bool> m_bIsRedrawNeeded;
@@ -184,15 +275,18 @@ Snapshot startDrawing();
  GLint m_viewport[4]; // Current Viewport
 	
 	//! ghost stuff
-    void drawPersistentFrame(double persist_scale, const QColor &bgc);
+    void drawPersistentFrame(double persist_scale);
     void storePersistentFrame();
     XTime m_modifiedTime;
 	XTime m_updatedTime;
+    unsigned int m_framesPainted = 0;
+    double m_paintTime = 0.0; //!< [s], averaged.
+    double m_uploadTime = 0.0; //!< [s], averaged.
 //   XGraph::ScrPoint DirProj; //direction vector of z of window coord.
 	int m_curFontSize;
 	int m_curAlign;
-    GLuint m_persistentPBO = 0;
-    std::vector<GLubyte> m_persistentFrame;
+    GLuint m_persistentTexture = 0; //!< the last frame, decaying.
+    GLsizei m_persistentWidth = 0, m_persistentHeight = 0;
 
     struct Text {
         QString text;
@@ -201,8 +295,43 @@ Snapshot startDrawing();
         QRgb rgba;
     };
     std::vector<Text> m_textOverpaint; //stores text to be overpainted.
+    std::vector<Text> m_axisTexts; //!< drawn by drawOffScreenAxes() last, overpainted while the worker is busy.
     QRgb m_curTextColor;
     void drawTextOverpaint(QPainter &qpainter);
+
+    //! Interleaved array for glDrawArrays(), shared with \a XPlotGeometry.
+    typedef XPlotGeometry::Vertex Vertex;
+    struct DrawCommand {
+        GLenum primitive;
+        GLfloat size; //!< line width or point size.
+        GLint first;
+        GLsizei count;
+    };
+    struct VertexArray {
+        GLuint buffer = 0; //!< vertex buffer object, or zero for client-side arrays.
+        std::vector<Vertex> vertices;
+        std::vector<DrawCommand> commands;
+    };
+    //! Primitives being staged by begin*(), setVertex(), and end*().
+    VertexArray m_staging;
+    //! Plots, kept in the buffer and redrawn until the next frame, instead of a display list.
+    VertexArray m_points;
+    GLenum m_primitive = 0; //!< being staged, or zero.
+    GLfloat m_primitiveSize = 1.0f;
+    GLint m_primitiveFirst = 0;
+    GLubyte m_curColor[4] = {0, 0, 0, 255};
+    void setVertexColor(float r, float g, float b, float a) {
+        m_curColor[0] = XPlotGeometry::toUbyte(r); m_curColor[1] = XPlotGeometry::toUbyte(g);
+        m_curColor[2] = XPlotGeometry::toUbyte(b); m_curColor[3] = XPlotGeometry::toUbyte(a);
+        if( !m_primitive)
+            glColor4f(r, g, b, a);
+    }
+    void beginVertices(GLenum primitive, double size);
+    void endVertices();
+    //! Uploads vertices in bulk to the buffer, if any.
+    void uploadVertices(VertexArray &array, GLenum usage);
+    //! Draws by one call per command.
+    void drawVertices(const VertexArray &array);
 };
 
 #endif
@@ -33,6 +33,8 @@ using std::max;
 #include<stdio.h>
 #include <QString>
 #include <errno.h>
+#include <cstddef>
+#include <cstdint>
 
 #define DEFAULT_FONT_SIZE 12
 
@@ -65,11 +67,11 @@ using std::max;
 } 
 
 XQGraphPainter::XQGraphPainter(const shared_ptr<XGraph> &graph, XQGraph* item) :
+	m_worker(std::make_shared<GeometryWorker>(graph)),
 	m_graph(graph),
 	m_pItem(item),
     m_selectionStateNow(SelectionState::Selecting),
     m_selectionModeNow(SelectionMode::SelNone),
-	m_listpoints(0),
 	m_listaxes(0),
 	m_listgrids(0),
 	m_listplanemarkers(0),
@@ -83,7 +85,7 @@ XQGraphPainter::XQGraphPainter(const shared_ptr<XGraph> &graph, XQGraph* item) :
 		m_lsnRedraw = tr[ *graph].onUpdate().connectWeakly(
             shared_from_this(), &XQGraphPainter::onRedraw);
     });
-    m_lsnRepaint = m_tlkRepaint.connectWeakly(
+    m_lsnRepaint = m_worker->tlkRepaint().connectWeakly(
         shared_from_this(), &XQGraphPainter::onRepaint,
         Listener::FLAG_MAIN_THREAD_CALL | Listener::FLAG_AVOID_DUP | Listener::FLAG_DELAY_ADAPTIVE);
     m_pixel_ratio = m_pItem->devicePixelRatio();
@@ -95,11 +97,11 @@ XQGraphPainter::~XQGraphPainter() {
     if(m_listaxismarkers) glDeleteLists(m_listaxismarkers, 1);
     if(m_listgrids) glDeleteLists(m_listgrids, 1);
     if(m_listaxes) glDeleteLists(m_listaxes, 1);
-    if(m_listpoints) glDeleteLists(m_listpoints, 1);
 
-#ifdef USE_PBO
-    glBindBuffer(GL_ARRAY_BUFFER, m_persistentPBO);
-    glDeleteBuffers(1, &m_persistentPBO);
+    if(m_persistentTexture) glDeleteTextures(1, &m_persistentTexture);
+#ifndef USE_QGLWIDGET
+    for(auto *array: { &m_staging, &m_points})
+        if(array->buffer) glDeleteBuffers(1, &array->buffer);
 #endif
 
     m_pItem->doneCurrent();
@@ -127,7 +129,7 @@ XQGraphPainter::screenToWindow(const XGraph::ScrPoint &scr, double *x, double *y
 
 void
 XQGraphPainter::requestRepaint() {
-    m_tlkRepaint.talk(Snapshot( *m_graph)); //defers update.
+    m_worker->tlkRepaint().talk(Snapshot( *m_graph)); //defers update.
 }
 void
 XQGraphPainter::onRepaint(const Snapshot &shot) {
@@ -135,36 +137,107 @@ XQGraphPainter::onRepaint(const Snapshot &shot) {
 }
 void
 XQGraphPainter::beginLine(double size) {
-    glLineWidth(size * m_pixel_ratio);
-    checkGLError(); 
-	glBegin(GL_LINES);
+	beginVertices(GL_LINES, size);
 }
 void
 XQGraphPainter::endLine() {
-    glEnd();
+    endVertices();
     checkGLError(); 
 }
 
 void
 XQGraphPainter::beginPoint(double size) {
-    glPointSize(size * m_pixel_ratio);
-    checkGLError(); 
-	glBegin(GL_POINTS);
+	beginVertices(GL_POINTS, size);
 }
 void
 XQGraphPainter::endPoint() {
-	glEnd();
+	endVertices();
     checkGLError(); 
 }
 void
 XQGraphPainter::beginQuad(bool ) {
-	glBegin(GL_QUADS);
+	beginVertices(GL_QUADS, 1.0);
 }
 void
 XQGraphPainter::endQuad() {
-	glEnd();
+	endVertices();
     checkGLError(); 
 }
+void
+XQGraphPainter::beginVertices(GLenum primitive, double size) {
+    m_primitive = primitive;
+    m_primitiveSize = size * m_pixel_ratio;
+    m_primitiveFirst = m_staging.vertices.size();
+}
+void
+XQGraphPainter::endVertices() {
+    GLsizei count = m_staging.vertices.size() - m_primitiveFirst;
+    if(count)
+        m_staging.commands.push_back({m_primitive, m_primitiveSize, m_primitiveFirst, count});
+    m_primitive = 0;
+    uploadVertices(m_staging, GL_STREAM_DRAW);
+    drawVertices(m_staging);
+    m_staging.vertices.clear();
+    m_staging.commands.clear();
+}
+void
+XQGraphPainter::uploadGeometry(XPlotGeometry &geometry) {
+    //The storage goes back to the worker with the frame.
+    std::swap(m_points.vertices, geometry.vertices);
+    m_points.commands.clear();
+    for(auto &&cmd: geometry.commands) {
+        GLenum primitive = (cmd.primitive == XPlotGeometry::Primitive::Lines) ? GL_LINES : GL_POINTS;
+        m_points.commands.push_back({primitive, (GLfloat)(cmd.size * m_pixel_ratio), cmd.first, cmd.count});
+    }
+    geometry.clear();
+    uploadVertices(m_points, GL_STATIC_DRAW);
+    if(m_points.buffer)
+        m_points.vertices.clear();
+}
+void
+XQGraphPainter::uploadVertices(VertexArray &array, GLenum usage) {
+#ifndef USE_QGLWIDGET
+    if(array.buffer && array.vertices.size()) {
+        //All at once, orphaning the previous storage.
+        glBindBuffer(GL_ARRAY_BUFFER, array.buffer);
+        glBufferData(GL_ARRAY_BUFFER, array.vertices.size() * sizeof(Vertex), &array.vertices[0], usage);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        checkGLError();
+    }
+#endif
+}
+void
+XQGraphPainter::drawVertices(const VertexArray &array) {
+    if(array.commands.empty())
+        return;
+    uintptr_t base = 0; //offset in the buffer.
+#ifndef USE_QGLWIDGET
+    if(array.buffer)
+        glBindBuffer(GL_ARRAY_BUFFER, array.buffer);
+    else
+#endif
+        base = reinterpret_cast<uintptr_t>( &array.vertices[0]);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(Vertex), reinterpret_cast<const GLvoid*>(base + offsetof(Vertex, x)));
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Vertex), reinterpret_cast<const GLvoid*>(base + offsetof(Vertex, rgba)));
+    for(auto &&cmd: array.commands) {
+        if(cmd.primitive == GL_LINES)
+            glLineWidth(cmd.size);
+        if(cmd.primitive == GL_POINTS)
+            glPointSize(cmd.size);
+        //Compiled into a display list, if any, with the vertices dereferenced.
+        glDrawArrays(cmd.primitive, cmd.first, cmd.count);
+    }
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+#ifndef USE_QGLWIDGET
+    if(array.buffer)
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+#endif
+    //The current color is undefined after drawing with a color array.
+    glColor4ubv(m_curColor);
+}
 
 void
 XQGraphPainter::defaultFont() {
@@ -298,7 +371,7 @@ XQGraphPainter::viewRotate(double angle, double x, double y, double z, bool init
     checkGLError();
 	bool ov = m_bTilted;
 	m_bTilted = !init;
-	if(ov != m_bTilted) m_bIsRedrawNeeded = true;
+	if(ov != m_bTilted) m_bIsRedrawNeeded = true; //with the scales of the current frame.
 	
 	m_bIsAxisRedrawNeeded = true;
 }
@@ -307,7 +380,7 @@ XQGraphPainter::viewRotate(double angle, double x, double y, double z, bool init
 #define MAX_SELECTION 100
 
 double
-XQGraphPainter::selectGL(int x, int y, int dx, int dy, GLint list,
+XQGraphPainter::selectGL(int x, int y, int dx, int dy, const std::function<void()> &draw,
 						 XGraph::ScrPoint *scr, XGraph::ScrPoint *dsdx, XGraph::ScrPoint *dsdy ) {
     glGetError(); //reset error
 
@@ -326,7 +399,7 @@ XQGraphPainter::selectGL(int x, int y, int dx, int dy, GLint list,
       
 	glEnable(GL_DEPTH_TEST);
 	glLoadName(1);
-	glCallList(list);
+	draw();
       
 	glMatrixMode(GL_PROJECTION);
 	glPopMatrix();
@@ -360,17 +433,12 @@ XQGraphPainter::selectGL(int x, int y, int dx, int dy, GLint list,
 double
 XQGraphPainter::selectPlane(int x, int y, int dx, int dy,
 							XGraph::ScrPoint *scr, XGraph::ScrPoint *dsdx, XGraph::ScrPoint *dsdy ) {
-    return selectGL(x, y, dx, dy, m_listplanemarkers, scr, dsdx, dsdy);
+    return selectGL(x, y, dx, dy, [this]{glCallList(m_listplanemarkers);}, scr, dsdx, dsdy);
 }
 double
 XQGraphPainter::selectAxis(int x, int y, int dx, int dy,
                            XGraph::ScrPoint *scr, XGraph::ScrPoint *dsdx, XGraph::ScrPoint *dsdy ) {
-    return selectGL(x, y, dx, dy, m_listaxismarkers, scr, dsdx, dsdy);
-}
-double
-XQGraphPainter::selectPoint(int x, int y, int dx, int dy,
-							XGraph::ScrPoint *scr, XGraph::ScrPoint *dsdx, XGraph::ScrPoint *dsdy ) {
-	return selectGL(x, y, dx, dy, m_listpoints, scr, dsdx, dsdy);
+    return selectGL(x, y, dx, dy, [this]{glCallList(m_listaxismarkers);}, scr, dsdx, dsdy);
 }
 void
 XQGraphPainter::initializeGL () {
@@ -387,12 +455,21 @@ XQGraphPainter::initializeGL () {
     if(m_listaxismarkers) glDeleteLists(m_listaxismarkers, 1);
     if(m_listgrids) glDeleteLists(m_listgrids, 1);
     if(m_listaxes) glDeleteLists(m_listaxes, 1);
-    if(m_listpoints) glDeleteLists(m_listpoints, 1);
     m_listplanemarkers = glGenLists(1);
     m_listaxismarkers = glGenLists(1);
     m_listgrids = glGenLists(1);
     m_listaxes = glGenLists(1);
-    m_listpoints = glGenLists(1);
+    //vertex buffers for the primitives.
+    m_points.vertices.clear();
+    m_points.commands.clear();
+#ifndef USE_QGLWIDGET
+    for(auto *array: { &m_staging, &m_points}) {
+        if(array->buffer) glDeleteBuffers(1, &array->buffer);
+        glGenBuffers(1, &array->buffer);
+        if(glGetError() != GL_NO_ERROR)
+            array->buffer = 0; //client-side arrays instead.
+    }
+#endif
     glLoadIdentity();
     //saves model view matrix
     viewRotate(0.0, 0.0, 0.0, 0.0, true);
@@ -401,84 +478,64 @@ void
 XQGraphPainter::resizeGL ( int width  , int height ) {
     m_bIsRedrawNeeded = true;
     m_updatedTime = {};
+    m_worker->setResolution(resScreen());
+    m_worker->request();
 
-    //readPixels may exceed the boundary.
-    size_t bufsize = (m_pItem->width() + 1) * (m_pItem->height() + 1)
-            * m_pixel_ratio * m_pixel_ratio * 3;
-#ifdef USE_PBO
-    if(m_persistentPBO) {
-        glBindBuffer(GL_ARRAY_BUFFER, m_persistentPBO);
-        glDeleteBuffers(1, &m_persistentPBO);
-        m_persistentPBO = 0;
-    }
-    glGenBuffers(1, &m_persistentPBO);
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, m_persistentPBO);
-    glBufferData(GL_PIXEL_UNPACK_BUFFER_ARB, bufsize, 0, GL_DYNAMIC_DRAW);
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+    //The last frame for the persistence, kept in the GPU.
+    m_persistentWidth = (GLsizei)(m_pItem->width() * m_pixel_ratio);
+    m_persistentHeight = (GLsizei)(m_pItem->height() * m_pixel_ratio);
+    glGetError(); // flush error
+    if( !m_persistentTexture)
+        glGenTextures(1, &m_persistentTexture);
+    glBindTexture(GL_TEXTURE_2D, m_persistentTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, m_persistentWidth, m_persistentHeight, 0,
+                 GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
     if(glGetError() != GL_NO_ERROR) {
-        //Sometimes binding to PBO fails.
-        glBindBuffer(GL_ARRAY_BUFFER, m_persistentPBO);
-        glDeleteBuffers(1, &m_persistentPBO);
-        m_persistentPBO = 0;
-    }
-#endif
-    if( !m_persistentPBO) {
-        m_persistentFrame.clear();
-        m_persistentFrame.resize(bufsize);
-        m_persistentFrame.shrink_to_fit();
+        //persistence is disabled.
+        glDeleteTextures(1, &m_persistentTexture);
+        m_persistentTexture = 0;
     }
 }
 void
-XQGraphPainter::drawPersistentFrame(double persist_scale, const QColor &bgc) {
+XQGraphPainter::drawPersistentFrame(double persist_scale) {
+    if( !m_persistentTexture)
+        return;
     glDepthMask(GL_FALSE);
+    glDisable(GL_DEPTH_TEST);
     glPushMatrix();
     glLoadIdentity();
-    glPixelZoom(1,1);
-    glRasterPos2i(-1, -1);
-    glBlendFunc(GL_SRC_ALPHA_SATURATE, GL_ONE);
-    glClearColor(bgc.redF() * (1.0f - persist_scale), bgc.greenF() * (1.0f - persist_scale), bgc.blueF() * (1.0f - persist_scale),
-                 1.0f - persist_scale);
-    glClear(GL_COLOR_BUFFER_BIT);
-    //Foolish Windows does not comply GL_CONSTANT_ALPHA
-//            glBlendColor(0, 0, 0, persist_scale);
-//            glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
-    if(m_persistentPBO) {
-        glBindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, m_persistentPBO);
-        checkGLError();
-        glDrawPixels(m_pItem->width() * m_pixel_ratio, m_pItem->height() * m_pixel_ratio,
-                     GL_BGR, GL_UNSIGNED_BYTE,
-                    nullptr); //from PBO
-        glBindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
-    }
-    else {
-        glDrawPixels(m_pItem->width() * m_pixel_ratio, m_pItem->height() * m_pixel_ratio,
-                     GL_BGR, GL_UNSIGNED_BYTE,
-                     &m_persistentFrame[0]);
-    }
+    //Over the background already cleared,
+    //the last frame decays as frame * persist_scale + background * (1 - persist_scale).
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, m_persistentTexture);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    glColor4f(1.0f, 1.0f, 1.0f, persist_scale);
+    glBegin(GL_QUADS);
+    glTexCoord2f(0.0f, 0.0f); glVertex2f(-1.0f, -1.0f);
+    glTexCoord2f(1.0f, 0.0f); glVertex2f(1.0f, -1.0f);
+    glTexCoord2f(1.0f, 1.0f); glVertex2f(1.0f, 1.0f);
+    glTexCoord2f(0.0f, 1.0f); glVertex2f(-1.0f, 1.0f);
+    glEnd();
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDisable(GL_TEXTURE_2D);
     checkGLError();
     glPopMatrix();
+    glEnable(GL_DEPTH_TEST);
     glDepthMask(GL_TRUE);
 }
 
 void
 XQGraphPainter::storePersistentFrame() {
-    if(m_persistentPBO) {
-        glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, m_persistentPBO);
-        checkGLError();
-        glReadPixels(0, 0, m_pItem->width() * m_pixel_ratio, m_pItem->height() * m_pixel_ratio,
-                     GL_BGR, GL_UNSIGNED_BYTE,
-                     nullptr); //to PBO
-        glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, 0);
-    }
-    else {
-        GLint buf;
-        glGetIntegerv(GL_DRAW_BUFFER, &buf);
-        glReadBuffer(buf);
-        checkGLError();
-        glReadPixels(0, 0, m_pItem->width() * m_pixel_ratio, m_pItem->height() * m_pixel_ratio,
-                     GL_BGR, GL_UNSIGNED_BYTE,
-                     &m_persistentFrame[0]);
-    }
+    if( !m_persistentTexture)
+        return;
+    //copies the framebuffer being drawn into the texture, without a round trip to the CPU.
+    glBindTexture(GL_TEXTURE_2D, m_persistentTexture);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, m_persistentWidth, m_persistentHeight);
+    glBindTexture(GL_TEXTURE_2D, 0);
     checkGLError();
 }
 
@@ -491,6 +548,7 @@ XQGraphPainter::paintGL () {
 //    qpainter.setCompositionMode(QPainter::CompositionMode_SourceOver); //This might cause huge memory leak on intel's GPU in OSX.
     qpainter.beginNativePainting();
 #endif
+    XTime time_paint = XTime::now();
     Snapshot shot( *m_graph);
 
     QColor bgc = (QRgb)shot[ *m_graph->backGround()];
@@ -531,6 +589,22 @@ XQGraphPainter::paintGL () {
 
     checkGLError();
 
+    //The scales cached in the axes and plots are being set up by the worker, if busy.
+    XScopedTryLock<XRecursiveMutex> lock(m_graph->drawingMutex());
+    if(lock) {
+        if(auto frame = m_worker->takeFrame()) {
+            //Vertices of all the plots are uploaded at once, and kept for the next frames.
+            XTime time_upload = XTime::now();
+            uploadGeometry(frame->geometry);
+            double t = XTime::now() - time_upload;
+            m_uploadTime = m_uploadTime ? (0.9 * m_uploadTime + 0.1 * t) : t;
+            if(m_frame)
+                m_worker->recycle(std::move(m_frame));
+            m_frame = std::move(frame);
+            m_bIsRedrawNeeded = true;
+        }
+    }
+
 	// Ghost stuff.
 	XTime time_started = XTime::now();
     if(m_bIsRedrawNeeded || m_bIsAxisRedrawNeeded) {
@@ -542,7 +616,7 @@ XQGraphPainter::paintGL () {
         if(m_updatedTime) {
             double tau = persist / (-log(0.1)) * 2.0;
             double persist_scale = exp(-(time_started - m_updatedTime)/tau);
-            drawPersistentFrame(persist_scale, bgc);
+            drawPersistentFrame(persist_scale);
         }
         m_updatedTime = time_started;
     }
@@ -553,85 +627,69 @@ XQGraphPainter::paintGL () {
     glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA);
     glMatrixMode(GL_MODELVIEW);
 
-    if(m_bIsRedrawNeeded.compare_set_strong(true, false)) {
-        shot = startDrawing();
-
-        //For stupid OpenGL implementations.
-//        if(m_listplanemarkers) glDeleteLists(m_listplanemarkers, 1);
-//        if(m_listaxismarkers) glDeleteLists(m_listaxismarkers, 1);
-//        if(m_listgrids) glDeleteLists(m_listgrids, 1);
-//        if(m_listaxes) glDeleteLists(m_listaxes, 1);
-//        if(m_listpoints) glDeleteLists(m_listpoints, 1);
-//        m_listplanemarkers = glGenLists(1);
-//        m_listaxismarkers = glGenLists(1);
-//        m_listgrids = glGenLists(1);
-//        m_listaxes = glGenLists(1);
-//        m_listpoints = glGenLists(1);
-
-        checkGLError(); 
-
-        glNewList(m_listgrids, GL_COMPILE_AND_EXECUTE);
-        drawOffScreenGrids(shot);
-        glEndList();
+    if(m_frame && lock) {
+        //Colors etc. are taken from the graph for which the scales have been set up.
+        const Snapshot &shot_frame(m_frame->shot);
+        if(m_bIsRedrawNeeded.compare_set_strong(true, false)) {
+            checkGLError();
 
-        checkGLError();
+            glNewList(m_listgrids, GL_COMPILE_AND_EXECUTE);
+            drawOffScreenGrids(shot_frame);
+            glEndList();
 
-        glNewList(m_listpoints, GL_COMPILE_AND_EXECUTE);
-        drawOffScreenPoints(shot);
-        glEndList();
-        
-        checkGLError(); 
+            checkGLError();
 
-        if(persist > 0.0)
-            storePersistentFrame();
+            drawVertices(m_points);
 
-//        glDisable(GL_DEPTH_TEST);
-        glNewList(m_listaxes, GL_COMPILE_AND_EXECUTE);
-        drawOffScreenAxes(shot);
-        glEndList();
-        
-        checkGLError();
+            checkGLError();
 
-        glNewList(m_listaxismarkers, GL_COMPILE);
-        drawOffScreenAxisMarkers(shot);
-        glEndList();
+            if(persist > 0.0)
+                storePersistentFrame();
 
-        checkGLError();
+            glNewList(m_listaxismarkers, GL_COMPILE);
+            drawOffScreenAxisMarkers(shot_frame);
+            glEndList();
+
+            checkGLError();
+
+            glNewList(m_listplanemarkers, GL_COMPILE);
+            drawOffScreenPlaneMarkers(shot_frame);
+            glEndList();
 
-        glNewList(m_listplanemarkers, GL_COMPILE);
-        drawOffScreenPlaneMarkers(shot);
+            checkGLError();
+        }
+        else {
+            if(persist > 0.0)
+                storePersistentFrame();
+            glCallList(m_listgrids);
+            drawVertices(m_points);
+        }
+//        glDisable(GL_DEPTH_TEST);
+        //renderText() have to be called every time.
+        glNewList(m_listaxes, GL_COMPILE_AND_EXECUTE);
+        drawOffScreenAxes(shot_frame);
         glEndList();
+        m_axisTexts = m_textOverpaint;
+        m_bIsAxisRedrawNeeded = false;
 
         checkGLError();
-        m_bIsAxisRedrawNeeded = false;
     }
-    else {        
+    else if(m_frame) {
+        //Replays the last frame, not to wait for the worker.
         if(persist > 0.0)
             storePersistentFrame();
         glCallList(m_listgrids);
-        glCallList(m_listpoints);
-//        glDisable(GL_DEPTH_TEST);
-        if(1) { //renderText() have to be called every time.
-//        if(m_bIsAxisRedrawNeeded) {
-            //For stupid OpenGL implementations.
-//            if(m_listaxes) glDeleteLists(m_listaxes, 1);
-//            m_listaxes = glGenLists(1);
-
-            glNewList(m_listaxes, GL_COMPILE_AND_EXECUTE);
-            drawOffScreenAxes(shot);
-            glEndList();
-            m_bIsAxisRedrawNeeded = false;
-        }
-        else {
-            glCallList(m_listaxes);
-        }
+        drawVertices(m_points);
+        glCallList(m_listaxes);
+        m_textOverpaint = m_axisTexts;
     }
 
     if(time_started - m_modifiedTime < persist) {
         QTimer::singleShot(50, m_pItem, SLOT(update()));
     }
 
-    drawOnScreenObj(shot);
+    if(lock)
+        drawOnScreenObj(shot);
 
     glMatrixMode(GL_PROJECTION);
 GLdouble proj_orig[16];
@@ -673,6 +731,9 @@ GLdouble proj_orig[16];
     qpainter.end();
 
     memcpy(m_proj, proj_orig, sizeof(proj_orig));
+
+    double t = XTime::now() - time_paint;
+    m_paintTime = m_framesPainted++ ? (0.9 * m_paintTime + 0.1 * t) : t;
 }
 
 void
@@ -70,6 +70,42 @@ XQGraph::setGraph(const shared_ptr<XGraph> &graph) {
 //		showEvent(NULL);
 //    }
 }
+bool
+XQGraph::renderFrame(double timeout) {
+#ifdef USE_QGLWIDGET
+    if( !isVisible()) {
+        setAttribute(Qt::WA_DontShowOnScreen);
+        show();
+    }
+#else
+    if( !m_painter) {
+        //initializes GL with the framebuffer object only, even if never shown.
+        grabFramebuffer();
+        makeCurrent();
+        resizeGL(width(), height());
+        doneCurrent();
+    }
+#endif
+    if( !m_painter)
+        return false;
+    m_painter->waitForFrame(timeout);
+    //paints into the framebuffer (object), without reading the pixels back.
+    makeCurrent();
+    paintGL();
+    glFinish();
+    doneCurrent();
+    return true;
+}
+QImage
+XQGraph::renderOffscreen(double timeout) {
+    if( !renderFrame(timeout))
+        return QImage();
+#ifdef USE_QGLWIDGET
+    return grabFrameBuffer();
+#else
+    return grabFramebuffer();
+#endif
+}
 void
 XQGraph::mousePressEvent ( QMouseEvent* e) {
 	if( !m_painter ) return;
@@ -109,6 +145,13 @@ XQGraph::mouseReleaseEvent ( QMouseEvent* e) {
     doneCurrent();
 }
 void
+XQGraph::processPendingInput() {
+	if( !m_painter ) return;
+    makeCurrent();
+    m_painter->retryPendingInput();
+    doneCurrent();
+}
+void
 XQGraph::mouseDoubleClickEvent ( QMouseEvent* e) {
 	e->accept();
 	if( !m_painter ) return;
@@ -140,10 +183,15 @@ XQGraph::wheelEvent ( QWheelEvent *e) {
 }
 void
 XQGraph::showEvent ( QShowEvent *) {
+	if(m_painter)
+		m_painter->setVisible(true);
 }
 void
 XQGraph::hideEvent ( QHideEvent * ) {
 	m_conDialog.reset();
+	//also when minimized.
+	if(m_painter)
+		m_painter->setVisible(false);
 }
 //! openGL stuff
 void
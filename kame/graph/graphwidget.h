@@ -40,6 +40,16 @@ public:
 	virtual ~XQGraph();
 	//! register XGraph instance just after creating
 	void setGraph(const shared_ptr<XGraph> &);
+	//! Paints the latest graph into the framebuffer (object) of the widget, without showing it on screen.
+	//! The frame built for the updates so far is awaited, and the GL commands are finished.
+	//! The pixels are not read back.
+	//! \param timeout [s] for the frame.
+	//! \return false if no GL context is available.
+	bool renderFrame(double timeout = 10.0);
+	//! Renders the latest graph as renderFrame() does, and grabs the image.
+	//! \return a null image on failure.
+	QImage renderOffscreen(double timeout = 10.0);
+	XQGraphPainter *painter() const {return m_painter.get();}
 
 protected:
     virtual void mousePressEvent ( QMouseEvent*) override;
@@ -56,6 +66,9 @@ protected:
     //! openGL stuff
     virtual void initializeGL() override;
     virtual void resizeGL ( int width, int height ) override;
+private slots:
+    //! Retries the input deferred by XQGraphPainter.
+    void processPendingInput();
 private:  
 	friend class XQGraphPainter;
 	shared_ptr<XGraph> m_graph;
@@ -0,0 +1,165 @@
+/***************************************************************************
+		Copyright (C) 2002-2015 Kentaro Kitagawa
+		                   kitagawa@phys.s.u-tokyo.ac.jp
+
+		This program is free software; you can redistribute it and/or
+		modify it under the terms of the GNU Library General Public
+		License as published by the Free Software Foundation; either
+		version 2 of the License, or (at your option) any later version.
+
+		You should have received a copy of the GNU Library General
+		Public License and a list of authors along with this program;
+		see the files COPYING and AUTHORS.
+***************************************************************************/
+#ifndef PICKTREE_H_
+#define PICKTREE_H_
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+//! k-d tree over points in graph coordinates, to find the point nearest to a line for XPlot::findPoint().
+class PickTree {
+public:
+    //! Max. # of points in a leaf.
+    enum {LEAF_SIZE = 16};
+    struct Entry {
+        float pos[3];
+        uint64_t index; //!< of the point, e.g., in the series.
+    };
+    //! The point nearest to a line, e.g., a ray under the pointer, within a distance.
+    struct LineQuery {
+        //! \param p0,p1 two points on the line, or the same point.
+        //! \param width maximum distance from the line.
+        //! \param min_index points having smaller indices are ignored, e.g., dropped from the series.
+        LineQuery(const float p0[3], const float p1[3], float width, uint64_t min_index = 0) :
+            p{p0[0], p0[1], p0[2]}, dir{(double)p1[0] - p0[0], (double)p1[1] - p0[1], (double)p1[2] - p0[2]},
+            dir2(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]),
+            best((double)width * width), minIndex(min_index) {}
+        //! Keeps the point if nearer, or as near with a smaller index.
+        void test(const float pos[3], uint64_t index) {
+            if(index < minIndex)
+                return;
+            double a[3] = {pos[0] - p[0], pos[1] - p[1], pos[2] - p[2]};
+            double d2 = a[0] * a[0] + a[1] * a[1] + a[2] * a[2];
+            if(dir2 > 0.0) {
+                double ad = a[0] * dir[0] + a[1] * dir[1] + a[2] * dir[2];
+                d2 -= ad * ad / dir2;
+            }
+            if((d2 < best) || ((d2 == best) && (index < found))) {
+                best = d2;
+                found = index;
+            }
+        }
+        bool isFound() const {return found != std::numeric_limits<uint64_t>::max();}
+        const double p[3], dir[3], dir2;
+        double best; //!< squared distance to the point found, or the squared width.
+        uint64_t found = std::numeric_limits<uint64_t>::max();
+        const uint64_t minIndex;
+    };
+
+    size_t size() const {return m_entries.size();}
+    void clear() {
+        m_entries.clear();
+        m_nodes.clear();
+        m_depth = 0;
+    }
+    //! Builds the tree over \a entries, reusing the storage.
+    void build(std::vector<Entry> &&entries) {
+        m_entries.swap(entries);
+        entries.clear();
+        //axes along which the points spread, e.g., Z is skipped for 2D plots.
+        m_splitAxes.clear();
+        for(int d = 0; d < 3; ++d) {
+            auto minmax = std::minmax_element(m_entries.begin(), m_entries.end(),
+                [d](const Entry &a, const Entry &b){return a.pos[d] < b.pos[d];});
+            if((minmax.first != m_entries.end()) && (minmax.first->pos[d] < minmax.second->pos[d]))
+                m_splitAxes.push_back(d);
+        }
+        if(m_splitAxes.empty())
+            m_splitAxes.push_back(0);
+        m_depth = 0;
+        while((m_entries.size() >> m_depth) > LEAF_SIZE)
+            m_depth++;
+        m_nodes.resize((2u << m_depth) - 1);
+        if(m_entries.size())
+            buildNode(0, 0, 0, m_entries.size());
+    }
+    //! Tests the points near the line, skipping the boxes farther than the nearest point so far.
+    void search(LineQuery &q) const {
+        if(m_entries.size())
+            searchNode(q, 0, 0, 0, m_entries.size());
+    }
+private:
+    struct Node {
+        float lo[3], hi[3]; //!< bounding box of the entries.
+    };
+    unsigned int m_depth = 0; //!< of the leaves.
+    std::vector<int> m_splitAxes; //!< the children at level l are split along m_splitAxes[l % size].
+    //! Entries partitioned as the leaves of the tree, from left to right.
+    std::vector<Entry> m_entries;
+    //! Complete binary tree, the children of node k are 2k + 1 and 2k + 2,
+    //! which cover the halves of the entries of node k.
+    std::vector<Node> m_nodes;
+
+    void buildNode(unsigned int k, unsigned int level, size_t begin, size_t end) {
+        Node &node(m_nodes[k]);
+        if(level == m_depth) {
+            for(int d = 0; d < 3; ++d) {
+                node.lo[d] = std::numeric_limits<float>::max();
+                node.hi[d] = std::numeric_limits<float>::lowest();
+            }
+            for(size_t i = begin; i < end; ++i) {
+                for(int d = 0; d < 3; ++d) {
+                    node.lo[d] = std::min(node.lo[d], m_entries[i].pos[d]);
+                    node.hi[d] = std::max(node.hi[d], m_entries[i].pos[d]);
+                }
+            }
+            return;
+        }
+        //splits at the median, along the axes in turn.
+        int axis = m_splitAxes[level % m_splitAxes.size()];
+        size_t mid = begin + (end - begin) / 2;
+        std::nth_element(m_entries.begin() + begin, m_entries.begin() + mid, m_entries.begin() + end,
+            [axis](const Entry &a, const Entry &b){return a.pos[axis] < b.pos[axis];});
+        buildNode(2 * k + 1, level + 1, begin, mid);
+        buildNode(2 * k + 2, level + 1, mid, end);
+        const Node &left(m_nodes[2 * k + 1]), &right(m_nodes[2 * k + 2]);
+        for(int d = 0; d < 3; ++d) {
+            node.lo[d] = std::min(left.lo[d], right.lo[d]);
+            node.hi[d] = std::max(left.hi[d], right.hi[d]);
+        }
+    }
+    void searchNode(LineQuery &q, unsigned int k, unsigned int level, size_t begin, size_t end) const {
+        const Node &node(m_nodes[k]);
+        //Does the line hit the box expanded by the distance?
+        double r = std::sqrt(q.best);
+        double tmin = -std::numeric_limits<double>::infinity(), tmax = -tmin;
+        for(int d = 0; d < 3; ++d) {
+            double lo = node.lo[d] - r, hi = node.hi[d] + r;
+            if(q.dir[d] == 0.0) {
+                if((q.p[d] < lo) || (q.p[d] > hi))
+                    return;
+                continue;
+            }
+            double t1 = (lo - q.p[d]) / q.dir[d], t2 = (hi - q.p[d]) / q.dir[d];
+            tmin = std::max(tmin, std::min(t1, t2));
+            tmax = std::min(tmax, std::max(t1, t2));
+            if(tmin > tmax)
+                return;
+        }
+        if(level == m_depth) {
+            for(size_t i = begin; i < end; ++i)
+                q.test(m_entries[i].pos, m_entries[i].index);
+            return;
+        }
+        size_t mid = begin + (end - begin) / 2;
+        searchNode(q, 2 * k + 1, level + 1, begin, mid);
+        searchNode(q, 2 * k + 2, level + 1, mid, end);
+    }
+};
+
+#endif /*PICKTREE_H_*/
@@ -0,0 +1,257 @@
+/***************************************************************************
+		Copyright (C) 2002-2015 Kentaro Kitagawa
+		                   kitagawa@phys.s.u-tokyo.ac.jp
+
+		This program is free software; you can redistribute it and/or
+		modify it under the terms of the GNU Library General Public
+		License as published by the Free Software Foundation; either
+		version 2 of the License, or (at your option) any later version.
+
+		You should have received a copy of the GNU Library General
+		Public License and a list of authors along with this program;
+		see the files COPYING and AUTHORS.
+***************************************************************************/
+#ifndef PLOTKERNELS_H_
+#define PLOTKERNELS_H_
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+    #define PLOTKERNELS_SSE2
+    #include <emmintrin.h>
+#endif
+
+//! Batched coordinate transforms for XPlot::drawPlot(), over points in the structure-of-arrays layout.
+//! Each loop runs over whole arrays without branching on the axis settings.
+//! Loops on floats are written in SSE2 where available, otherwise left to the compiler.
+namespace PlotKernels {
+
+//! # of points transformed at once, to keep the source in the cache over the four coordinates.
+enum {BLOCK_SIZE = 256};
+
+//! Mapping from values to positions on an axis, as XAxis::valToAxis().
+struct AxisMap {
+    enum class Scale {Linear, Log, Constant};
+    Scale scale = Scale::Constant;
+    double offset = 0.0; //!< min., or log(min.) for a log scale.
+    double factor = 0.0; //!< 1 / (max. - min.), or 1 / log(max. / min.).
+    //! Position for nonpositive values in a log scale, or for all the values if Constant.
+    float invalidPos = -1.0f;
+
+    static AxisMap linear(double min, double max) {
+        AxisMap m;
+        if(max <= min)
+            return m;
+        m.scale = Scale::Linear;
+        m.offset = min;
+        m.factor = 1.0 / (max - min);
+        return m;
+    }
+    static AxisMap log(double min, double max) {
+        AxisMap m;
+        m.invalidPos = std::numeric_limits<float>::lowest();
+        if((min <= 0) || (max <= min))
+            return m;
+        m.scale = Scale::Log;
+        m.offset = std::log(min);
+        m.factor = 1.0 / std::log(max / min);
+        return m;
+    }
+    static AxisMap identity() {return linear(0.0, 1.0);}
+    static AxisMap constant(float pos) {
+        AxisMap m;
+        m.invalidPos = pos;
+        return m;
+    }
+};
+
+//! Points as separate arrays of coordinates.
+struct Arrays {
+    std::vector<float> x, y, z, w;
+    void resize(size_t n) {
+        x.resize(n); y.resize(n); z.resize(n); w.resize(n);
+    }
+};
+
+//! Bits of an outcode for Cohen-Sutherland clipping against the unit cube.
+//! NaN sets both bits of the coordinate.
+enum : uint8_t {
+    OUT_X_LOW = 1, OUT_X_HIGH = 2, OUT_Y_LOW = 4, OUT_Y_HIGH = 8, OUT_Z_LOW = 16, OUT_Z_HIGH = 32
+};
+//! Classes of a segment by the trivial tests.
+enum : uint8_t {
+    SEGMENT_INSIDE = 0, //!< both ends in the cube.
+    SEGMENT_OUTSIDE = 1, //!< both ends beyond the same face.
+    SEGMENT_CROSSING = 2 //!< needs clipping.
+};
+
+//! Working arrays for a batch of points.
+struct Batch {
+    Arrays graph; //!< positions on the axes.
+    Arrays screen;
+    std::vector<uint8_t> outcodes;
+    std::vector<uint8_t> segments; //!< \a segments[i] for points \a i and \a i + 1.
+    std::vector<uint32_t> colors;
+    void resize(size_t n) {
+        graph.resize(n);
+        screen.resize(n);
+        outcodes.resize(n);
+        segments.resize(n ? n - 1 : 0);
+        colors.resize(n);
+    }
+};
+
+//! Positions of \a get(pts[i]) on an axis, specialized for the scale.
+template <AxisMap::Scale SCALE, class P, class GET>
+inline void valToAxis(const P *pts, size_t n, GET get, const AxisMap &map, float *pos) {
+    const double offset = map.offset, factor = map.factor;
+    const float invalid = map.invalidPos;
+    for(size_t i = 0; i < n; ++i) {
+        double x = get(pts[i]);
+        if(SCALE == AxisMap::Scale::Log)
+            pos[i] = (x > 0) ? (float)((std::log(x) - offset) * factor) : invalid;
+        else
+            pos[i] = (float)((x - offset) * factor);
+    }
+}
+//! Selects the loop once for the whole array.
+template <class P, class GET>
+inline void valToAxis(const P *pts, size_t n, GET get, const AxisMap &map, float *pos) {
+    switch(map.scale) {
+    case AxisMap::Scale::Linear:
+        valToAxis<AxisMap::Scale::Linear>(pts, n, get, map, pos);
+        break;
+    case AxisMap::Scale::Log:
+        valToAxis<AxisMap::Scale::Log>(pts, n, get, map, pos);
+        break;
+    case AxisMap::Scale::Constant:
+        std::fill(pos, pos + n, map.invalidPos);
+        break;
+    }
+}
+
+//! Positions of points having x, y, z and w, into \a g from the index \a offset.
+template <class P>
+inline void valToGraph(const P *pts, size_t n, const AxisMap maps[4], Arrays &g, size_t offset) {
+    for(size_t i = 0; i < n; i += BLOCK_SIZE) {
+        const P *p = pts + i;
+        size_t len = std::min(n - i, (size_t)BLOCK_SIZE), k = offset + i;
+        valToAxis(p, len, [](const P &pt){return pt.x;}, maps[0], &g.x[k]);
+        valToAxis(p, len, [](const P &pt){return pt.y;}, maps[1], &g.y[k]);
+        valToAxis(p, len, [](const P &pt){return pt.z;}, maps[2], &g.z[k]);
+        valToAxis(p, len, [](const P &pt){return pt.w;}, maps[3], &g.w[k]);
+    }
+}
+
+inline void axisToScreen(const float *pos, size_t n, float scr0, float len, float *scr) {
+    size_t i = 0;
+#ifdef PLOTKERNELS_SSE2
+    const __m128 o = _mm_set1_ps(scr0), l = _mm_set1_ps(len);
+    for(; i + 4 <= n; i += 4)
+        _mm_storeu_ps(scr + i, _mm_add_ps(o, _mm_mul_ps(l, _mm_loadu_ps(pos + i))));
+#endif
+    for(; i < n; ++i)
+        scr[i] = scr0 + len * pos[i];
+}
+inline void clamp01(const float *src, size_t n, float *dst) {
+    size_t i = 0;
+#ifdef PLOTKERNELS_SSE2
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+    for(; i + 4 <= n; i += 4)
+        _mm_storeu_ps(dst + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i), zero), one));
+#endif
+    for(; i < n; ++i)
+        dst[i] = std::min(std::max(src[i], 0.0f), 1.0f);
+}
+
+inline void outcodes(const float *x, const float *y, const float *z, size_t n, uint8_t *codes) {
+    size_t i = 0;
+#ifdef PLOTKERNELS_SSE2
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+    auto bits = [&](const float *c, int low, int high) {
+        __m128 v = _mm_loadu_ps(c);
+        //comparisons with NaN hold.
+        return _mm_or_si128(
+            _mm_and_si128(_mm_castps_si128(_mm_cmpnge_ps(v, zero)), _mm_set1_epi32(low)),
+            _mm_and_si128(_mm_castps_si128(_mm_cmpnle_ps(v, one)), _mm_set1_epi32(high)));
+    };
+    for(; i + 4 <= n; i += 4) {
+        __m128i c = _mm_or_si128(_mm_or_si128(bits(x + i, OUT_X_LOW, OUT_X_HIGH), bits(y + i, OUT_Y_LOW, OUT_Y_HIGH)),
+            bits(z + i, OUT_Z_LOW, OUT_Z_HIGH));
+        c = _mm_packs_epi32(c, c);
+        int32_t c4 = _mm_cvtsi128_si32(_mm_packus_epi16(c, c));
+        std::memcpy(codes + i, &c4, 4);
+    }
+#endif
+    for(; i < n; ++i) {
+        codes[i] = (uint8_t)(( !(x[i] >= 0.0f) ? OUT_X_LOW : 0) | ( !(x[i] <= 1.0f) ? OUT_X_HIGH : 0) |
+            ( !(y[i] >= 0.0f) ? OUT_Y_LOW : 0) | ( !(y[i] <= 1.0f) ? OUT_Y_HIGH : 0) |
+            ( !(z[i] >= 0.0f) ? OUT_Z_LOW : 0) | ( !(z[i] <= 1.0f) ? OUT_Z_HIGH : 0));
+    }
+}
+//! Trivial accept/reject tests of the segments between consecutive points.
+inline void classifySegments(const uint8_t *codes, size_t n, uint8_t *segments) {
+    for(size_t i = 0; i + 1 < n; ++i) {
+        uint8_t c1 = codes[i], c2 = codes[i + 1];
+        segments[i] = (c1 | c2) ? ((c1 & c2) ? SEGMENT_OUTSIDE : SEGMENT_CROSSING) : SEGMENT_INSIDE;
+    }
+}
+
+//! Colors in 0xffRRGGBB between \a color0 at t = 0 and \a color1 at t = 1, as XPlot::blendColor().
+//! \a t is clamped to [0, 1].
+inline void blendColors(const float *t, size_t n, uint32_t color0, uint32_t color1, uint32_t *colors) {
+    const float r0 = (color0 >> 16) & 0xffu, g0 = (color0 >> 8) & 0xffu, b0 = color0 & 0xffu;
+    const float r1 = (color1 >> 16) & 0xffu, g1 = (color1 >> 8) & 0xffu, b1 = color1 & 0xffu;
+    size_t i = 0;
+#ifdef PLOTKERNELS_SSE2
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+    auto channel = [&](__m128 s, __m128 s0, float c0, float c1) {
+        //rounded to even, as lrintf().
+        return _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(c1), s), _mm_mul_ps(_mm_set1_ps(c0), s0)));
+    };
+    for(; i + 4 <= n; i += 4) {
+        __m128 s = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(t + i), zero), one);
+        __m128 s0 = _mm_sub_ps(one, s);
+        __m128i c = _mm_or_si128(_mm_set1_epi32((int)0xff000000u),
+            _mm_or_si128(_mm_slli_epi32(channel(s, s0, r0, r1), 16),
+            _mm_or_si128(_mm_slli_epi32(channel(s, s0, g0, g1), 8), channel(s, s0, b0, b1))));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(colors + i), c);
+    }
+#endif
+    for(; i < n; ++i) {
+        float s = std::min(std::max(t[i], 0.0f), 1.0f);
+        uint32_t r = (uint32_t)lrintf(r1 * s + r0 * (1.0f - s));
+        uint32_t g = (uint32_t)lrintf(g1 * s + g0 * (1.0f - s));
+        uint32_t b = (uint32_t)lrintf(b1 * s + b0 * (1.0f - s));
+        colors[i] = 0xff000000u | (r << 16) | (g << 8) | b;
+    }
+}
+
+//! Fills screen coordinates, outcodes, segments and colors from \a b.graph.
+//! \param scr0 screen position of the origin of the axes.
+//! \param len screen lengths of the axes.
+//! \param colort values for the color blending, or null for \a color0 over all.
+inline void graphToScreen(Batch &b, size_t n, const float scr0[3], const float len[3],
+    const float *colort, uint32_t color0, uint32_t color1) {
+    if( !n) return;
+    axisToScreen( &b.graph.x[0], n, scr0[0], len[0], &b.screen.x[0]);
+    axisToScreen( &b.graph.y[0], n, scr0[1], len[1], &b.screen.y[0]);
+    axisToScreen( &b.graph.z[0], n, scr0[2], len[2], &b.screen.z[0]);
+    clamp01( &b.graph.w[0], n, &b.screen.w[0]);
+    outcodes( &b.graph.x[0], &b.graph.y[0], &b.graph.z[0], n, &b.outcodes[0]);
+    classifySegments( &b.outcodes[0], n, b.segments.data());
+    if(colort)
+        blendColors(colort, n, color0, color1, &b.colors[0]);
+    else
+        std::fill(b.colors.begin(), b.colors.begin() + n, color0);
+}
+
+} //namespace PlotKernels
+
+#endif /*PLOTKERNELS_H_*/
@@ -38,7 +38,7 @@ XWaveNGraph::XWaveNGraph(const char *name, bool runtime, XQGraph *graphwidget,
 		XStringNode> ("FileName", true)) {
 	graphwidget->setGraph(m_graph);
     m_conFilename = xqcon_create<XFilePathConnector> (m_filename, ed, btn,
-		"Data files (*.dat);;All files (*.*)", true);
+		"Data files (*.dat);;Binary data files (*.bin);;All files (*.*)", true);
 	m_conDump = xqcon_create<XQButtonConnector> (m_dump, btndump);
 
     iterate_commit([=](Transaction &tr){
@@ -75,8 +75,15 @@ XWaveNGraph::Payload::XPlotWrapper::snapshot(const Snapshot &shot_graph) {
     //Snapshot only for the parent. Otherwise, transaction of graph will fail.
     SingleSnapshot<XWaveNGraph> shot_waves( *waves);
     int rowcnt = shot_waves->rowCount();
+    std::vector<shared_ptr<ColumnBase>> cols_snapped;
+    for(int colidx: {m_colx, m_coly1, m_coly2, m_colz, m_colweight})
+        cols_snapped.push_back((colidx >= 0) ? shot_waves->m_cols[colidx] : nullptr);
+    if(m_ptsSnappedSerial && (rowcnt == (int)m_rowCountSnapped) && (cols_snapped == m_colsSnapped))
+        return; //unchanged.
+    m_colsSnapped = std::move(cols_snapped);
+    m_rowCountSnapped = rowcnt;
+    m_ptsSnappedSerial++;
     m_ptsSnapped.clear();
-    m_ptsSnapped.reserve(rowcnt);
     if( !rowcnt)
         return;
 
@@ -96,20 +103,24 @@ XWaveNGraph::Payload::XPlotWrapper::snapshot(const Snapshot &shot_graph) {
     prepare_column_data(m_colz, cols[2], pcolz);
     prepare_column_data(m_colweight, cols[3], pcolweight);
 
+    //filled at once, not point by point.
+    std::vector<XGraph::ValPoint> pts;
+    pts.reserve(rowcnt);
     for(int i = 0; i < rowcnt; ++i) {
         double z = 0.0;
         if(pcolz)
             z = pcolz[i];
         if(pcolweight) {
             if(pcolweight[i] > 0) {
-                m_ptsSnapped.push_back(XGraph::ValPoint(pcolx[i],
+                pts.push_back(XGraph::ValPoint(pcolx[i],
                     pcoly[i], z, pcolweight[i]));
             }
         }
         else {
-            m_ptsSnapped.push_back(XGraph::ValPoint(pcolx[i], pcoly[i], z));
+            pts.push_back(XGraph::ValPoint(pcolx[i], pcoly[i], z));
         }
     }
+    m_ptsSnapped.assign(pts.data(), pts.size());
 }
 
 void
@@ -259,9 +270,11 @@ XWaveNGraph::onFilenameChanged(const Snapshot &shot, XValueNodeBase *) {
 		if(m_stream.is_open())
 			m_stream.close();
 		m_stream.clear();
+		QString filename(shot[ *filename()].to_str().c_str());
+		m_isBinary = filename.endsWith(".bin", Qt::CaseInsensitive);
 		m_stream.open(
-            (const char*)QString(shot[ *filename()].to_str().c_str()).toLocal8Bit().data(),
-			OFSMODE);
+            (const char*)filename.toLocal8Bit().data(),
+			m_isBinary ? (OFSMODE | std::ios::binary) : OFSMODE);
 
 		iterate_commit([=](Transaction &tr){
 			if(m_stream.good()) {
@@ -296,6 +309,12 @@ XWaveNGraph::onDumpTouched(const Snapshot &, XTouchableNode *) {
         }
         Transactional::setCurrentPriorityMode(Priority::UI_DEFERRABLE);
 
+        if(m_isBinary) {
+            unsigned int written_rows = dumpBinary(shot);
+            gMessagePrint(formatString_tr(I18N_NOOP("Succesfully %d rows written into %s."), written_rows, shot[ *filename()].to_str().c_str()));
+            return;
+        }
+
         int rowcnt = shot[ *this].rowCount();
         int colcnt = shot[ *this].colCount();
 
@@ -333,6 +352,47 @@ XWaveNGraph::onDumpTouched(const Snapshot &, XTouchableNode *) {
         tr.mark(tr[ *this].onIconChanged(), true);
     });
 }
+unsigned int
+XWaveNGraph::dumpBinary(const Snapshot &shot) {
+    auto &p(shot[ *this]);
+    unsigned int colcnt = p.colCount();
+    std::vector<unsigned int> rows;
+    if(p.m_colw >= 0) {
+        auto &colw(p.m_cols[p.m_colw]);
+        rows.reserve(p.rowCount());
+        for(unsigned int i = 0; i < p.rowCount(); i++) {
+            if(colw->moreThanZero(i))
+                rows.push_back(i);
+        }
+    }
+    uint64_t written_rows = (p.m_colw >= 0) ? rows.size() : p.rowCount();
+
+    std::string header("KAMEWAVB");
+    auto put = [&header](uint64_t x, unsigned int bytes) {
+        for(unsigned int k = 0; k < bytes; k++)
+            header.push_back((char)(x >> (8 * k)));
+    };
+    XTime time(XTime::now());
+    put(1, 4); //version
+    put(colcnt, 4);
+    put(written_rows, 8);
+    put((int64_t)time.sec(), 8);
+    put((int32_t)time.usec(), 4);
+    for(unsigned int j = 0; j < colcnt; j++) {
+        auto &col(p.m_cols[j]);
+        header.push_back(col->binaryKind());
+        put(col->binaryWidth(), 1);
+        put(col->precision, 2);
+        put(p.labels()[j].size(), 4);
+        header += p.labels()[j];
+    }
+    m_stream.write(header.data(), header.size());
+    for(unsigned int j = 0; j < colcnt; j++)
+        p.m_cols[j]->toBinary(m_stream, (p.m_colw >= 0) ? &rows : nullptr, p.rowCount());
+    m_stream.flush();
+    return written_rows;
+}
+
 void XWaveNGraph::drawGraph(Transaction &tr) {
 	const Snapshot &shot(tr);
     if(shot[ *this].m_colw >= 0) {
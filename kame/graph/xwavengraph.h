@@ -21,6 +21,8 @@
 #include <vector>
 #include "graph.h"
 #include <fstream>
+#include <type_traits>
+#include <algorithm>
 
 class XQGraph;
 class QLineEdit;
@@ -31,7 +33,12 @@ class XXYPlot;
 class Ui_FrmGraphNURL;
 typedef QForm<QWidget, Ui_FrmGraphNURL> FrmGraphNURL;
 
-//! Graph widget with internal data sets. The data can be saved as a text file.
+//! Graph widget with internal data sets. The data can be saved as a text file,
+//! or as a binary file if the file name ends with ".bin".
+//! Each dump appends a block to the binary file, all in little endian:
+//! "KAMEWAVB", uint32 version, uint32 # of columns, uint64 # of rows, int64 sec and int32 usec of the time,
+//! then for each column, char kind ('f', 'i' or 'u'), uint8 bytes per value, uint16 precision,
+//! uint32 length and UTF-8 label, followed by the columns one by one, each in a contiguous array.
 //! \sa XQGraph, XGraph
 
 class DECLSPEC_KAME XWaveNGraph: public XNode {
@@ -87,6 +94,12 @@ public:
             virtual bool moreThanZero(size_t i) const = 0;
             virtual const XGraph::VFloat *fillOrPointToGraphPoints(std::vector<XGraph::VFloat>& buf) const = 0;
             virtual void toOFStream(std::fstream &s, size_t idx) = 0;
+            //! 'f' for floating point, 'i' for signed and 'u' for unsigned integers.
+            virtual char binaryKind() const = 0;
+            virtual unsigned int binaryWidth() const = 0;
+            //! Writes the values at \a rows, or the first \a rowcnt values if \a rows is null, in little endian.
+            //! Values missing in the column are written as zero, to keep the block as large as the header says.
+            virtual void toBinary(std::ostream &s, const std::vector<unsigned int> *rows, size_t rowcnt) const = 0;
             unsigned int precision;
             template <typename VALUE>
             static const XGraph::VFloat *fillOrPointToGraphPointsBasic(std::vector<XGraph::VFloat>& buf,
@@ -109,7 +122,7 @@ public:
                 return *std::max_element(vector.cbegin(), vector.cend());
             }
             virtual bool moreThanZero(size_t i) const {
-                return vector[i] > 0;
+                return (i < vector.size()) && (vector[i] > 0);
             }
             virtual const XGraph::VFloat *fillOrPointToGraphPoints(std::vector<XGraph::VFloat>& buf) const {
                 return fillOrPointToGraphPointsBasic(buf, vector);
@@ -117,6 +130,38 @@ public:
             virtual void toOFStream(std::fstream &s, size_t idx) {
                 s << vector[idx];
             }
+            virtual char binaryKind() const {
+                return std::is_floating_point<VALUE>::value ? 'f' :
+                    (std::is_signed<VALUE>::value ? 'i' : 'u');
+            }
+            virtual unsigned int binaryWidth() const {return sizeof(VALUE);}
+            virtual void toBinary(std::ostream &s, const std::vector<unsigned int> *rows, size_t rowcnt) const {
+                size_t n = std::min(rowcnt, vector.size());
+#if !defined __BYTE_ORDER__ || (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+                if( !rows && (n == rowcnt)) {
+                    //straight from the column.
+                    s.write(reinterpret_cast<const char*>(vector.data()), n * sizeof(VALUE));
+                    return;
+                }
+#endif
+                std::vector<VALUE> buf;
+                if(rows) {
+                    buf.reserve(rows->size());
+                    for(auto i: *rows)
+                        buf.push_back((i < vector.size()) ? vector[i] : VALUE());
+                }
+                else {
+                    buf.assign(vector.begin(), vector.begin() + n);
+                    buf.resize(rowcnt);
+                }
+#if defined __BYTE_ORDER__ && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+                for(auto &x: buf) {
+                    auto c = reinterpret_cast<char*>( &x);
+                    std::reverse(c, c + sizeof(VALUE));
+                }
+#endif
+                s.write(reinterpret_cast<const char*>(buf.data()), buf.size() * sizeof(VALUE));
+            }
             std::vector<VALUE> vector;
         };
         std::vector<shared_ptr<ColumnBase>> m_cols;
@@ -125,9 +170,14 @@ public:
             XPlotWrapper(const char *name, bool runtime, Transaction &tr_graph, const shared_ptr<XGraph> &graph);
             virtual void clearAllPoints(Transaction &) override {}
             //! Takes a snap-shot all points for rendering
+            //! The points are kept with the serial, unless the columns or the row count have changed,
+            //! for the vertices cached in XPlot::drawPlot().
             virtual void snapshot(const Snapshot &shot) override;
             weak_ptr<XWaveNGraph> m_parent;
             int m_colx, m_coly1, m_coly2, m_colweight, m_colz;
+            //! Of the points snapped. Columns are replaced by setColumn(), not modified.
+            std::vector<shared_ptr<ColumnBase>> m_colsSnapped;
+            size_t m_rowCountSnapped = 0;
         };
         std::vector<shared_ptr<XPlotWrapper>> m_plots;
 		shared_ptr<XAxis> m_axisx, m_axisy, m_axisy2, m_axisw, m_axisz;
@@ -148,11 +198,15 @@ private:
 	void onDumpTouched(const Snapshot &shot, XTouchableNode *);
 	void onFilenameChanged(const Snapshot &shot, XValueNodeBase *);
 	void onIconChanged(const Snapshot &shot, bool );
+	//! Appends a block of the columns to the binary file.
+	//! \return # of rows written.
+	unsigned int dumpBinary(const Snapshot &shot);
 
 	xqcon_ptr m_conFilename, m_conDump;
 
     unique_ptr<XThread> m_threadDump;
 	std::fstream m_stream;
+	bool m_isBinary = false; //!< true if m_stream is a binary file.
 	XMutex m_filemutex;
 };
 
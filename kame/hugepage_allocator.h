@@ -0,0 +1,179 @@
+/***************************************************************************
+		Copyright (C) 2002-2015 Kentaro Kitagawa
+		                   kitagawa@phys.s.u-tokyo.ac.jp
+
+		This program is free software; you can redistribute it and/or
+		modify it under the terms of the GNU Library General Public
+		License as published by the Free Software Foundation; either
+		version 2 of the License, or (at your option) any later version.
+
+		You should have received a copy of the GNU Library General
+		Public License and a list of authors along with this program;
+		see the files COPYING and AUTHORS.
+***************************************************************************/
+#ifndef HUGEPAGE_ALLOCATOR_H_
+#define HUGEPAGE_ALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <limits>
+#include <type_traits>
+
+#if defined __WIN32__ || defined WINDOWS || defined _WIN32
+    #include "support.h" //for mlock().
+#else
+    #include <sys/mman.h>
+#endif
+#if defined __linux__
+    #include <sys/syscall.h>
+    #include <unistd.h>
+    #define HUGEPAGE_USE_MMAP
+#endif
+
+//! Large buffers for acquisition, e.g. accumulation banks and ring buffers.
+//! Backed by huge pages (reserved ones, or transparent ones as a fallback) to reduce TLB misses,
+//! placed on a given NUMA node, and pre-faulted so that no page fault occurs during acquisition.
+//! Small requests and unsupported platforms fall back to the heap.
+struct hugepage_buffer {
+    enum : size_t {HUGE_PAGE_SIZE = 2u * 1024u * 1024u, SMALL_PAGE_SIZE = 4096u,
+        MIN_SIZE = HUGE_PAGE_SIZE / 2}; //!< smaller ones are taken from the heap.
+    enum class Backing {Heap, HugeTLB, TransparentHugePage};
+
+    //! \return NUMA node of the CPU running the calling thread, or -1 if unknown.
+    static int currentNUMANode() noexcept {
+#if defined HUGEPAGE_USE_MMAP && defined SYS_getcpu
+        unsigned int cpu, node;
+        if(syscall(SYS_getcpu, &cpu, &node, nullptr) == 0)
+            return node;
+#endif
+        return -1;
+    }
+    //! \param numa_node preferred node, -1 for the node of the calling thread.
+    //! \param lock locks pages in memory.
+    //! \return null if failed.
+    static void *allocate(size_t bytes, int numa_node, bool lock, Backing *backing = nullptr) noexcept {
+#if defined HUGEPAGE_USE_MMAP
+        if(bytes >= MIN_SIZE) {
+            size_t len = mappedSize(bytes);
+            Backing b = Backing::HugeTLB;
+            void *p = mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if(p == MAP_FAILED) {
+                //No reserved huge page. Aligns a normal mapping so that THP can back it entirely.
+                b = Backing::TransparentHugePage;
+                char *q = static_cast<char*>(mmap(nullptr, len + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+                if(q == MAP_FAILED)
+                    return nullptr;
+                char *aligned = reinterpret_cast<char*>(
+                    (reinterpret_cast<uintptr_t>(q) + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE);
+                if(aligned > q)
+                    munmap(q, aligned - q);
+                munmap(aligned + len, q + HUGE_PAGE_SIZE - aligned);
+                p = aligned;
+    #if defined MADV_HUGEPAGE
+                madvise(p, len, MADV_HUGEPAGE);
+    #endif
+            }
+            bindToNUMANode(p, len, numa_node);
+            //pre-faults from here, after the memory policy has been set.
+            for(size_t off = 0; off < len; off += SMALL_PAGE_SIZE)
+                static_cast<volatile char*>(p)[off] = 0;
+            if(lock)
+                mlock(p, len);
+            if(backing)
+                *backing = b;
+            return p;
+        }
+#endif
+        if(backing)
+            *backing = Backing::Heap;
+        void *p = operator new(bytes, std::nothrow);
+        if(p && lock)
+            mlock(p, bytes);
+        return p;
+    }
+    //! \param bytes the same as in allocate().
+    static void deallocate(void *p, size_t bytes) noexcept {
+#if defined HUGEPAGE_USE_MMAP
+        if(bytes >= MIN_SIZE) {
+            munmap(p, mappedSize(bytes));
+            return;
+        }
+#endif
+        operator delete(p);
+    }
+private:
+    static size_t mappedSize(size_t bytes) noexcept {
+        return (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    }
+    static void bindToNUMANode(void *p, size_t len, int numa_node) noexcept {
+#if defined HUGEPAGE_USE_MMAP && defined SYS_mbind
+        if(numa_node < 0)
+            numa_node = currentNUMANode();
+        constexpr int bits = std::numeric_limits<unsigned long>::digits;
+        unsigned long mask[256 / bits] = {};
+        if((numa_node < 0) || (numa_node >= 256 - 1))
+            return;
+        mask[numa_node / bits] = 1uL << (numa_node % bits);
+        //MPOL_PREFERRED, falls back to other nodes rather than failing.
+        syscall(SYS_mbind, p, len, 1, mask, 256, 0);
+#endif
+    }
+};
+
+//! STL allocator on top of hugepage_buffer.
+//! e.g. std::vector<int32_t, hugepage_allocator<int32_t>> v(len, 0, hugepage_allocator<int32_t>(node));
+template <typename T>
+class hugepage_allocator {
+public:
+    typedef T value_type;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    //! the node moves with the storage.
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    template<class Y>
+    struct rebind {
+        typedef hugepage_allocator<Y> other;
+    };
+
+    //! \param numa_node -1 for the node of a thread allocating the storage.
+    //! \param lock locks pages in memory, typically isMemLockAvailable().
+    explicit hugepage_allocator(int numa_node = -1, bool lock = false) noexcept
+        : m_numaNode(numa_node), m_lock(lock) {}
+    template<typename Y> hugepage_allocator(const hugepage_allocator<Y> &x) noexcept
+        : m_numaNode(x.numaNode()), m_lock(x.isLocking()) {}
+
+    T *allocate(size_type num) {
+        void *p = hugepage_buffer::allocate(num * sizeof(T), m_numaNode, m_lock);
+        if( !p)
+            throw std::bad_alloc();
+        return static_cast<T*>(p);
+    }
+    void deallocate(T *p, size_type num) noexcept {
+        hugepage_buffer::deallocate(p, num * sizeof(T));
+    }
+
+    int numaNode() const noexcept {return m_numaNode;}
+    bool isLocking() const noexcept {return m_lock;}
+private:
+    int m_numaNode;
+    bool m_lock;
+};
+
+//! Storage can be released by any instance.
+template <class T1, class T2>
+bool operator==(const hugepage_allocator<T1>&, const hugepage_allocator<T2>&) noexcept {
+    return true;
+}
+
+template <class T1, class T2>
+bool operator!=(const hugepage_allocator<T1>&, const hugepage_allocator<T2>&) noexcept {
+    return false;
+}
+
+#endif /*HUGEPAGE_ALLOCATOR_H_*/
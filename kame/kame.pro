@@ -48,9 +48,13 @@ HEADERS += \
     driver/secondarydriverinterface.h \
     driver/softtrigger.h \
     graph/graph.h \
+    graph/chunkedring.h \
+    graph/plotkernels.h \
+    graph/picktree.h \
     graph/graphdialogconnector.h \
     graph/graphpainter.h \
     graph/graphwidget.h \
+    graph/graphbenchmark.h \
     graph/xwavengraph.h \
     analyzer/analyzer.h \
     analyzer/recorder.h \
@@ -74,6 +78,7 @@ HEADERS += \
     math/ar.h \
     math/cspline.h \
     math/fft.h \
+    math/echotrain.h \
     math/fir.h \
     math/freqestleastsquare.h \
     math/rand.h \
@@ -95,6 +100,7 @@ SOURCES += icons/icon.cpp \
     graph/graphpainter.cpp \
     graph/graphpaintergl.cpp \
     graph/graphwidget.cpp \
+    graph/graphbenchmark.cpp \
     graph/xwavengraph.cpp \
     graph/graph.cpp \
     thermometer/caltable.cpp \
@@ -105,6 +111,7 @@ SOURCES += icons/icon.cpp \
     math/ar.cpp \
     math/cspline.cpp \
     math/fft.cpp \
+    math/echotrain.cpp \
     math/fir.cpp \
     math/freqestleastsquare.cpp \
     math/rand.cpp \
@@ -245,6 +252,17 @@ unix {
     LIBS += -lltdl
 }
 
+#"make graphbench" renders graphs offscreen and prints the frame times, see graph/graphbenchmark.h.
+#e.g. qmake GRAPHBENCH_OPTIONS=plots=16,points=10000,color=z
+isEmpty(GRAPHBENCH_OPTIONS): GRAPHBENCH_OPTIONS = plots=4,points=100000,color=weight,frames=100,size=1024x768
+unix {
+    macx: GRAPHBENCH_EXECUTABLE = ./$${TARGET}.app/Contents/MacOS/$${TARGET}
+    else: GRAPHBENCH_EXECUTABLE = ./$${TARGET}
+    graphbench.commands = QT_QPA_PLATFORM=offscreen $${GRAPHBENCH_EXECUTABLE} --graphbench $${GRAPHBENCH_OPTIONS}
+    graphbench.depends = $(TARGET)
+    QMAKE_EXTRA_TARGETS += graphbench
+}
+
 #exports symbols from the executable for plugins.
 macx {
   QMAKE_LFLAGS += -all_load -dynamic
@@ -26,6 +26,7 @@
 #endif
 
 #include "kame.h"
+#include "graph/graphbenchmark.h"
 #include "icons/icon.h"
 #include "messagebox.h"
 #include <QFile>
@@ -93,6 +94,7 @@ int main(int argc, char *argv[]) {
 	options.add("nomlock", ki18n("never use mlock"));
     options.add("nodr");
 	options.add("moduledir <path>", ki18n("search modules in <path> instead of the standard dirs"));
+	options.add("graphbench <options>", ki18n("renders graphs offscreen and prints the frame times, e.g. plots=4,points=100000,color=weight,frames=100,size=1024x768"));
 	options.add("+[File]", ki18n("measurement file to open"));
 
 	KCmdLineArgs::addCmdLineOptions( options ); // Add our own options.
@@ -110,7 +112,11 @@ int main(int argc, char *argv[]) {
 		module_dir = KGlobal::dirs()->resourceDirs("lib");
 
     XString mesfile = args->count() ? args->arg(0) : "";
+    QString graph_benchmark = args->isSet("graphbench") ? args->getOption("graphbench") : QString();
     args->clear();
+
+    if(graph_benchmark.length())
+        return runGraphBenchmark(graph_benchmark);
 #else
     QApplication app(argc, argv);
     QApplication::setApplicationName("kame");
@@ -136,6 +142,11 @@ int main(int argc, char *argv[]) {
             QCoreApplication::translate("main", "path"));
     parser.addOption(moduleDirectoryOption);
 
+    QCommandLineOption graphBenchmarkOption("graphbench",
+            QCoreApplication::translate("main", "renders graphs offscreen and prints the frame times, e.g. plots=4,points=100000,color=weight,frames=100,size=1024x768"),
+            QCoreApplication::translate("main", "options"));
+    parser.addOption(graphBenchmarkOption);
+
     parser.process(app); //processes args.
 
     QStringList args = parser.positionalArguments();
@@ -148,6 +159,9 @@ int main(int argc, char *argv[]) {
     XString mesfile = args.count() ? args.at(0) : "";
     args.clear();
 
+    if(parser.isSet(graphBenchmarkOption))
+        return runGraphBenchmark(parser.value(graphBenchmarkOption));
+
 
     QTranslator qtTranslator;
     qtTranslator.load("qt_" + QLocale::system().name(), QLibraryInfo::location(QLibraryInfo::TranslationsPath));
@@ -115,6 +115,17 @@ YuleWalkerCousin<Context>::genSpectrum(const std::vector<std::complex<double> >&
 	}
 }
 
+template <class Context>
+void
+YuleWalkerCousin<Context>::stepCoefficients(std::vector<std::complex<double> > &a, unsigned int p, std::complex<double> k) {
+	for(unsigned int i = 0, j = p + 1; i <= j; i++, j--) {
+		std::complex<double> ai = a[i], aj = a[j];
+		a[i] = ai + k * std::conj(aj);
+		if(i != j)
+			a[j] = aj + k * std::conj(ai);
+	}
+}
+
 template class YuleWalkerCousin<ARContext>;
 template class YuleWalkerCousin<MEMBurgContext>;
 
@@ -126,27 +137,44 @@ MEMBurg::first(
 	context->eta.resize(t);
 	std::copy(memin.begin(), memin.end(), context->epsilon.begin());
 	std::copy(memin.begin(), memin.end(), context->eta.begin());
+	std::complex<double> x = 0.0;
+	double y = 0.0;
+	for(unsigned int i = 1; i < t; i++) {
+		x += memin[i] * std::conj(memin[i-1]);
+		y += std::norm(memin[i]) + std::norm(memin[i-1]);
+	}
+	context->cross = x;
+	context->power = y;
 }
 void
 MEMBurg::step(const shared_ptr<MEMBurgContext> &context) {
 	unsigned int t = context->t;
 	unsigned int p = context->p;
-	std::complex<double> x = 0.0, y = 0.0;
-	for(unsigned int i = p + 1; i < t; i++) {
-		x += context->epsilon[i] * std::conj(context->eta[i-1]);
-		y += std::norm(context->epsilon[i]) + std::norm(context->eta[i-1]);
-	}
-	std::complex<double> alpha = x / y;
-	alpha *= -2;
+	std::complex<double> alpha = -2.0 * context->cross / context->power;
+	//Updates the prediction errors in a single sweep,
+	//accumulating the sums for the next order at the same time.
+	std::complex<double> *eta = &context->eta[0], *epsilon = &context->epsilon[0];
+	double ar = std::real(alpha), ai = std::imag(alpha);
+	double xr = 0.0, xi = 0.0, y = 0.0;
+	double er_next = 0.0, ei_next = 0.0; //epsilon[i + 1] updated.
 	for(unsigned int i = t - 1; i >= p + 1; i--) {
-		context->eta[i] = context->eta[i-1] + std::conj(alpha) * context->epsilon[i];
-		context->epsilon[i] += alpha * context->eta[i-1];
-	}
-	std::vector<std::complex<double> > a_next(p + 2);
-	for(unsigned int i = 0; i < p + 2; i++) {
-		a_next[i] = context->a[i] + alpha * std::conj(context->a[p + 1 - i]);
+		double er = std::real(epsilon[i]), ei = std::imag(epsilon[i]);
+		double hr = std::real(eta[i-1]), hi = std::imag(eta[i-1]);
+		double hr_new = hr + ar * er + ai * ei, hi_new = hi + ar * ei - ai * er;
+		double er_new = er + ar * hr - ai * hi, ei_new = ei + ar * hi + ai * hr;
+		eta[i] = std::complex<double>(hr_new, hi_new);
+		epsilon[i] = std::complex<double>(er_new, ei_new);
+		if(i < t - 1) {
+			xr += er_next * hr_new + ei_next * hi_new;
+			xi += ei_next * hr_new - er_next * hi_new;
+			y += er_next * er_next + ei_next * ei_next + hr_new * hr_new + hi_new * hi_new;
+		}
+		er_next = er_new;
+		ei_next = ei_new;
 	}
-	std::copy(a_next.begin(), a_next.end(), context->a.begin());
+	context->cross = std::complex<double>(xr, xi);
+	context->power = y;
+	stepCoefficients(context->a, p, alpha);
 	context->sigma2 *= 1 - std::norm(alpha);
 }
 void
@@ -163,11 +191,7 @@ YuleWalkerAR::step(const shared_ptr<ARContext> &context) {
 	for(unsigned int i = 0; i < p + 1; i++) {
 		delta += context->a[i] * m_rx[p + 1 - i];
 	}
-	std::vector<std::complex<double> > a_next(p + 2);
-	for(unsigned int i = 0; i < p + 2; i++) {
-		a_next[i] = context->a[i] - delta/context->sigma2 * std::conj(context->a[p + 1 - i]);
-	}
-	std::copy(a_next.begin(), a_next.end(), context->a.begin());
+	stepCoefficients(context->a, p, -delta / context->sigma2);
 	context->sigma2 += - std::norm(delta) / context->sigma2;
 }
 
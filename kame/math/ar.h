@@ -37,6 +37,8 @@ protected:
 		const std::vector<std::complex<double> >& memin, const shared_ptr<Context> &context) = 0;
 	//! Steps Levinson recursion.
 	virtual void step(const shared_ptr<Context> &context) = 0;
+	//! a[i] += k * conj(a[p + 1 - i]) for 0 <= i <= p + 1, in place.
+	static void stepCoefficients(std::vector<std::complex<double> > &a, unsigned int p, std::complex<double> k);
 	std::deque<shared_ptr<Context> > m_contexts;
 private:
 	const tfuncIC m_funcARIC;
@@ -52,8 +54,13 @@ struct DECLSPEC_KAME ARContext {
 };
 struct DECLSPEC_KAME MEMBurgContext : public ARContext {
 	MEMBurgContext() : ARContext() {}
-	MEMBurgContext(const MEMBurgContext &c) : ARContext(c), eta(c.eta), epsilon(c.epsilon) {}
+	MEMBurgContext(const MEMBurgContext &c) : ARContext(c), eta(c.eta), epsilon(c.epsilon),
+		cross(c.cross), power(c.power) {}
 	std::vector<std::complex<double> > eta, epsilon;
+	//! sums of epsilon[i] * conj(eta[i-1]) and of |epsilon[i]|^2 + |eta[i-1]|^2 over p < i < t,
+	//! accumulated during the previous step.
+	std::complex<double> cross;
+	double power;
 };
 
 //! Burg's MEM (Maximum Entropy Method).
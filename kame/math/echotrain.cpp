@@ -0,0 +1,136 @@
+/***************************************************************************
+		Copyright (C) 2002-2015 Kentaro Kitagawa
+		                   kitagawa@phys.s.u-tokyo.ac.jp
+
+		This program is free software; you can redistribute it and/or
+		modify it under the terms of the GNU Library General Public
+		License as published by the Free Software Foundation; either
+		version 2 of the License, or (at your option) any later version.
+
+		You should have received a copy of the GNU Library General
+		Public License and a list of authors along with this program;
+		see the files COPYING and AUTHORS.
+ ***************************************************************************/
+#include "echotrain.h"
+
+#if defined __SSE2__
+	#include <emmintrin.h>
+#endif
+
+//! acc[j] += src[j] for j < n, returning the sum of src[j] for j < nsum.
+static inline std::complex<double>
+accumulateBlock(std::complex<double> *acc, const std::complex<double> *src, int n, int nsum) {
+	int j = 0;
+#if defined __SSE2__
+	//One complex number per register.
+	double *pa = reinterpret_cast<double*>(acc);
+	const double *ps = reinterpret_cast<const double*>(src);
+	__m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd();
+	for(; j + 1 < nsum; j += 2) {
+		__m128d x0 = _mm_loadu_pd(ps + 2 * j);
+		__m128d x1 = _mm_loadu_pd(ps + 2 * j + 2);
+		s0 = _mm_add_pd(s0, x0);
+		s1 = _mm_add_pd(s1, x1);
+		_mm_storeu_pd(pa + 2 * j, _mm_add_pd(_mm_loadu_pd(pa + 2 * j), x0));
+		_mm_storeu_pd(pa + 2 * j + 2, _mm_add_pd(_mm_loadu_pd(pa + 2 * j + 2), x1));
+	}
+	for(; j < nsum; ++j) {
+		__m128d x = _mm_loadu_pd(ps + 2 * j);
+		s0 = _mm_add_pd(s0, x);
+		_mm_storeu_pd(pa + 2 * j, _mm_add_pd(_mm_loadu_pd(pa + 2 * j), x));
+	}
+	for(; j + 1 < n; j += 2) {
+		_mm_storeu_pd(pa + 2 * j, _mm_add_pd(_mm_loadu_pd(pa + 2 * j), _mm_loadu_pd(ps + 2 * j)));
+		_mm_storeu_pd(pa + 2 * j + 2, _mm_add_pd(_mm_loadu_pd(pa + 2 * j + 2), _mm_loadu_pd(ps + 2 * j + 2)));
+	}
+	for(; j < n; ++j)
+		_mm_storeu_pd(pa + 2 * j, _mm_add_pd(_mm_loadu_pd(pa + 2 * j), _mm_loadu_pd(ps + 2 * j)));
+	double s[2];
+	_mm_storeu_pd(s, _mm_add_pd(s0, s1));
+	return std::complex<double>(s[0], s[1]);
+#else
+	std::complex<double> sum = 0.0;
+	for(; j < nsum; ++j) {
+		sum += src[j];
+		acc[j] += src[j];
+	}
+	for(; j < n; ++j)
+		acc[j] += src[j];
+	return sum;
+#endif
+}
+
+//! x[j] = x[j] * k - sub for j < n.
+static inline void
+scaleBlock(std::complex<double> *x, int n, double k, std::complex<double> sub) {
+#if defined __SSE2__
+	double *px = reinterpret_cast<double*>(x);
+	const __m128d vk = _mm_set1_pd(k);
+	const __m128d vsub = _mm_set_pd(std::imag(sub), std::real(sub));
+	for(int j = 0; j < n; ++j)
+		_mm_storeu_pd(px + 2 * j, _mm_sub_pd(_mm_mul_pd(_mm_loadu_pd(px + 2 * j), vk), vsub));
+#else
+	for(int j = 0; j < n; ++j)
+		x[j] = x[j] * k - sub;
+#endif
+}
+
+EchoTrain::EchoTrain(int numechoes, int period, int length, int echolength,
+	int bgpos, int bglength, FFT::twindowfunc bgfunc) :
+	m_numEchoes(std::max(1, numechoes)), m_period(period), m_length(length),
+	m_echoLength(std::min(echolength, length)), m_bgPos(bgpos), m_bgFunc(bgfunc) {
+	assert((m_numEchoes == 1) || (length <= period));
+	m_bgWeights.resize(std::max(0, bglength));
+	double normalize = 0.0;
+	for(int i = 0; i < bglength; i++) {
+		m_bgWeights[i] = bgfunc((double)i / bglength - 0.5);
+		normalize += m_bgWeights[i];
+	}
+	for(auto &&w: m_bgWeights)
+		w /= normalize;
+}
+
+std::complex<double>
+EchoTrain::background(const std::complex<double> *wave) const {
+	std::complex<double> bg = 0.0;
+	const std::complex<double> *p = wave + m_bgPos;
+	for(unsigned int i = 0; i < m_bgWeights.size(); i++)
+		bg += m_bgWeights[i] * p[i];
+	return bg;
+}
+
+std::complex<double>
+EchoTrain::exec(std::complex<double> *wave, std::complex<double> *amps) const {
+	int bglength = m_bgWeights.size();
+	bool bg_in_sum = (m_bgPos >= 0) && (m_bgPos + bglength <= m_length);
+	std::complex<double> bg = 0.0;
+	if(bglength && !bg_in_sum)
+		bg = background(wave); //from the record, subtracted in the pass below.
+	std::vector<std::complex<double> > sums(amps ? m_numEchoes : 0, 0.0);
+	const double k = 1.0 / m_numEchoes;
+	for(int b = 0; b < m_length; b += BLOCK_SIZE) {
+		int n = std::min((int)BLOCK_SIZE, m_length - b);
+		int nsum = amps ? std::max(0, std::min(n, m_echoLength - b)) : 0;
+		std::complex<double> *acc = wave + b;
+		for(int j = 0; j < nsum; ++j)
+			sums[0] += acc[j];
+		for(int e = 1; e < m_numEchoes; ++e) {
+			std::complex<double> s = accumulateBlock(acc, wave + e * m_period + b, n, nsum);
+			if(nsum)
+				sums[e] += s;
+		}
+		scaleBlock(acc, n, k, bg);
+	}
+	if(bglength && bg_in_sum) {
+		//from the averaged echo.
+		bg = background(wave);
+		for(int j = 0; j < m_length; ++j)
+			wave[j] -= bg;
+	}
+	if(amps && m_echoLength) {
+		double ka = 1.0 / m_echoLength;
+		for(int e = 0; e < m_numEchoes; ++e)
+			amps[e] += sums[e] * ka - bg;
+	}
+	return bg;
+}
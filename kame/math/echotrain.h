@@ -0,0 +1,64 @@
+/***************************************************************************
+		Copyright (C) 2002-2015 Kentaro Kitagawa
+		                   kitagawa@phys.s.u-tokyo.ac.jp
+
+		This program is free software; you can redistribute it and/or
+		modify it under the terms of the GNU Library General Public
+		License as published by the Free Software Foundation; either
+		version 2 of the License, or (at your option) any later version.
+
+		You should have received a copy of the GNU Library General
+		Public License and a list of authors along with this program;
+		see the files COPYING and AUTHORS.
+***************************************************************************/
+#ifndef echotrainH
+#define echotrainH
+//---------------------------------------------------------------------------
+#include "support.h"
+
+#include <vector>
+#include <complex>
+
+#include "fft.h"
+
+//! Averages a train of equally spaced echoes (e.g. CPMG) in a record, and subtracts the background.
+//! The echoes are summed block by block, so that the partial sum stays in the L1 cache,
+//! and the amplitudes of the individual echoes are taken in the same pass.
+class DECLSPEC_KAME EchoTrain {
+public:
+	//! \param numechoes # of echoes.
+	//! \param period interval of echoes in points.
+	//! \param length # of points to be averaged from the origin of each echo, <= period if numechoes > 1.
+	//! \param echolength # of points for the amplitude of each echo, <= length.
+	//! \param bgpos position of the background window from the origin of the first echo.
+	//! If the window lies within \a length, the background is estimated from the averaged echo,
+	//! otherwise from the record, e.g. after the last echo.
+	//! \param bglength length of the background window, 0 for no subtraction.
+	//! \param bgfunc weights of the background window.
+	EchoTrain(int numechoes, int period, int length, int echolength,
+		int bgpos, int bglength, FFT::twindowfunc bgfunc);
+
+	int numEchoes() const {return m_numEchoes;}
+	int period() const {return m_period;}
+	int length() const {return m_length;}
+	int echoLength() const {return m_echoLength;}
+	int bgPos() const {return m_bgPos;}
+	int bgLength() const {return m_bgWeights.size();}
+	FFT::twindowfunc bgFunc() const {return m_bgFunc;}
+
+	//! Averages the echoes in place, leaving the result at [wave, wave + length()).
+	//! \param wave origin of the first echo in the record.
+	//! \param amps if not null, the mean of each echo over echoLength() after the subtraction,
+	//! added into numEchoes() entries.
+	//! \return the subtracted background.
+	std::complex<double> exec(std::complex<double> *wave, std::complex<double> *amps = nullptr) const;
+private:
+	std::complex<double> background(const std::complex<double> *wave) const;
+
+	enum {BLOCK_SIZE = 256}; //!< 4 KiB of complex numbers.
+	const int m_numEchoes, m_period, m_length, m_echoLength, m_bgPos;
+	const FFT::twindowfunc m_bgFunc;
+	std::vector<double> m_bgWeights; //!< normalized to unity.
+};
+
+#endif
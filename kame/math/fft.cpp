@@ -189,3 +189,63 @@ RIFFT::exec(const std::vector<std::complex<double> >& wavein,
 		*pout2++ = *pin2++;
 	}
 }
+
+DarkPSD::DarkPSD(int fftlen, int length) : m_fftlen(fftlen), m_length(length) {
+	assert(length <= fftlen);
+	m_pBufC = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * fftlen);
+	m_pBufR = (double*)fftw_malloc(sizeof(double) * fftlen);
+	m_pBufH = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * (fftlen / 2 + 1));
+	m_fftplan = fftw_plan_dft_1d(fftlen, m_pBufC, m_pBufC, FFTW_FORWARD, FFTW_ESTIMATE);
+	m_rfftplan = fftw_plan_dft_r2c_1d(fftlen, m_pBufR, m_pBufH, FFTW_ESTIMATE);
+	m_rifftplan = fftw_plan_dft_c2r_1d(fftlen, m_pBufH, m_pBufR, FFTW_ESTIMATE);
+	//FT of |FT of rect. window|^2, i.e. the circular autocorrelation of the window.
+	m_kernel.resize(fftlen / 2 + 1);
+	for(int i = 0; i < (int)m_kernel.size(); i++) {
+		int overlap = std::max(0, length - i) + std::max(0, length - (fftlen - i));
+		m_kernel[i] = (double)overlap / length / fftlen;
+	}
+}
+DarkPSD::~DarkPSD() {
+	fftw_destroy_plan(m_fftplan);
+	fftw_destroy_plan(m_rfftplan);
+	fftw_destroy_plan(m_rifftplan);
+	fftw_free(m_pBufC);
+	fftw_free(m_pBufR);
+	fftw_free(m_pBufH);
+}
+void
+DarkPSD::accumulate(const std::complex<double> *bg, int bglength, double interval, double *psdsum) {
+	int len = std::min(bglength, m_fftlen);
+	if(len != (int)m_twist.size()) {
+		m_twist.resize(len);
+		m_twistNorm = 0.0;
+		for(int i = 0; i < len; i++) {
+			double tw = sin(2.0*M_PI*i/(double)len);
+			m_twist[i] = tw;
+			m_twistNorm += tw * tw;
+		}
+	}
+	fftw_complex *pc = m_pBufC;
+	for(int i = 0; i < len; i++) {
+		std::complex<double> z = bg[i] * m_twist[i];
+		( *pc)[0] = z.real();
+		( *pc)[1] = z.imag();
+		pc++;
+	}
+	std::fill( &m_pBufC[len][0], &m_pBufC[m_fftlen][0], 0.0);
+	fftw_execute(m_fftplan);
+	double normalize = interval / m_twistNorm;
+	for(int i = 0; i < m_fftlen; i++) {
+		m_pBufR[i] = (m_pBufC[i][0] * m_pBufC[i][0] + m_pBufC[i][1] * m_pBufC[i][1]) * normalize;
+	}
+	//Convolution of the PSD and the kernel, both real and the latter even.
+	fftw_execute(m_rfftplan);
+	for(int i = 0; i < m_fftlen / 2 + 1; i++) {
+		m_pBufH[i][0] *= m_kernel[i];
+		m_pBufH[i][1] *= m_kernel[i];
+	}
+	fftw_execute(m_rifftplan);
+	for(int i = 0; i < m_fftlen; i++) {
+		psdsum[i] += m_pBufR[i]; //[V^2/Hz]
+	}
+}
@@ -95,4 +95,32 @@ private:
 	double *m_pBufout;
 	fftw_complex *m_pBufin;
 };
+
+//! Power spectral density of noise estimated from a background window,
+//! convolved with the spectral kernel of the rectangular window of the signal.
+//! The kernel (the FT of the Fejer kernel, a triangle) is evaluated analytically,
+//! and the plans and buffers are kept, leaving three transforms per record.
+class DECLSPEC_KAME DarkPSD {
+public:
+	//! \param fftlen FFT length.
+	//! \param length length of the rectangular window for the signal, <= fftlen.
+	DarkPSD(int fftlen, int length);
+	~DarkPSD();
+	int fftLength() const {return m_fftlen;}
+	int windowLength() const {return m_length;}
+
+	//! Adds the PSD [V^2/Hz] into \a psdsum of size fftLength(), indexed as FFT bins.
+	//! \param bg background points, twisted by a sine not to be affected by the dc subtraction.
+	//! \param interval sampling interval [s].
+	void accumulate(const std::complex<double> *bg, int bglength, double interval, double *psdsum);
+private:
+	const int m_fftlen, m_length;
+	fftw_plan m_fftplan, m_rfftplan, m_rifftplan;
+	fftw_complex *m_pBufC; //!< fftlen
+	double *m_pBufR; //!< fftlen
+	fftw_complex *m_pBufH; //!< fftlen / 2 + 1
+	std::vector<double> m_kernel; //!< fftlen / 2 + 1, including 1/fftlen.
+	std::vector<double> m_twist; //!< for the last bglength.
+	double m_twistNorm;
+};
 #endif
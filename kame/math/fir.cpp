@@ -90,3 +90,59 @@ FIR::exec(const double *src, double *dst, int len) {
 		}
 	}
 }
+
+FIRDecimator::FIRDecimator(unsigned int ratio, unsigned int channels, unsigned int taps_per_phase) :
+	m_ratio(std::max(ratio, 1u)), m_channels(channels),
+	m_taps(std::max(ratio, 1u) * std::max(taps_per_phase, 1u) + 1) {
+	int half = m_taps / 2;
+	double omega = 2.0 * M_PI * passBand(m_ratio);
+	m_coeff.resize(m_taps);
+	double z = 0.0;
+	for(int i = -half; i <= half; i++) {
+		double x = i * omega;
+		//sinc(x) * Hamming window
+		double y = (i == 0) ? 1.0 : (sin(x)/x);
+		y *= 0.54 + 0.46*cos(M_PI*(double)i/(half + 1));
+		m_coeff[i + half] = y;
+		z += y;
+	}
+	//scaling sum into unity
+	for(auto &&c: m_coeff)
+		c /= z;
+	m_history.resize(2 * m_taps * m_channels);
+	reset();
+}
+void
+FIRDecimator::reset() {
+	std::fill(m_history.begin(), m_history.end(), 0.0f);
+	m_pos = 0;
+	m_toNextOutput = m_taps;
+}
+unsigned int
+FIRDecimator::exec(const int16_t *src, unsigned int len, int16_t *dst, unsigned int dst_len) {
+	unsigned int cnt = 0;
+	for(unsigned int i = 0; (i < len) && (cnt < dst_len); i++) {
+		for(unsigned int ch = 0; ch < m_channels; ch++) {
+			float *hist = &m_history[2 * m_taps * ch];
+			float x = *src++;
+			hist[m_pos] = x;
+			hist[m_pos + m_taps] = x;
+		}
+		if(++m_pos == m_taps)
+			m_pos = 0;
+		if(--m_toNextOutput)
+			continue;
+		m_toNextOutput = m_ratio;
+		for(unsigned int ch = 0; ch < m_channels; ch++) {
+			const float *hist = &m_history[2 * m_taps * ch + m_pos];
+			const float *pc = &m_coeff[0];
+			float y = 0.0f;
+			for(unsigned int k = 0; k < m_taps; k++)
+				y += *pc++ * *hist++;
+			long z = lrintf(y);
+			*dst++ = (int16_t)std::max(-32768L, std::min(32767L, z));
+		}
+		cnt++;
+	}
+	return cnt;
+}
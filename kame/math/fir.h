@@ -20,6 +20,7 @@
 #define FIR_H
 
 #include "support.h"
+#include <algorithm>
 #include <vector>
 #include <complex>
 #include <fftw3.h>
@@ -49,4 +50,37 @@ private:
 	const double m_centerFreq;
 };
 
+//! Decimating FIR low-pass filter for streamed, channel-interleaved integer samples.
+//! Only every \a ratio-th output is evaluated (polyphase decomposition),
+//! and the filter history is kept across exec() calls.
+class DECLSPEC_KAME FIRDecimator {
+public:
+	//! \param ratio decimation ratio.
+	//! \param channels # of interleaved channels.
+	//! \param taps_per_phase # of taps per polyphase branch.
+	FIRDecimator(unsigned int ratio, unsigned int channels, unsigned int taps_per_phase = 8);
+	//! Clears the history. The first output will be emitted after taps() input samples.
+	void reset();
+	//! \param src interleaved input, \a len samples per channel.
+	//! \param dst interleaved output, up to \a dst_len samples per channel.
+	//! \return # of output samples per channel.
+	unsigned int exec(const int16_t *src, unsigned int len, int16_t *dst, unsigned int dst_len);
+	unsigned int ratio() const {return m_ratio;}
+	unsigned int channels() const {return m_channels;}
+	//! odd num., group delay is taps() / 2 input samples.
+	unsigned int taps() const {return m_taps;}
+	//! Upper edge of the pass band, 80% of the decimated Nyquist freq., in cycles per input sample.
+	//! Signals above it, e.g., an IF not mixed down, are removed.
+	static double passBand(unsigned int ratio) {return 0.4 / std::max(ratio, 1u);}
+private:
+	const unsigned int m_ratio;
+	const unsigned int m_channels;
+	const unsigned int m_taps;
+	std::vector<float> m_coeff;
+	//! mirrored ring buffers, the latest \a m_taps samples are always contiguous.
+	std::vector<float> m_history;
+	unsigned int m_pos;
+	unsigned int m_toNextOutput;
+};
+
 #endif //FIR_H
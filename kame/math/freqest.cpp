@@ -44,18 +44,11 @@ FreqEstimation::genSpectrum(const std::vector<std::complex<double> >& memin,
 	//# of signal space.
 	int p = t; // / 2 - 1;
 	rx.resize(p);
-	// Correlation matrix.
-	ublas::matrix<std::complex<double> > r(p, p);
-	for(int i = 0; i < p; i++) {
-		ublas::matrix_row<ublas::matrix<std::complex<double> > > rrow(r, i);
-		for(int j = i; j < p; j++) {
-			rrow(j) = rx[j - i];
-		}
-	}
-	ublas::matrix<std::complex<double> > eigv;
+	// Eigen vectors of the correlation matrix, column-major.
+	std::vector<std::complex<double> > eigv;
 	ublas::vector<double> lambda;
 	double tol_lambda = tol * std::abs(rx[0]) * 0.1;
-	eigHermiteRRR(r, lambda, eigv, tol_lambda);
+	eigHermiteToeplitzRRR(rx, lambda, eigv, tol_lambda);
 
 	//# of signals.
 	int numsig = 0;
@@ -82,19 +75,45 @@ FreqEstimation::genSpectrum(const std::vector<std::complex<double> >& memin,
 //		std::cout << lambda << std::endl;
 //		std::cout << eigv << std::endl;
 	}
-	std::vector<std::complex<double> > fftin(t, 0.0), fftout(t), acsum(t, 0.0);
-	for(int i = 0; i < p - numsig; i++) {
-		ublas::matrix_column<ublas::matrix<std::complex<double> > > eigvcol(eigv, i);
-		assert(fabs(norm_2(eigvcol) - 1.0) < 0.1);
-		for(int j = 0; j < p; j++) {
-			fftin[j] = eigvcol(j);
+	//Weighted sum of the autocorrelations of the noise eigen vectors,
+	//as the inverse FFT of the weighted sum of their power spectra, which are transformed in batches.
+	std::vector<std::complex<double> > acsum(t, 0.0);
+	int numnoise = p - numsig;
+	if(numnoise > 0) {
+		int len = FFT::fitLength(p * 2);
+		int batch = std::min(numnoise, (int)NUM_BATCH);
+		fftw_complex *buf = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * len * batch);
+		fftw_plan plan = fftw_plan_many_dft(1, &len, batch, buf, NULL, 1, len, buf, NULL, 1, len,
+			FFTW_FORWARD, FFTW_ESTIMATE);
+		std::vector<std::complex<double> > psdsum(len, 0.0), corr(len);
+		for(int i0 = 0; i0 < numnoise; i0 += batch) {
+			int num = std::min(batch, numnoise - i0);
+			for(int k = 0; k < num; k++) {
+				const std::complex<double> *v = &eigv[(i0 + k) * p];
+				fftw_complex *pin = buf + k * len;
+				for(int j = 0; j < p; j++) {
+					pin[j][0] = std::real(v[j]);
+					pin[j][1] = std::imag(v[j]);
+				}
+				std::fill( &pin[p][0], &pin[len][0], 0.0);
+			}
+			fftw_execute(plan); //the rest of the last batch is left unused.
+			for(int k = 0; k < num; k++) {
+				double z = lambda[i0 + k];
+				z = std::max(z, tol_lambda);
+				z = (m_eigenvalue_method) ? (1.0 / z) : 1.0;
+				const fftw_complex *pout = buf + k * len;
+				for(int j = 0; j < len; j++) {
+					psdsum[j] += (pout[j][0] * pout[j][0] + pout[j][1] * pout[j][1]) * z;
+				}
+			}
 		}
-		autoCorrelation(fftin, fftout);
-		double z = lambda[i];
-		z = std::max(z, tol_lambda);
-		z = (m_eigenvalue_method) ? (1.0 / z) : 1.0;
+		fftw_destroy_plan(plan);
+		fftw_free(buf);
+		FFT(1, len).exec(psdsum, corr);
+		double normalize = 1.0 / ((double)t * len);
 		for(int k = 0; k < p; k++) {
-			acsum[k] += fftout[k] * z;
+			acsum[k] = corr[k] * normalize;
 		}
 	}
 	std::vector<std::complex<double> > zffftin(n, 0.0), zffftout(n);
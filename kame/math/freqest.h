@@ -28,6 +28,7 @@ protected:
 	virtual void genSpectrum(const std::vector<std::complex<double> >& memin,
 		std::vector<std::complex<double> >& memout,
 		int t0, double tol, FFT::twindowfunc windowfunc, double windowlength);
+	enum {NUM_BATCH = 32}; //!< # of eigen vectors transformed at once.
 	const bool m_eigenvalue_method;
 	const bool m_mvdl_method;
 	const tfuncIC m_funcIC;
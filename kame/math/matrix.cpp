@@ -72,19 +72,12 @@ void lpk2cvec(const ublas::vector<LPKT>& lpk, ublas::vector<T> &a) {
 	}
 }
 
-void eigHermiteRRR(const ublas::matrix<std::complex<double> > &a_org,
-	ublas::vector<double> &lambda, ublas::matrix<std::complex<double> > &v,
-	double tol) {
-	LPKint n = a_org.size2();
-	LPKint lda = a_org.size1();
-	assert(lda >= n);
-	LPKint ldz = n;
-	ublas::vector<LPKdoublecomplex> a(n*lda), z(n*ldz);
-	ublas::vector<LPKdoublereal> w(n);
+//! Eigen values and vectors of a column-major Hermitian matrix \a a, upper triangle of which is used.
+static void
+zheevrColumnMajor(LPKint n, LPKdoublecomplex *a, LPKint lda, LPKdoublereal tol,
+	LPKdoublereal *w, LPKdoublecomplex *z, LPKint ldz) {
 	ublas::vector<LPKint> isuppz(2*n);
-	
-	cmat2lpk(a_org, a);
-	
+
 	LPKint lwork = -1, liwork = -1, lrwork = -1;
 	ublas::vector<LPKdoublecomplex> work(1);
 	ublas::vector<LPKdoublereal> rwork(1);
@@ -94,8 +87,8 @@ void eigHermiteRRR(const ublas::matrix<std::complex<double> > &a_org,
 	LPKint il, iu;
 	LPKdoublereal vl, vu;
 	char cv = 'V', ca = 'A', cu = 'U';
-	int ret = zheevr_(&cv, &ca, &cu, &n, &a[0], &lda,
-		 &vl, &vu, &il, &iu, &tol, &numret, &w[0], &z[0], &ldz, 
+	int ret = zheevr_(&cv, &ca, &cu, &n, a, &lda,
+		 &vl, &vu, &il, &iu, &tol, &numret, w, z, &ldz, 
 		 &isuppz[0], &work[0], &lwork, &rwork[0], &lrwork, &iwork[0], &liwork, &info);
 	assert(info == 0);
 	lwork = lrint(work[0].r);
@@ -104,14 +97,46 @@ void eigHermiteRRR(const ublas::matrix<std::complex<double> > &a_org,
 	rwork.resize(lrwork);
 	liwork = iwork[0];
 	iwork.resize(liwork);
-	ret = zheevr_(&cv, &ca, &cu, &n, &a[0], &lda,
-		&vl, &vu, &il, &iu, &tol, &numret, &w[0], &z[0], &ldz, 
+	ret = zheevr_(&cv, &ca, &cu, &n, a, &lda,
+		&vl, &vu, &il, &iu, &tol, &numret, w, z, &ldz, 
 		 &isuppz[0], &work[0], &lwork, &rwork[0], &lrwork, &iwork[0], &liwork, &info);
 	assert(info == 0);
+}
+
+void eigHermiteRRR(const ublas::matrix<std::complex<double> > &a_org,
+	ublas::vector<double> &lambda, ublas::matrix<std::complex<double> > &v,
+	double tol) {
+	LPKint n = a_org.size2();
+	LPKint lda = a_org.size1();
+	assert(lda >= n);
+	LPKint ldz = n;
+	ublas::vector<LPKdoublecomplex> a(n*lda), z(n*ldz);
+	ublas::vector<LPKdoublereal> w(n);
+	
+	cmat2lpk(a_org, a);
+	zheevrColumnMajor(n, &a[0], lda, tol, &w[0], &z[0], ldz);
 	
 	lpk2cvec(w, lambda);
 	v.resize(n, ldz);
 	lpk2cmat(z, v);
 }
+
+void eigHermiteToeplitzRRR(const std::vector<std::complex<double> > &rx,
+	ublas::vector<double> &lambda, std::vector<std::complex<double> > &v,
+	double tol) {
+	static_assert(sizeof(LPKdoublecomplex) == sizeof(std::complex<double>), "layout of complex");
+	LPKint n = rx.size();
+	ublas::vector<LPKdoublecomplex> a(n*n);
+	ublas::vector<LPKdoublereal> w(n);
+	//Upper triangle, column by column.
+	for(LPKint j = 0; j < n; j++) {
+		LPKdoublecomplex *acol = &a[j * n];
+		for(LPKint i = 0; i <= j; i++)
+			subst(acol[i], rx[j - i]);
+	}
+	v.resize(n * n);
+	zheevrColumnMajor(n, &a[0], n, tol, &w[0], reinterpret_cast<LPKdoublecomplex*>( &v[0]), n);
+	lpk2cvec(w, lambda);
+}
 #endif //HAVE_LAPACK
 
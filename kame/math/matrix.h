@@ -31,6 +31,12 @@ using namespace boost::numeric;
 void eigHermiteRRR(const ublas::matrix<std::complex<double> > &a,
 	ublas::vector<double> &lambda, ublas::matrix<std::complex<double> > &v,
 	double tol);
+//! RRR eigenvalue driver for Hermitian Toeplitz matrix given by its first row \a rx.
+//! The matrix is assembled directly in the LAPACK layout.
+//! \param v eigen vectors, column-major, i.e. each vector is contiguous.
+void eigHermiteToeplitzRRR(const std::vector<std::complex<double> > &rx,
+	ublas::vector<double> &lambda, std::vector<std::complex<double> > &v,
+	double tol);
 
 #endif// HAVE_LAPACK
 
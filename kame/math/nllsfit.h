@@ -17,6 +17,15 @@
 
 #include <valarray>
 #include <array>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <limits>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include <gsl/gsl_vector.h>
 #include <gsl/gsl_matrix.h>
@@ -27,10 +36,34 @@
 
 class NonLinearLeastSquare {
 public:
+    //! GSL solver, Jacobian and covariance matrix, reused over fits of the same size.
+    class Workspace {
+    public:
+        Workspace() = default;
+        ~Workspace() {release();}
+        Workspace(const Workspace &) = delete;
+        Workspace& operator=(const Workspace &) = delete;
+    private:
+        friend class NonLinearLeastSquare;
+        void reserve(size_t n, size_t p);
+        void release();
+        gsl_multifit_fdfsolver *m_solver = nullptr;
+        gsl_matrix *m_jacobian = nullptr;
+        gsl_matrix *m_covar = nullptr;
+        std::valarray<double> m_df;
+        std::vector<double *> m_dfRows;
+        size_t m_n = 0, m_p = 0;
+    };
+    //! \param f bool f(const double *params, size_t n, size_t p, double *f, std::vector<double *> &df),
+    //! where \a f is null if only the Jacobian \a df is needed.
     template <class Func>
     NonLinearLeastSquare(Func f,
         std::valarray<double> init_params, size_t n,
         unsigned int max_iterations = 30);
+    template <class Func>
+    NonLinearLeastSquare(Workspace &ws, Func f,
+        std::valarray<double> init_params, size_t n,
+        unsigned int max_iterations = 30);
     NonLinearLeastSquare() = default;
     NonLinearLeastSquare(NonLinearLeastSquare &&) = default;
     NonLinearLeastSquare(const NonLinearLeastSquare &) = delete;
@@ -39,41 +72,119 @@ public:
     std::valarray<double> params() const {return m_params;}
     std::valarray<double> errors() const {return m_errors;}
     double chiSquare() const {return m_chisq;}
+    unsigned int iterations() const {return m_iterations;}
     std::string status() const {return gsl_strerror(m_status);}
     bool isSuccessful() const {return m_status == GSL_SUCCESS;}
 private:
+    using FitFunc = std::function<bool(const double*, size_t n, size_t p,
+        double *f, std::vector<double *> &df)>;
+    void fit(Workspace &ws, const FitFunc &func,
+        std::valarray<double> &init_params, size_t n, unsigned int max_iterations);
     std::valarray<double> m_params, m_errors;
-    double m_chisq;
-    int m_status;
+    double m_chisq = std::numeric_limits<double>::infinity();
+    unsigned int m_iterations = 0;
+    int m_status = GSL_CONTINUE;
 };
 
+//! Fits from many starting points concurrently on a pool of threads, and keeps the best one.
+//! Each thread in the pool owns a workspace.
+//! e.g. auto nlls = NonLinearLeastSquareMultiStart::fit(f, n, init, accept, 30, 256, 0.07);
+class NonLinearLeastSquareMultiStart {
+public:
+    //! Convergence statistics.
+    struct Stats {
+        unsigned int starts = 0; //!< # of fits tried.
+        unsigned int converged = 0; //!< # of successful and acceptable fits.
+        unsigned int iterations = 0; //!< total # of iterations.
+        int best = -1; //!< index of the start giving the result.
+        double elapsed = 0.0; //!< [s].
+    };
+    //! The first start is tried alone. If it fails, random starts follow in batches of concurrency(),
+    //! until a batch yields an acceptable fit, \a max_starts are tried, or \a time_budget runs out.
+    //! \param f the same as for NonLinearLeastSquare, called from the pool threads concurrently.
+    //! \param init std::valarray<double> init(unsigned int start), called from the calling thread.
+    //! \param accept bool accept(const std::valarray<double> &params) judges a successful fit.
+    //! \param time_budget [s].
+    //! \param refine_time [s], during which each start continues from the last fit instead of init(),
+    //! as a fit stopped by \a max_iterations is resumed.
+    //! \return the acceptable fit of the least chi-square, or the fit of the least chi-square if none.
+    //! params() of the result is empty if no fit has given a finite chi-square.
+    template <class Func, class Init, class Accept>
+    static NonLinearLeastSquare fit(Func f, size_t n, Init init, Accept accept,
+        unsigned int max_iterations, unsigned int max_starts, double time_budget,
+        double refine_time = 0.0, Stats *stats = nullptr);
+    //! # of fits evaluated at once.
+    static unsigned int concurrency();
+    //! Runs task(i, workspace) for i in [0, \a count) on the pool, and waits for them.
+    //! For searches whose model or score depends on the start, unlike fit().
+    static void run(unsigned int count,
+        const std::function<void(unsigned int, NonLinearLeastSquare::Workspace &)> &task);
+private:
+    class Pool;
+    static Pool &pool();
+};
+
+inline void
+NonLinearLeastSquare::Workspace::reserve(size_t n, size_t p) {
+    if((n == m_n) && (p == m_p))
+        return;
+    release();
+    m_solver = gsl_multifit_fdfsolver_alloc(gsl_multifit_fdfsolver_lmsder, n, p);
+    m_jacobian = gsl_matrix_alloc(n, p);
+    m_covar = gsl_matrix_alloc(p, p);
+    m_df.resize(n * p);
+    m_dfRows.resize(p);
+    for(size_t i = 0; i < p; ++i)
+        m_dfRows[i] = &m_df[n * i];
+    m_n = n;
+    m_p = p;
+}
+inline void
+NonLinearLeastSquare::Workspace::release() {
+    if(m_solver)
+        gsl_multifit_fdfsolver_free(m_solver);
+    if(m_jacobian)
+        gsl_matrix_free(m_jacobian);
+    if(m_covar)
+        gsl_matrix_free(m_covar);
+    m_solver = nullptr;
+    m_jacobian = nullptr;
+    m_covar = nullptr;
+    m_n = 0;
+    m_p = 0;
+}
 
 template <class Func>
 NonLinearLeastSquare::NonLinearLeastSquare(Func func,
     std::valarray<double> init_params, size_t n,
     unsigned int max_iterations) {
-    const gsl_multifit_fdfsolver_type *T;
-    T = gsl_multifit_fdfsolver_lmsder;
-    gsl_multifit_fdfsolver *s;
-    int iter = 0;
+    Workspace ws;
+    fit(ws, func, init_params, n, max_iterations);
+}
+template <class Func>
+NonLinearLeastSquare::NonLinearLeastSquare(Workspace &ws, Func func,
+    std::valarray<double> init_params, size_t n,
+    unsigned int max_iterations) {
+    fit(ws, func, init_params, n, max_iterations);
+}
+
+inline void
+NonLinearLeastSquare::fit(Workspace &ws, const FitFunc &func,
+    std::valarray<double> &init_params, size_t n, unsigned int max_iterations) {
+    size_t np = init_params.size();
+    ws.reserve(n, np);
+    gsl_multifit_fdfsolver *s = ws.m_solver;
+    unsigned int iter = 0;
     int status;
     gsl_multifit_function_fdf f;
 
     gsl_ieee_env_setup ();
 
     struct USER {
-        std::function<bool(const double*, size_t n, size_t p,
-            double *f, std::vector<double *> &df)> func;
+        const FitFunc &func;
         size_t n, p;
-        std::vector<double *> df;
-    } user;
-    user.func = func;
-    user.n = n;
-    user.p = init_params.size();
-    std::valarray<double> df(init_params.size() * n);
-    user.df.resize(init_params.size());
-    for(size_t p = 0; p < init_params.size(); ++p)
-        user.df[p] = &df[n * p];
+        std::vector<double *> &df;
+    } user = {func, n, np, ws.m_dfRows};
 
     auto cb_f = [](const gsl_vector * x, void *params, gsl_vector * f) -> int {
         auto user = reinterpret_cast<USER*>(params);
@@ -98,10 +209,9 @@ NonLinearLeastSquare::NonLinearLeastSquare(Func func,
     f.df = cb_df;
     f.fdf = nullptr;
     f.n = n;
-    f.p = init_params.size();
+    f.p = np;
     f.params = &user;
-    s = gsl_multifit_fdfsolver_alloc (T, n, init_params.size());
-    gsl_vector_view x = gsl_vector_view_array( &init_params[0], init_params.size());
+    gsl_vector_view x = gsl_vector_view_array( &init_params[0], np);
     gsl_multifit_fdfsolver_set (s, &f, &x.vector);
 
 
@@ -117,35 +227,159 @@ NonLinearLeastSquare::NonLinearLeastSquare(Func func,
     } while (status == GSL_CONTINUE && iter < max_iterations);
 
     m_chisq = pow(gsl_blas_dnrm2(s->f), 2.0);
+    m_iterations = iter;
 
     m_params = init_params;
-    for(int i = 0; i < init_params.size(); i++)
+    for(int i = 0; i < np; i++)
         m_params[i] = gsl_vector_get(s->x, i);
 
 //Computes covariance of best fit parameters
-    gsl_matrix *covar = gsl_matrix_alloc (init_params.size(), init_params.size());
+    gsl_matrix *covar = ws.m_covar;
 #if (GSL_MAJOR_VERSION >= 2)
-    gsl_matrix *J = gsl_matrix_alloc(n, init_params.size());
+    gsl_matrix *J = ws.m_jacobian;
     gsl_multifit_fdfsolver_jac(s, J);
     gsl_multifit_covar(J, 0.0, covar);
 #else
     #error GSL < 2 is obsolete, because of poor fit.
     gsl_multifit_covar (s->J, 0.0, covar);
 #endif
-    m_errors.resize(init_params.size());
-    for(int i = 0; i < init_params.size(); i++) {
+    m_errors.resize(np);
+    for(int i = 0; i < np; i++) {
         double c = gsl_matrix_get(covar,i,i);
 
         m_errors[i] = (c > 0) ? sqrt(c * m_chisq / n) : -1.0;
     }
-    gsl_matrix_free(covar);
-#if (GSL_MAJOR_VERSION >= 2)
-    gsl_matrix_free(J);
-#endif
-    gsl_multifit_fdfsolver_free(s);
 
     m_status = status;
 }
 
+class NonLinearLeastSquareMultiStart::Pool {
+public:
+    using Task = std::function<void(unsigned int, NonLinearLeastSquare::Workspace &)>;
+    enum {MAX_THREADS = 16};
+    Pool() : m_workspaces(std::min((unsigned int)MAX_THREADS, std::max(1u, std::thread::hardware_concurrency()))) {
+        for(unsigned int i = 0; i < m_workspaces.size(); ++i)
+            m_threads.emplace_back( &Pool::execute, this, i);
+    }
+    ~Pool() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_terminated = true;
+        }
+        m_cond.notify_all();
+        for(auto &&t: m_threads)
+            t.join();
+    }
+    unsigned int size() const {return m_threads.size();}
+    //! Runs task(i, workspace) for i in [0, \a count), and waits for them.
+    void run(unsigned int count, const Task &task) {
+        if( !count)
+            return;
+        auto job = std::make_shared<Job>();
+        job->task = &task;
+        job->count = count;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_jobs.push_back(job);
+        m_cond.notify_all();
+        m_condDone.wait(lock, [&job]{return job->done == job->count;});
+    }
+private:
+    struct Job {
+        const Task *task;
+        unsigned int count, next = 0, done = 0;
+    };
+    void execute(unsigned int idx) {
+        NonLinearLeastSquare::Workspace &ws(m_workspaces[idx]);
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for(;;) {
+            m_cond.wait(lock, [this]{return m_terminated || !m_jobs.empty();});
+            if(m_terminated)
+                return;
+            std::shared_ptr<Job> job = m_jobs.front();
+            unsigned int i = job->next++;
+            if(job->next == job->count)
+                m_jobs.pop_front();
+            lock.unlock();
+            try {
+                ( *job->task)(i, ws);
+            }
+            catch (...) {
+                //leaves the result unsuccessful.
+            }
+            lock.lock();
+            if(++job->done == job->count)
+                m_condDone.notify_all();
+        }
+    }
+    std::vector<NonLinearLeastSquare::Workspace> m_workspaces;
+    std::vector<std::thread> m_threads;
+    std::deque<std::shared_ptr<Job>> m_jobs;
+    std::mutex m_mutex;
+    std::condition_variable m_cond, m_condDone;
+    bool m_terminated = false;
+};
+
+inline NonLinearLeastSquareMultiStart::Pool &
+NonLinearLeastSquareMultiStart::pool() {
+    static Pool pool;
+    return pool;
+}
+inline unsigned int
+NonLinearLeastSquareMultiStart::concurrency() {
+    return pool().size();
+}
+inline void
+NonLinearLeastSquareMultiStart::run(unsigned int count,
+    const std::function<void(unsigned int, NonLinearLeastSquare::Workspace &)> &task) {
+    pool().run(count, task);
+}
+
+template <class Func, class Init, class Accept>
+NonLinearLeastSquare
+NonLinearLeastSquareMultiStart::fit(Func f, size_t n, Init init, Accept accept,
+    unsigned int max_iterations, unsigned int max_starts, double time_budget,
+    double refine_time, Stats *stats) {
+    auto time_start = std::chrono::steady_clock::now();
+    Stats st;
+    NonLinearLeastSquare best;
+    bool is_best_accepted = false;
+    std::valarray<double> last_params; //of the last start tried alone, to be refined.
+    unsigned int batch = 1; //the first start alone, typically the last result.
+    while(st.starts < max_starts) {
+        bool is_refining = last_params.size() && (st.elapsed < refine_time);
+        unsigned int count = is_refining ? 1u : std::min(batch, max_starts - st.starts);
+        std::vector<std::valarray<double>> init_params(count);
+        for(unsigned int i = 0; i < count; ++i)
+            init_params[i] = is_refining ? last_params : init(st.starts + i);
+        std::vector<NonLinearLeastSquare> results(count);
+        pool().run(count, [&](unsigned int i, NonLinearLeastSquare::Workspace &ws) {
+            results[i] = NonLinearLeastSquare(ws, f, init_params[i], n, max_iterations);
+        });
+        last_params = (count == 1) ? results[0].params() : std::valarray<double>();
+        for(unsigned int i = 0; i < count; ++i) {
+            auto &res = results[i];
+            st.iterations += res.iterations();
+            bool is_accepted = res.isSuccessful() && accept(res.params());
+            if(is_accepted)
+                st.converged++;
+            if((is_accepted && !is_best_accepted) ||
+                ((is_accepted == is_best_accepted) && (res.chiSquare() < best.chiSquare()))) {
+                best = std::move(res);
+                is_best_accepted = is_accepted;
+                st.best = st.starts + i;
+            }
+        }
+        st.starts += count;
+        st.elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - time_start).count();
+        if(is_best_accepted || (st.elapsed > time_budget))
+            break;
+        if(last_params.size() && (st.elapsed < refine_time))
+            continue;
+        batch = concurrency();
+    }
+    if(stats)
+        *stats = st;
+    return best;
+}
 
 #endif // NLLSFIT_H
@@ -92,8 +92,8 @@ SpectrumSolver::exec(const std::vector<std::complex<double> >& memin, std::vecto
 void
 SpectrumSolver::autoCorrelation(const std::vector<std::complex<double> >&wave,
 	std::vector<std::complex<double> >&corr) {
-	if(!m_fftRX || (m_fftRX->length() != wave.size())) {
-		int len = FFT::fitLength(wave.size() * 2);
+	int len = FFT::fitLength(wave.size() * 2);
+	if(!m_fftRX || (m_fftRX->length() != len)) {
 		m_fftRX.reset(new FFT(-1, len));
 		m_ifftRX.reset(new FFT(1, len));
 	}
@@ -17,6 +17,9 @@
 
 #include "dso.h"
 #include "softtrigger.h"
+#include "hugepage_allocator.h"
+
+class FIRDecimator;
 
 //! Software DSO using continuous AD read.
 //! Trigger position is typically calculated by a synchronized pulse generator.
@@ -29,6 +32,21 @@ public:
     virtual ~XRealTimeAcqDSO() = default;
     //! Converts raw to record
     virtual void convertRaw(typename tDriver::RawDataReader &reader, Transaction &tr) throw (typename tDriver::XRecordError&) override;
+
+    //! Decimation ratio applied before accumulation. 1 for no decimation.
+    //! \a recordLength() is counted in undecimated samples.
+    //! The decimation filter is a low-pass without mixing, see FIRDecimator::passBand().
+    //! With digital RF detection, the IF, aliased by the sampling, has to be in the pass band.
+    const shared_ptr<XUIntNode> &decimation() const {return m_decimation;}
+    //! # of segments gathered per software trigger, e.g. for CPMG echo trains.
+    //! Each segment has \a recordLength() samples and its own accumulation.
+    const shared_ptr<XUIntNode> &segments() const {return m_segments;}
+    //! Interval between starts of successive segments [s].
+    const shared_ptr<XDoubleNode> &segmentPeriod() const {return m_segmentPeriod;}
+    //! # of software-trigger stamps lost by overflow.
+    const shared_ptr<XULongNode> &softTrigDropped() const {return m_softTrigDropped;}
+    //! # of software-trigger stamps cleared before being read.
+    const shared_ptr<XULongNode> &softTrigDiscarded() const {return m_softTrigDiscarded;}
 protected:
     using tRawAI = int16_t;
     //! Changes the instrument state so that it can wait for a trigger (arm).
@@ -104,6 +122,13 @@ protected:
     //! Loads waveform and settings from instrument
     virtual void getWave(shared_ptr<typename tDriver::RawData> &writer, std::deque<XString> &channels) override;
 
+    //! Pre-faulted storage on huge pages, for large records and ring buffers.
+    template <typename T>
+    using AcqBuffer = std::vector<T, hugepage_allocator<T>>;
+    //! (Re)allocates \a buf on the NUMA node of the acquisition thread, unless it fits already.
+    template <typename T>
+    void allocateAcqBuffer(AcqBuffer<T> &buf, size_t size);
+
     bool hasSoftwareTrigger() const {return !!m_softwareTrigger;}
     shared_ptr<SoftwareTrigger> softwareTrigger() const {return m_softwareTrigger;}
 
@@ -115,15 +140,35 @@ protected:
 
     void suspendAcquision();
 private:
+    const shared_ptr<XUIntNode> m_decimation;
+    const shared_ptr<XUIntNode> m_segments;
+    const shared_ptr<XDoubleNode> m_segmentPeriod;
+    const shared_ptr<XULongNode> m_softTrigDropped;
+    const shared_ptr<XULongNode> m_softTrigDiscarded;
     shared_ptr<SoftwareTrigger> m_softwareTrigger;
     shared_ptr<Listener> m_lsnOnSoftTrigStarted, m_lsnOnSoftTrigChanged;
+    shared_ptr<Listener> m_lsnOnAcqCondChanged;
+    void onAcqCondChanged(const Snapshot &shot, XValueNodeBase *);
     void onSoftTrigStarted(const shared_ptr<SoftwareTrigger> &);
     void onSoftTrigChanged(const shared_ptr<SoftwareTrigger> &);
     unique_ptr<XThread> m_threadReadAI;
     void *executeReadAI(const atomic<bool> &);
     atomic<bool> m_suspendRead;
     atomic<bool> m_running;
-    std::vector<tRawAI> m_recordBuf;
+    //! NUMA node running executeReadAI(), -1 if unknown, for the buffers.
+    //! NUMA_NODE_PENDING until the thread starts.
+    atomic<int> m_acqNUMANode;
+    enum : int {NUMA_NODE_PENDING = -2};
+    AcqBuffer<tRawAI> m_recordBuf;
+    //! Streaming low-pass filter before accumulation, null if not decimated.
+    unique_ptr<FIRDecimator> m_decimator;
+    std::vector<tRawAI> m_rawBuf; //!< undecimated chunk.
+    unsigned int decimationRatio() const;
+    unsigned int m_numSegments;
+    uint64_t m_segmentPeriodSamps; //!< undecimated samples.
+    //! leading word of segmented raw data, followed by the segment informations and the usual header.
+    //! Never a # of channels, which leads the other raw data.
+    enum : uint32_t {RAW_SEGMENTED_MARKER = 0x5e67e9edu};
     inline double aiRawToVolt(const double *pcoeff, double raw);
     struct DSORawRecord {
         DSORawRecord() { locked = false;}
@@ -132,7 +177,7 @@ private:
         unsigned int recordLength;
         int acqCount;
         bool isComplex; //true in the coherent SG mode.
-        std::vector<int32_t> record;
+        AcqBuffer<int32_t> record;
         atomic<int> locked;
         bool tryLock() {
             bool ret = locked.compare_set_strong(false, true);
@@ -15,16 +15,30 @@
 #include "dsorealtimeacq.h"
 #include <qmessagebox.h>
 #include "xwavengraph.h"
+#include "fir.h"
 
 template <class tDriver> XRealTimeAcqDSO<tDriver>::XRealTimeAcqDSO(const char *name, bool runtime,
     Transaction &tr_meas, const shared_ptr<XMeasure> &meas) :
     tDriver(name, runtime, ref(tr_meas), meas),
+    m_decimation(this->template create<XUIntNode>("Decimation", false)),
+    m_segments(this->template create<XUIntNode>("Segments", false)),
+    m_segmentPeriod(this->template create<XDoubleNode>("SegmentPeriod", false)),
+    m_softTrigDropped(this->template create<XULongNode>("SoftTrigDropped", true)),
+    m_softTrigDiscarded(this->template create<XULongNode>("SoftTrigDiscarded", true)),
+    m_acqNUMANode(NUMA_NODE_PENDING),
+    m_numSegments(1),
+    m_segmentPeriodSamps(0),
     m_dsoRawRecordBankLatest(0) {
 
     this->iterate_commit([=](Transaction &tr){
         tr[ *this->recordLength()] = 2000;
         tr[ *this->timeWidth()] = 1e-2;
         tr[ *this->average()] = 1;
+        tr[ *decimation()] = 1;
+        tr[ *segments()] = 1;
+        tr[ *segmentPeriod()] = 1e-3;
+        tr[ *softTrigDropped()].setUIEnabled(false);
+        tr[ *softTrigDiscarded()].setUIEnabled(false);
     });
     if(isMemLockAvailable()) {
         //Suppress swapping.
@@ -59,8 +73,11 @@ XRealTimeAcqDSO<tDriver>::open() throw (XKameError &) {
     onSoftTrigChanged(shared_ptr<SoftwareTrigger>());
 
     m_suspendRead = true;
+    m_acqNUMANode = NUMA_NODE_PENDING;
     m_threadReadAI.reset(new XThread(
         this->shared_from_this(), &XRealTimeAcqDSO<tDriver>::executeReadAI));
+    //The buffers allocated by createChannels() are placed on the node of the thread.
+    while(m_acqNUMANode == NUMA_NODE_PENDING) msecsleep(1);
 
     this->start();
 
@@ -68,6 +85,12 @@ XRealTimeAcqDSO<tDriver>::open() throw (XKameError &) {
         this->interface()->softwareTriggerManager().onListChanged().connectWeakly(
             this->shared_from_this(), &XRealTimeAcqDSO<tDriver>::onSoftTrigChanged,
             Listener::FLAG_MAIN_THREAD_CALL | Listener::FLAG_DELAY_ADAPTIVE | Listener::FLAG_AVOID_DUP);
+    this->iterate_commit([=](Transaction &tr){
+        m_lsnOnAcqCondChanged = tr[ *decimation()].onValueChanged().connectWeakly(
+            this->shared_from_this(), &XRealTimeAcqDSO<tDriver>::onAcqCondChanged);
+        tr[ *segments()].onValueChanged().connect(m_lsnOnAcqCondChanged);
+        tr[ *segmentPeriod()].onValueChanged().connect(m_lsnOnAcqCondChanged);
+    });
     createChannels();
 }
 template <class tDriver>
@@ -76,6 +99,7 @@ XRealTimeAcqDSO<tDriver>::close() throw (XKameError &) {
     XScopedLock<XInterface> lock( *this->interface());
 
     m_lsnOnSoftTrigChanged.reset();
+    m_lsnOnAcqCondChanged.reset();
 
     clearAll();
 
@@ -84,6 +108,8 @@ XRealTimeAcqDSO<tDriver>::close() throw (XKameError &) {
     }
 
     m_recordBuf.clear();
+    m_rawBuf.clear();
+    m_decimator.reset();
     m_record_av.clear();
 
     this->interface()->stop();
@@ -133,7 +159,9 @@ XRealTimeAcqDSO<tDriver>::setupTrigger() {
     XScopedLock<XRecursiveMutex> lock2(m_readMutex);
 
     unsigned int pretrig = lrint(shot[ *this->trigPos()] / 100.0 * shot[ *this->recordLength()]);
-    m_preTriggerPos = pretrig;
+    //a multiple of the decimation ratio, so that the trigger falls on a decimated sample.
+    const unsigned int dec = decimationRatio();
+    m_preTriggerPos = (pretrig + dec / 2) / dec * dec;
 
     setupHardwareTrigger();
 }
@@ -174,27 +202,67 @@ XRealTimeAcqDSO<tDriver>::setupTiming() {
     disableTrigger();
     setupSoftwareTrigger();
 
-    const unsigned int len = shot[ *this->recordLength()];
+    m_interval = setupTimeBase();
+
+    unsigned int dec = std::max(1u, (unsigned int)shot[ *decimation()]);
+    if(dec > shot[ *this->recordLength()]) {
+        gWarnPrint(i18n("Decimation ratio exceeds the record length, ignored."));
+        dec = 1;
+    }
+    if((dec > 1) && (shot[ *this->dRFMode()] != this->DRFMODE_OFF)) {
+        //the IF seen by the sampling, in cycles per undecimated sample.
+        double f_if = this->phaseOfRF(shot, 1, m_interval) / (2.0 * M_PI);
+        f_if = std::min(f_if, 1.0 - f_if);
+        if(f_if > FIRDecimator::passBand(dec)) {
+            gWarnPrint(i18n("IF %1 MHz is removed by decimation, ignored.").arg(f_if / m_interval * 1e-6));
+            dec = 1;
+        }
+    }
+    unsigned int segs = std::max(1u, (unsigned int)shot[ *segments()]);
+    if( !m_softwareTrigger && (segs > 1)) {
+        gWarnPrint(i18n("Segmented acquisition requires a software trigger."));
+        segs = 1;
+    }
+    m_numSegments = segs;
+    const unsigned int len = shot[ *this->recordLength()] / dec * segs;
     for(unsigned int i = 0; i < 2; i++) {
         DSORawRecord &rec = m_dsoRawRecordBanks[i];
-        rec.record.resize(len * num_ch * (rec.isComplex ? 2 : 1));
+        allocateAcqBuffer(rec.record, len * num_ch * (rec.isComplex ? 2 : 1));
         assert(rec.numCh == num_ch);
+    }
+    allocateAcqBuffer(m_recordBuf, len * num_ch);
+    if(dec > 1) {
+        m_decimator.reset(new FIRDecimator(dec, num_ch));
+        m_rawBuf.resize(8192u * num_ch);
         if(isMemLockAvailable()) {
-            mlock(&rec.record[0], rec.record.size() * sizeof(int32_t));
+            mlock( &m_rawBuf[0], m_rawBuf.size() * sizeof(tRawAI));
         }
     }
-    m_recordBuf.resize(len * num_ch);
-    if(isMemLockAvailable()) {
-        mlock( &m_recordBuf[0], m_recordBuf.size() * sizeof(tRawAI));
+    else {
+        m_decimator.reset();
+        m_rawBuf.clear();
     }
 
-    m_interval = setupTimeBase();
+    //segments start at multiples of the decimation ratio, and never overlap.
+    m_segmentPeriodSamps = dec * std::max((uint64_t)(len / segs),
+        (uint64_t)llrint(shot[ *segmentPeriod()] / (m_interval * dec)));
 
     setupTrigger();
 
     startSequence();
 }
 
+template <class tDriver>
+template <typename T>
+void
+XRealTimeAcqDSO<tDriver>::allocateAcqBuffer(AcqBuffer<T> &buf, size_t size) {
+    int node = std::max((int)m_acqNUMANode, -1); //the calling thread, if not started.
+    if((buf.size() == size) && (buf.get_allocator().numaNode() == node))
+        return;
+    //releases the old storage first, not to hold both.
+    buf = AcqBuffer<T>(hugepage_allocator<T>(node, isMemLockAvailable()));
+    buf.resize(size);
+}
 template <class tDriver>
 void
 XRealTimeAcqDSO<tDriver>::createChannels() {
@@ -245,7 +313,8 @@ XRealTimeAcqDSO<tDriver>::onSoftTrigStarted(const shared_ptr<SoftwareTrigger> &)
     }
 
     const DSORawRecord &rec(m_dsoRawRecordBanks[m_dsoRawRecordBankLatest]);
-    m_softwareTrigger->setBlankTerm(m_interval * rec.recordLength);
+    m_softwareTrigger->setBlankTerm(m_interval *
+        ((m_numSegments - 1) * m_segmentPeriodSamps + rec.recordLength / m_numSegments * decimationRatio()));
 //	fprintf(stderr, "Virtual trig start.\n");
 
     uint32_t num_ch = getNumOfChannels();
@@ -297,6 +366,7 @@ template <class tDriver>
 void *
 XRealTimeAcqDSO<tDriver>::executeReadAI(const atomic<bool> &terminated) {
     Transactional::setCurrentPriorityMode(Transactional::Priority::HIGHEST);
+    m_acqNUMANode = hugepage_buffer::currentNUMANode();
     while( !terminated) {
         try {
             Snapshot shot( *this);
@@ -333,8 +403,16 @@ XRealTimeAcqDSO<tDriver>::acquire(const Snapshot &shot, const atomic<bool> &term
             throw XInterface::XInterfaceError(i18n("Inconsistent channel number."), __FILE__, __LINE__);
 
         const unsigned int size = m_recordBuf.size() / num_ch;
+        const unsigned int seg_size = size / m_numSegments;
         const double freq = 1.0 / m_interval;
         unsigned int cnt = 0;
+        //undecimated samples to be read per segment, including the history of the decimation filter.
+        unsigned int raw_size = seg_size;
+        unsigned int dec_delay = 0;
+        if(m_decimator) {
+            raw_size = seg_size * m_decimator->ratio() + m_decimator->taps() - 1;
+            dec_delay = m_decimator->taps() / 2;
+        }
 
         uint64_t samplecnt_at_trigger = 0;
         if(m_softwareTrigger) {
@@ -346,7 +424,7 @@ XRealTimeAcqDSO<tDriver>::acquire(const Snapshot &shot, const atomic<bool> &term
                 uint64_t total_samps = getTotalSampsAcquired();
                 samplecnt_at_trigger = vt->tryPopFront(total_samps, freq);
                 if(samplecnt_at_trigger) {
-                    if( !setReadPositionAbsolute(samplecnt_at_trigger - m_preTriggerPos)) {
+                    if( !setReadPositionAbsolute(samplecnt_at_trigger - m_preTriggerPos - dec_delay)) {
                         gWarnPrint(i18n("Buffer Overflow."));
                         continue;
                     }
@@ -356,28 +434,69 @@ XRealTimeAcqDSO<tDriver>::acquire(const Snapshot &shot, const atomic<bool> &term
             }
         }
         else {
+            //the decimated record lags by the group delay of the filter.
             setReadPositionFirstPoint();
         }
         if(terminated)
             return;
 
-        const unsigned int num_samps = std::min(size, 8192u);
-        for(; cnt < size;) {
-            int samps;
-            samps = std::min(size - cnt, num_samps);
-            while( !terminated) {
-                if(tryReadAISuspend(terminated))
+        const unsigned int num_samps = std::min(raw_size, 8192u);
+        bool discarded = false;
+        //segments are gathered in one pass, each into its own slice of the record.
+        for(unsigned int seg = 0; seg < m_numSegments; seg++) {
+            if(seg > 0) {
+                uint64_t pos = samplecnt_at_trigger - m_preTriggerPos - dec_delay + seg * m_segmentPeriodSamps;
+                while( !terminated) {
+                    if(tryReadAISuspend(terminated))
+                        return;
+                    uint64_t total_samps = getTotalSampsAcquired();
+                    if(total_samps > pos)
+                        break;
+                    msecsleep(lrint(1e3 * (pos - total_samps) * m_interval));
+                }
+                if(terminated)
                     return;
-                uint32_t space = getNumSampsToBeRead();
-                if(space >= samps)
+                if( !setReadPositionAbsolute(pos)) {
+                    gWarnPrint(i18n("Buffer Overflow."));
+                    discarded = true;
                     break;
-                msecsleep(lrint(1e3 * (samps - space) * m_interval));
+                }
+            }
+            if(m_decimator)
+                m_decimator->reset();
+            const unsigned int seg_end = cnt + seg_size;
+            for(unsigned int raw_cnt = 0; (raw_cnt < raw_size) && (cnt < seg_end);) {
+                int samps;
+                samps = std::min(raw_size - raw_cnt, num_samps);
+                while( !terminated) {
+                    if(tryReadAISuspend(terminated))
+                        return;
+                    uint32_t space = getNumSampsToBeRead();
+                    if(space >= samps)
+                        break;
+                    msecsleep(lrint(1e3 * (samps - space) * m_interval));
+                }
+                if(terminated)
+                    return;
+                if(m_decimator) {
+                    samps = readAcqBuffer(samps, &m_rawBuf[0]);
+                    cnt += m_decimator->exec(&m_rawBuf[0], samps, &m_recordBuf[cnt * num_ch], seg_end - cnt);
+                }
+                else {
+                    samps = readAcqBuffer(samps, &m_recordBuf[cnt * num_ch]);
+                    cnt += samps;
+                }
+                raw_cnt += samps;
+            }
+            if((m_numSegments > 1) && (cnt < seg_end)) {
+                //the following segments would not be at their slices, and zeros would be accumulated.
+                gWarnPrint(i18n("Incomplete segment, the record is discarded."));
+                discarded = true;
+                break;
             }
-            if(terminated)
-                return;
-            samps = readAcqBuffer(samps, &m_recordBuf[cnt * num_ch]);
-            cnt += samps;
         }
+        if(discarded)
+            continue;
 
         const unsigned int av = shot[ *this->average()];
         const bool sseq = shot[ *this->singleSequence()];
@@ -418,27 +537,20 @@ XRealTimeAcqDSO<tDriver>::acquire(const Snapshot &shot, const atomic<bool> &term
         unsigned int div = bufsize / 4;
         unsigned int rest = bufsize % 4;
         if(new_rec.isComplex) {
-            double ph = this->phaseOfRF(shot, samplecnt_at_trigger, m_interval);
-            double cosph = cos(ph);
-            double sinph = sin(ph);
-            //real part.
-            for(unsigned int i = 0; i < div; i++) {
-                *paccum++ = *pold++ + *pbuf++ * cosph;
-                *paccum++ = *pold++ + *pbuf++ * cosph;
-                *paccum++ = *pold++ + *pbuf++ * cosph;
-                *paccum++ = *pold++ + *pbuf++ * cosph;
+            //each segment is rotated by the phase of the RF at its own start,
+            //the real parts followed by the imag parts.
+            const unsigned int seg_len = (m_numSegments > 1) ? seg_size * num_ch : bufsize;
+            for(unsigned int seg = 0, begin = 0; begin < bufsize; seg++, begin += seg_len) {
+                double ph = this->phaseOfRF(shot,
+                    samplecnt_at_trigger + (uint64_t)seg * m_segmentPeriodSamps, m_interval);
+                double cosph = cos(ph);
+                double sinph = sin(ph);
+                const unsigned int end = std::min(bufsize, begin + seg_len);
+                for(unsigned int i = begin; i < end; i++)
+                    paccum[i] = pold[i] + pbuf[i] * cosph;
+                for(unsigned int i = begin; i < end; i++)
+                    paccum[bufsize + i] = pold[bufsize + i] + pbuf[i] * sinph;
             }
-            for(unsigned int i = 0; i < rest; i++)
-                *paccum++ = *pold++ + *pbuf++ * cosph;
-            //imag part.
-            for(unsigned int i = 0; i < div; i++) {
-                *paccum++ = *pold++ + *pbuf++ * sinph;
-                *paccum++ = *pold++ + *pbuf++ * sinph;
-                *paccum++ = *pold++ + *pbuf++ * sinph;
-                *paccum++ = *pold++ + *pbuf++ * sinph;
-            }
-            for(unsigned int i = 0; i < rest; i++)
-                *paccum++ = *pold++ + *pbuf++ * cosph;
         }
         else {
             for(unsigned int i = 0; i < div; i++) {
@@ -476,7 +588,7 @@ XRealTimeAcqDSO<tDriver>::acquire(const Snapshot &shot, const atomic<bool> &term
         m_dsoRawRecordBankLatest = bank;
         new_rec.unlock();
         if( !sseq) {
-            m_record_av.push_back(m_recordBuf);
+            m_record_av.emplace_back(m_recordBuf.begin(), m_recordBuf.end());
         }
         if(sseq && (accumcnt >= av))  {
             if(m_softwareTrigger) {
@@ -548,7 +660,12 @@ XRealTimeAcqDSO<tDriver>::acqCount(bool *seq_busy) {
 template <class tDriver>
 double
 XRealTimeAcqDSO<tDriver>::getTimeInterval() {
-    return m_interval;
+    return m_interval * decimationRatio();
+}
+template <class tDriver>
+unsigned int
+XRealTimeAcqDSO<tDriver>::decimationRatio() const {
+    return m_decimator ? m_decimator->ratio() : 1u;
 }
 
 template <class tDriver>
@@ -590,11 +707,18 @@ XRealTimeAcqDSO<tDriver>::getWave(shared_ptr<typename tDriver::RawData> &writer,
 
     if(rec.isComplex)
         num_ch *= 2;
+    //every segment is complete in the record, see acquire().
+    const uint32_t seg_len = len / m_numSegments;
+    if(m_numSegments > 1) {
+        writer->push((uint32_t)RAW_SEGMENTED_MARKER);
+        writer->push((uint32_t)m_numSegments);
+        writer->push((uint32_t)(m_segmentPeriodSamps / decimationRatio()));
+    }
     writer->push((uint32_t)num_ch);
-    writer->push((uint32_t)m_preTriggerPos);
-    writer->push((uint32_t)len);
+    writer->push((uint32_t)(m_preTriggerPos / decimationRatio()));
+    writer->push((uint32_t)seg_len);
     writer->push((uint32_t)rec.accumCount);
-    writer->push((double)m_interval);
+    writer->push((double)(m_interval * decimationRatio()));
     for(unsigned int ch = 0; ch < num_ch; ch++) {
         for(unsigned int i = 0; i < CAL_POLY_ORDER; i++) {
             int ch_real = ch;
@@ -603,7 +727,7 @@ XRealTimeAcqDSO<tDriver>::getWave(shared_ptr<typename tDriver::RawData> &writer,
         }
     }
     const int32_t *p = &(rec.record[0]);
-    const unsigned int size = len * num_ch;
+    const unsigned int size = seg_len * m_numSegments * num_ch;
     for(unsigned int i = 0; i < size; i++)
         writer->push((int32_t)*p++);
     XString str = getChannelInfoStrings();
@@ -612,17 +736,41 @@ XRealTimeAcqDSO<tDriver>::getWave(shared_ptr<typename tDriver::RawData> &writer,
     writer->insert(writer->end(), str.begin(), str.end());
 
     rec.unlock();
+
+    if(m_softwareTrigger) {
+        unsigned long dropped = m_softwareTrigger->droppedStamps();
+        unsigned long discarded = m_softwareTrigger->discardedStamps();
+        Snapshot shot( *this);
+        if((shot[ *softTrigDropped()] != dropped) || (shot[ *softTrigDiscarded()] != discarded)) {
+            if(shot[ *softTrigDropped()] != dropped)
+                gWarnPrint(i18n("Software-trigger stamps have been dropped."));
+            this->iterate_commit([=](Transaction &tr){
+                tr[ *softTrigDropped()] = dropped;
+                tr[ *softTrigDiscarded()] = discarded;
+            });
+        }
+    }
 }
 template <class tDriver>
 void
 XRealTimeAcqDSO<tDriver>::convertRaw(typename tDriver::RawDataReader &reader, Transaction &tr) throw (typename tDriver::XRecordError&) {
-    const unsigned int num_ch = reader.template pop<uint32_t>();
+    unsigned int num_ch = reader.template pop<uint32_t>();
+    const bool segmented = (num_ch == RAW_SEGMENTED_MARKER);
+    unsigned int num_segments = 1;
+    unsigned int seg_period = 0;
+    if(segmented) {
+        num_segments = reader.template pop<uint32_t>();
+        seg_period = reader.template pop<uint32_t>();
+        num_ch = reader.template pop<uint32_t>();
+    }
     const unsigned int pretrig = reader.template pop<uint32_t>();
     const unsigned int len = reader.template pop<uint32_t>();
     const unsigned int accumCount = reader.template pop<uint32_t>();
     const double interval = reader.template pop<double>();
+    //segments are placed on the time axis from the trigger.
+    const unsigned int len_disp = (num_segments - 1) * seg_period + len;
 
-    tr[ *this].setParameters(num_ch, - (double)pretrig * interval, interval, len);
+    tr[ *this].setParameters(num_ch, - (double)pretrig * interval, interval, len_disp);
 
     double *wave[num_ch * 2];
     double coeff[num_ch * 2][CAL_POLY_ORDER];
@@ -630,14 +778,18 @@ XRealTimeAcqDSO<tDriver>::convertRaw(typename tDriver::RawDataReader &reader, Tr
         for(unsigned int i = 0; i < CAL_POLY_ORDER; i++) {
             coeff[j][i] = reader.template pop<double>();
         }
-
-        wave[j] = tr[ *this].waveDisp(j);
+        if(segmented)
+            std::fill(tr[ *this].waveDisp(j), tr[ *this].waveDisp(j) + len_disp, 0.0); //blanks between segments.
     }
 
     const double prop = 1.0 / accumCount;
-    for(unsigned int i = 0; i < len; i++) {
+    for(unsigned int seg = 0; seg < num_segments; seg++) {
         for(unsigned int j = 0; j < num_ch; j++)
-            *(wave[j])++ = aiRawToVolt(coeff[j], reader.template pop<int32_t>() * prop);
+            wave[j] = tr[ *this].waveDisp(j) + seg * seg_period;
+        for(unsigned int i = 0; i < len; i++) {
+            for(unsigned int j = 0; j < num_ch; j++)
+                *(wave[j])++ = aiRawToVolt(coeff[j], reader.template pop<int32_t>() * prop);
+        }
     }
 }
 
@@ -701,3 +853,6 @@ template <class tDriver> void XRealTimeAcqDSO<tDriver>::onVOffset4Changed(const
 template <class tDriver> void XRealTimeAcqDSO<tDriver>::onRecordLengthChanged(const Snapshot &shot, XValueNodeBase *) {
     createChannels();
 }
+template <class tDriver> void XRealTimeAcqDSO<tDriver>::onAcqCondChanged(const Snapshot &shot, XValueNodeBase *) {
+    createChannels();
+}
@@ -27,6 +27,7 @@ SUBDIRS += testdriver\
     nmrpulsercore\
     nmrpulser\
     thamway\
+    simulatednmr\
     nmr\
     sgcore\
     sg\
@@ -66,6 +67,8 @@ digilentwf.depends += dsocore
 tempcontrol.depends += dcsourcecore flowcontrollercore
 thamway.file = nmr/thamway/thamway.pro
 thamway.depends += nmrpulsercore sgcore networkanalyzercore
+simulatednmr.file = nmr/simulated/simulatednmr.pro
+simulatednmr.depends += nmrpulsercore dsocore
 qdcore.file = qd/core/qdcore.pro
 qd.depends += qdcore charinterface
 pumpcontroller.depends += charinterface
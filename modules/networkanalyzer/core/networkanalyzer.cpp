@@ -157,11 +157,11 @@ XNetworkAnalyzer::visualize(const Snapshot &shot) {
 	const unsigned int length = shot[ *this].length();
     m_waveForm->iterate_commit([=](Transaction &tr){
 		tr[ *m_markerPlot->maxCount()] = shot[ *this].m_markers.size();
-        auto &points(tr[ *m_markerPlot].points());
-		points.clear();
+        auto &markerplot(tr[ *m_markerPlot]);
+		markerplot.clearPoints();
 		for(std::deque<std::pair<double, double> >::const_iterator it = shot[ *this].m_markers.begin();
 			it != shot[ *this].m_markers.end(); it++) {
-			points.push_back(XGraph::ValPoint(it->first, it->second));
+			markerplot.appendPoint(XGraph::ValPoint(it->first, it->second));
 		}
 
 		tr[ *m_waveForm].setRowCount(length);
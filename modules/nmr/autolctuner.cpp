@@ -19,275 +19,7 @@
 
 REGISTER_TYPE(XDriverList, AutoLCTuner, "NMR LC autotuner");
 
-#include "nllsfit.h"
-#include "rand.h"
-
-//! Series LCR circuit. Additional R in series with a port.
-class LCRFit {
-public:
-    LCRFit(double f0, double rl, bool tight_couple);
-    LCRFit(const LCRFit &) = default;
-    void fit(const std::vector<double> &s11, double fstart, double fstep, bool randomize = true);
-    void computeResidualError(const std::vector<double> &s11, double fstart, double fstep, double omega0, double omega_trust);
-    double r1() const {return m_r1;} //!< R of LCR circuit
-    double r2() const {return m_r2;} //!< R in series with a port.
-    double c1() const {return m_c1;} //!< C of LCR circuit
-    double c2() const {return m_c2;} //!< C in parallel to a port.
-    void setCaps(double c1, double c2) {
-        m_c1 = c1; m_c2 = c2;
-    }
-    double l1() const {return m_l1;} //!< Fixed value for L.
-    double c1err() const {return m_c1_err;}
-    double c2err() const {return m_c2_err;}
-    double coupling() const {return rl(f0() * 2.0 * M_PI).imag();}
-    //! Checks if the R_L appears on the upper half plane of Smith chart.
-    bool isCouplingTight() const {return coupling() > 0;}
-    double residualError() const {return m_resErr;}
-
-    //! Resonance freq.
-    double f0() const {
-        double f = 1.0 / 2 / M_PI / sqrt(l1() * c1());
-        for(int it = 0; it < 5; ++it)
-            f = 1.0 / 2 / M_PI / sqrt(l1() * c1() -
-                c1() * c2() / (1.0/pow(50.0 + r2(), 2.0) + pow(2 * M_PI * f * c2(), 2.0)));
-        return f;
-    }
-    double f0err() const {
-        double v = 0.0;
-        LCRFit lcr( *this);
-        lcr.m_c1 += c1err();
-        v += std::norm(lcr.f0() - f0());
-        lcr.m_c1 = m_c1;
-        lcr.m_c2 += c2err();
-        v += std::norm(lcr.f0() - f0());
-        return sqrt(v);
-    }
-    double qValue() const {
-        return 2 * M_PI * f0() * l1() / r1();
-    }
-    //! Reflection
-    std::complex<double> rl(double omega, std::complex<double> zlcr1_inv) const {
-        auto zL =  1.0 / (std::complex<double>(0.0, omega * c2()) + zlcr1_inv) + r2();
-        return (zL - 50.0) / (zL + 50.0);
-    }
-    std::complex<double> rl(double omega) const {
-        return rl(omega, 1.0 / zlcr1(omega));
-    }
-    double rlerr(double omega) const {
-        double v = 0.0;
-        LCRFit lcr( *this);
-        lcr.m_c1 += c1err();
-        v += std::norm(lcr.rl(omega) - rl(omega));
-        lcr.m_c1 = m_c1;
-        lcr.m_c2 += c2err();
-        v += std::norm(lcr.rl(omega) - rl(omega));
-        return sqrt(v);
-    }
-    //! Obtains expected C1 and C2.
-    std::pair<double, double> tuneCaps(double target_freq) const {
-        return tuneCapsInternal(target_freq, 0.0, isCouplingTight());
-    }
-    void setTunedCaps(double target_freq, double target_rl, bool tight_couple) {
-        std::tie(m_c1, m_c2) = tuneCapsInternal(target_freq, target_rl, tight_couple);
-        m_tightCouple = tight_couple;
-    }
-private:
-    double rlpow(double omega) const {
-        return std::abs(rl(omega));
-    }
-    std::complex<double> zlcr1(double omega) const {
-        return std::complex<double>(r1(), omega * l1() - 1.0 / (omega * c1()));
-    }
-    double isigma(double domega, double omega_trust) const {
-//        return 1.0/(pow(rlpow0, 0.5 / POW_ON_FIT) + 0.1) / exp( fabs(domega) / omega_trust / 3);
-//        return sqrt(exp( -std::norm(domega / omega_trust) / 2.0) / (sqrt(2 * M_PI)  * omega_trust)); //a weight during the fit.
-        return sqrt(1.0 / (M_PI * omega_trust * (1.0 + std::norm(domega / omega_trust)))); //a weight during the fit.
-    }
-    std::pair<double, double> tuneCapsInternal(double target_freq, double target_rl0, bool tight_couple) const;
-    double m_r1, m_r2, m_l1;
-    double m_c1, m_c2;
-    double m_c1_err, m_c2_err;
-    double m_resErr;
-    bool m_tightCouple;
-};
-
-std::pair<double, double> LCRFit::tuneCapsInternal(double f1, double target_rl, bool tight_couple) const {
-    LCRFit nlcr( *this);
-    double omega = 2 * M_PI * f1;
-    double omegasq = pow(2 * M_PI * f1, 2.0);
-    for(int it = 0; it < 100; ++it) {
-         //self-consistent eq. to fix resonant freq.
-        nlcr.m_c1 = 1.0 / omegasq / (nlcr.l1() - nlcr.c2() /  (1/ pow(50.0 + nlcr.r2(), 2.0) + omegasq * nlcr.c2() * nlcr.c2()));
-         //self-consistent eq. to fix rl.
-        auto zlcr1_inv = 1.0 / nlcr.zlcr1(omega);
-        auto rl1 = nlcr.rl(omega, zlcr1_inv);
-        if(tight_couple * rl1.imag() < 0)
-            rl1 *= -1; //forces tightness/looseness.
-        rl1 = target_rl * rl1 / std::abs(rl1); //rearranges |RL|, leaving a phase.
-        auto target_zlinv = 1.0 / (100.0 / (1.0 - rl1) - 50.0 - r2());
-        nlcr.m_c2 = std::imag(target_zlinv - zlcr1_inv) / omega;
-    }
-    return {nlcr.m_c1, nlcr.m_c2};
-}
-
-LCRFit::LCRFit(double init_f0, double init_rl, bool tight_couple) {
-    double fres = init_f0;
-    for(int it = 0; it < 2; ++it) {
-        m_l1 = 50.0 / (2.0 * M_PI * fres);
-        m_c1 = 1.0 / 50.0 / (2.0 * M_PI * fres);
-        m_c2 = m_c1 * 10;
-        double q = 30;
-        m_r1 = 2.0 * M_PI * fres * l1() / q;
-        m_r2 = 1.0;
-        setTunedCaps(init_f0, 0.0, tight_couple);
-        fres = f0();
-    }
-    setTunedCaps(init_f0, init_rl, tight_couple);
-    m_c1_err = m_c1 * 0.1; m_c2_err = m_c2 * 0.1;
-//    double omega = 2 * M_PI * init_f0;
-//    fprintf(stderr, "Target (%.4g, %.2g) -> (%.4g, %.2g)\n", init_f0, init_rl, f0(), std::abs(rl(omega)));
-}
-
-void
-LCRFit::computeResidualError(const std::vector<double> &s11, double fstart, double fstep, double omega0, double omega_trust) {
-    double x = 0.0;
-    double freq = fstart;
-    for(size_t i = 0; i < s11.size(); ++i) {
-        double omega = 2 * M_PI * freq;
-        x += std::norm((s11[i] - rlpow(omega)) * isigma(omega - omega0, omega_trust) * sqrt(2.0 * M_PI * fstep));
-        freq += fstep;
-    }
-    m_resErr = sqrt(x / s11.size());
-}
-
-void
-LCRFit::fit(const std::vector<double> &s11, double fstart, double fstep, bool randomize) {
-    m_resErr = 1.0;
-    LCRFit lcr_orig( *this);
-    double f0org = lcr_orig.f0();
-    double omega0org = 2.0 * M_PI * f0org;
-    double rl_orig = std::abs(lcr_orig.rl(omega0org));
-    double coupling_orig = lcr_orig.coupling();
-    double omega_trust;
-    auto eval_omega_trust = [&](double q){
-        double omega_avail = 2.0 * M_PI * std::min(f0org - fstart, fstart + fstep * s11.size() - f0org);
-        return std::min(omega0org / q * 2, omega_avail / 2);
-    };
-    double max_q = f0org / fstep;
-
-    auto func = [&s11, this, &fstart, fstep, omega0org, &omega_trust](const double*params, size_t n, size_t p,
-            double *f, std::vector<double *> &df) -> bool {
-        m_r1 = params[0];
-        if(p >= 2) m_c2 = params[1];
-        if(p >= 3) m_c1 = fabs(params[2]);
-        if(p >= 4) m_r2 = params[3];
-
-        constexpr double DR1 = 1e-2, DR2 = 1e-2, DC1 = 1e-15, DC2 = 1e-15;
-        LCRFit plusDR1( *this), plusDR2( *this), plusDC1( *this), plusDC2( *this);
-        plusDR1.m_r1 += DR1;
-        plusDR2.m_r2 += DR2;
-        plusDC1.m_c1 += DC1;
-        plusDC2.m_c2 += DC2;
-        double freq = fstart;
-        for(size_t i = 0; i < n; ++i) {
-            double omega = 2 * M_PI * freq;
-            double rlpow0 = rlpow(omega);
-            double wsqrt = isigma(omega - omega0org, omega_trust) * sqrt(2.0 * M_PI * fstep);
-            if(f) {
-                f[i] = (rlpow0 - s11[i]) * wsqrt;
-            }
-            else {
-                df[0][i] = (plusDR1.rlpow(omega) - rlpow0) / DR1 * wsqrt;
-                if(p >= 2) df[1][i] = (plusDC2.rlpow(omega) - rlpow0) / DC2 * wsqrt;
-                if(p >= 3) df[2][i] = (plusDC1.rlpow(omega) - rlpow0) / DC1 * wsqrt;
-                if(p >= 4) df[3][i] = (plusDR2.rlpow(omega) - rlpow0) / DR2 * wsqrt;
-            }
-            freq += fstep;
-        }
-        return true;
-    };
-
-    double omega_trust_scale = 1.5;
-    double residualerr = 1.0;
-    int it_best = 0.0;
-    NonLinearLeastSquare nlls;
-    auto start = XTime::now();
-    for(int retry = 0;; retry++) {
-        if(retry > 50) {
-            fprintf(stderr, "Fitting has not converged.\n");
-            break; //better fit cannot be expected anymore.
-        }
-        if((retry > 5) && (residualerr < 1e-3))
-            break; //enough good
-//        if((retry == 2) && (residualerr < 1e-3) && !randomize)
-//            break; //enough good and initial values were already good.
-        if((retry % 2 == 1) && (randomize)) {
-            *this = LCRFit(f0org, rl_orig, coupling_orig > 0.0);
-            double q = pow(10.0, (retry % 12) / 12.0 * log10(max_q)) + 2;
-            m_r1 = 2.0 * M_PI * f0org * l1() / q;
-            omega_trust_scale = (retry % 8) / 6.0 * 2.0 + 0.5;
-        }
-        if((retry % 3 == 0) || (fabs(r2()) > 10) || (c1() < 0) || (c2() < 0) || (qValue() > max_q) || (qValue() < 2)) {
-            fprintf(stderr, "Randomize anyway.\n");
-            fprintf(stderr, "R1:%.3g, R2:%.3g, L:%.3g, C1:%.3g, C2:%.3g, Q:%.3g\n",
-                    r1(), r2(), l1(),
-                    c1(), c2(), qValue());
-            randomize = true; //fitting diverged.
-            continue;
-        }
-        omega_trust = eval_omega_trust(qValue()) * omega_trust_scale;
-        if( !(omega_trust > 0)) {
-            fprintf(stderr, "Too small omega trust.\n");
-            continue; //less or nan
-        }
-        size_t fit_n = s11.size() - 1;
-        if(fit_n < 20) {
-            fprintf(stderr, "Too small fit #.\n");
-            continue;
-        }
-        auto nlls1 = NonLinearLeastSquare(func, {m_r1, m_c2, m_c1, m_r2}, fit_n, 200);
-        m_r1 = fabs(nlls1.params()[0]);
-        m_c2 = nlls1.params()[1];
-        m_c1 = nlls1.params()[2];
-        m_r2 = nlls1.params()[3];
-        m_c2_err = nlls1.errors()[1];
-        m_c1_err = nlls1.errors()[2];
-        omega_trust = eval_omega_trust(4.0);
-        computeResidualError(s11, fstart, fstep, omega0org, omega_trust);
-        double err = residualError();
-        if(coupling() * coupling_orig < 0)
-            err += 4.0 * sqrt( -coupling() * coupling_orig); //Adds cost for opposite coupling.
-        if(retry == 0) {
-            //Stores an error for the original fitting.
-            residualerr = err;
-            lcr_orig.m_resErr = err;
-        }
-        if(nlls1.isSuccessful() && (err < residualerr) && !std::isnan(f0err())) {
-            residualerr  = err;
-            nlls = std::move(nlls1);
-            lcr_orig = *this;
-            it_best = retry;
-        }
-        nlls1 = NonLinearLeastSquare(func, {m_r1}, fit_n);
-        m_r1 = fabs(nlls1.params()[0]);
-        nlls1 = NonLinearLeastSquare(func, {m_r1, m_c2}, fit_n);
-        m_r1 = fabs(nlls1.params()[0]);
-        m_c2 = nlls1.params()[1];
-    }
-    *this = lcr_orig;
-    if(nlls.errors().size() == 4) {
-        fprintf(stderr, "R1:%.3g+-%.2g, R2:%.3g+-%.2g, L:%.3g, C1:%.3g+-%.2g, C2:%.3g+-%.2g\n",
-                r1(), nlls.errors()[0], r2(), nlls.errors()[3], l1(),
-                c1(), c1err(), c2(), c2err());
-    }
-    else {
-        fprintf(stderr, "R1:%.3g, R2:%.3g, L:%.3g, C1:%.3g, C2:%.3g\n",
-                r1(), r2(), l1(),
-                c1(), c2());
-    }
-    fprintf(stderr, "rms of residuals = %.3g, elapsed = %f ms & %d iterations.\n",
-            residualError(), 1000.0 * (XTime::now() - start), it_best);
-}
+#include "lcrfit.h"
 
 class XLCRPlot : public XFuncPlot {
 public:
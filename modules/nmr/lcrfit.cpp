@@ -0,0 +1,265 @@
+/***************************************************************************
+        Copyright (C) 2002-2018 Kentaro Kitagawa
+                           kitagawa@phys.s.u-tokyo.ac.jp
+
+        This program is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        You should have received a copy of the GNU Library General
+        Public License and a list of authors along with this program;
+        see the files COPYING and AUTHORS.
+***************************************************************************/
+#include "lcrfit.h"
+#include "nllsfit.h"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <valarray>
+#include <algorithm>
+
+std::pair<double, double> LCRFit::tuneCapsInternal(double f1, double target_rl, bool tight_couple) const {
+    LCRFit nlcr( *this);
+    double omega = 2 * M_PI * f1;
+    double omegasq = pow(2 * M_PI * f1, 2.0);
+    for(int it = 0; it < 100; ++it) {
+         //self-consistent eq. to fix resonant freq.
+        nlcr.m_c1 = 1.0 / omegasq / (nlcr.l1() - nlcr.c2() /  (1/ pow(50.0 + nlcr.r2(), 2.0) + omegasq * nlcr.c2() * nlcr.c2()));
+         //self-consistent eq. to fix rl.
+        auto zlcr1_inv = 1.0 / nlcr.zlcr1(omega);
+        auto rl1 = nlcr.rl(omega, zlcr1_inv);
+        if(tight_couple * rl1.imag() < 0)
+            rl1 *= -1; //forces tightness/looseness.
+        rl1 = target_rl * rl1 / std::abs(rl1); //rearranges |RL|, leaving a phase.
+        auto target_zlinv = 1.0 / (100.0 / (1.0 - rl1) - 50.0 - r2());
+        nlcr.m_c2 = std::imag(target_zlinv - zlcr1_inv) / omega;
+    }
+    return {nlcr.m_c1, nlcr.m_c2};
+}
+
+LCRFit::LCRFit(double init_f0, double init_rl, bool tight_couple) {
+    double fres = init_f0;
+    for(int it = 0; it < 2; ++it) {
+        m_l1 = 50.0 / (2.0 * M_PI * fres);
+        m_c1 = 1.0 / 50.0 / (2.0 * M_PI * fres);
+        m_c2 = m_c1 * 10;
+        double q = 30;
+        m_r1 = 2.0 * M_PI * fres * l1() / q;
+        m_r2 = 1.0;
+        setTunedCaps(init_f0, 0.0, tight_couple);
+        fres = f0();
+    }
+    setTunedCaps(init_f0, init_rl, tight_couple);
+    m_c1_err = m_c1 * 0.1; m_c2_err = m_c2 * 0.1;
+    m_resErr = 1.0;
+//    double omega = 2 * M_PI * init_f0;
+//    fprintf(stderr, "Target (%.4g, %.2g) -> (%.4g, %.2g)\n", init_f0, init_rl, f0(), std::abs(rl(omega)));
+}
+
+void
+LCRFit::rlpow(const double *omega, const double *omega_inv, size_t n, double *y) const {
+    const double r1 = m_r1, r2 = m_r2, l1 = m_l1, c2 = m_c2, c1_inv = 1.0 / m_c1;
+    for(size_t i = 0; i < n; ++i) {
+        //admittance of the LCR circuit, 1 / (r1 + jx).
+        double x = omega[i] * l1 - omega_inv[i] * c1_inv;
+        double d = 1.0 / (r1 * r1 + x * x);
+        double yr = r1 * d;
+        double yi = omega[i] * c2 - x * d;
+        //impedance seen from the port.
+        double dy = 1.0 / (yr * yr + yi * yi);
+        double zr = yr * dy + r2;
+        double zisq = yi * yi * dy * dy;
+        y[i] = sqrt(((zr - 50.0) * (zr - 50.0) + zisq) / ((zr + 50.0) * (zr + 50.0) + zisq));
+    }
+}
+
+void
+LCRFit::computeResidualError(const std::vector<double> &s11, double fstart, double fstep, double omega0, double omega_trust) {
+    double x = 0.0;
+    double freq = fstart;
+    for(size_t i = 0; i < s11.size(); ++i) {
+        double omega = 2 * M_PI * freq;
+        x += std::norm((s11[i] - rlpow(omega)) * isigma(omega - omega0, omega_trust) * sqrt(2.0 * M_PI * fstep));
+        freq += fstep;
+    }
+    m_resErr = sqrt(x / s11.size());
+}
+
+void
+LCRFit::fit(const std::vector<double> &s11, double fstart, double fstep, bool randomize, Stats *stats) {
+    auto time_start = std::chrono::steady_clock::now();
+    m_resErr = 1.0;
+    const LCRFit lcr_orig( *this);
+    double f0org = lcr_orig.f0();
+    double omega0org = 2.0 * M_PI * f0org;
+    double rl_orig = std::abs(lcr_orig.rl(omega0org));
+    double coupling_orig = lcr_orig.coupling();
+    auto eval_omega_trust = [&](double q){
+        double omega_avail = 2.0 * M_PI * std::min(f0org - fstart, fstart + fstep * s11.size() - f0org);
+        return std::min(omega0org / q * 2, omega_avail / 2);
+    };
+    double max_q = f0org / fstep;
+    double omega_trust_res = eval_omega_trust(4.0); //for the residual error.
+
+    const size_t fit_n = (s11.size() > 0) ? s11.size() - 1 : 0;
+    if(fit_n < 20) {
+        fprintf(stderr, "Too small fit #.\n");
+        return;
+    }
+    //The trace is evaluated at once.
+    std::vector<double> omega(fit_n), omega_inv(fit_n);
+    for(size_t i = 0; i < fit_n; ++i) {
+        omega[i] = 2 * M_PI * (fstart + i * fstep);
+        omega_inv[i] = 1.0 / omega[i];
+    }
+
+    //A starting point and its result.
+    struct Start {
+        Start(const LCRFit &lcr) : lcr(lcr) {}
+        LCRFit lcr;
+        double omega_trust = 0.0;
+        double err = 1.0;
+        unsigned int iterations = 0;
+        std::valarray<double> errors;
+        bool isValid = false;
+    };
+    //The first one from the current values, the others from a low-discrepancy sequence
+    //over Q and the width of the trust region.
+    auto init = [&](unsigned int k) -> Start {
+        double omega_trust_scale = 1.5;
+        Start start(k ? LCRFit(f0org, rl_orig, coupling_orig > 0.0) : lcr_orig);
+        if(k) {
+            double u = fmod(k * 0.7548776662466927, 1.0), v = fmod(k * 0.5698402909980532, 1.0);
+            double q = pow(10.0, u * log10(max_q)) + 2;
+            start.lcr.m_r1 = 2.0 * M_PI * f0org * start.lcr.l1() / q;
+            omega_trust_scale = 0.5 + 2.0 * v;
+        }
+        start.omega_trust = eval_omega_trust(start.lcr.qValue()) * omega_trust_scale;
+        return start;
+    };
+    auto is_sane = [max_q](const LCRFit &lcr) {
+        return (fabs(lcr.r2()) <= 10) && (lcr.c1() >= 0) && (lcr.c2() >= 0) &&
+            (lcr.qValue() <= max_q) && (lcr.qValue() >= 2);
+    };
+    auto exec = [&](Start &start, NonLinearLeastSquare::Workspace &ws) {
+        if( !is_sane(start.lcr) || !(start.omega_trust > 0))
+            return;
+        std::vector<double> wsqrt(fit_n), y0(fit_n), y1(fit_n);
+        for(size_t i = 0; i < fit_n; ++i)
+            wsqrt[i] = isigma(omega[i] - omega0org, start.omega_trust) * sqrt(2.0 * M_PI * fstep);
+        LCRFit base(start.lcr); //values not being fitted are taken from this.
+        auto func = [&](const double*params, size_t n, size_t p,
+                double *f, std::vector<double *> &df) -> bool {
+            LCRFit lcr(base);
+            lcr.m_r1 = params[0];
+            if(p >= 2) lcr.m_c2 = params[1];
+            if(p >= 3) lcr.m_c1 = fabs(params[2]);
+            if(p >= 4) lcr.m_r2 = params[3];
+            lcr.rlpow( &omega[0], &omega_inv[0], n, &y0[0]);
+            if(f) {
+                for(size_t i = 0; i < n; ++i)
+                    f[i] = (y0[i] - s11[i]) * wsqrt[i];
+                return true;
+            }
+            constexpr double DR1 = 1e-2, DR2 = 1e-2, DC1 = 1e-15, DC2 = 1e-15;
+            auto derivative = [&](const LCRFit &plus, double d, double *dfdx) {
+                plus.rlpow( &omega[0], &omega_inv[0], n, &y1[0]);
+                for(size_t i = 0; i < n; ++i)
+                    dfdx[i] = (y1[i] - y0[i]) / d * wsqrt[i];
+            };
+            LCRFit plus(lcr);
+            plus.m_r1 += DR1;
+            derivative(plus, DR1, df[0]);
+            if(p >= 2) {
+                plus = lcr; plus.m_c2 += DC2;
+                derivative(plus, DC2, df[1]);
+            }
+            if(p >= 3) {
+                plus = lcr; plus.m_c1 += DC1;
+                derivative(plus, DC1, df[2]);
+            }
+            if(p >= 4) {
+                plus = lcr; plus.m_r2 += DR2;
+                derivative(plus, DR2, df[3]);
+            }
+            return true;
+        };
+        //The full fit is repeated after refining R1, and then R1 and C2, from its result.
+        for(int pass = 0; pass < 2; ++pass) {
+            auto nlls = NonLinearLeastSquare(ws, func, {base.m_r1, base.m_c2, base.m_c1, base.m_r2}, fit_n, 200);
+            start.iterations += nlls.iterations();
+            LCRFit lcr(base);
+            lcr.m_r1 = fabs(nlls.params()[0]);
+            lcr.m_c2 = nlls.params()[1];
+            lcr.m_c1 = nlls.params()[2];
+            lcr.m_r2 = nlls.params()[3];
+            lcr.m_c2_err = nlls.errors()[1];
+            lcr.m_c1_err = nlls.errors()[2];
+            lcr.computeResidualError(s11, fstart, fstep, omega0org, omega_trust_res);
+            double err = lcr.residualError();
+            if(lcr.coupling() * coupling_orig < 0)
+                err += 4.0 * sqrt( -lcr.coupling() * coupling_orig); //Adds cost for opposite coupling.
+            if(nlls.isSuccessful() && is_sane(lcr) && !std::isnan(lcr.f0err()) &&
+                ( !start.isValid || (err < start.err))) {
+                start.lcr = lcr;
+                start.err = err;
+                start.errors = nlls.errors();
+                start.isValid = true;
+            }
+            if(pass)
+                break;
+            base = lcr;
+            nlls = NonLinearLeastSquare(ws, func, {base.m_r1}, fit_n);
+            start.iterations += nlls.iterations();
+            base.m_r1 = fabs(nlls.params()[0]);
+            nlls = NonLinearLeastSquare(ws, func, {base.m_r1, base.m_c2}, fit_n);
+            start.iterations += nlls.iterations();
+            base.m_r1 = fabs(nlls.params()[0]);
+            base.m_c2 = nlls.params()[1];
+            if( !is_sane(base))
+                break;
+        }
+    };
+
+    constexpr unsigned int MAX_STARTS = 48;
+    constexpr double GOOD_ERROR = 1e-3, TIME_BUDGET = 1.0; //[s]
+    Stats st;
+    std::unique_ptr<Start> best;
+    unsigned int batch = randomize ? NonLinearLeastSquareMultiStart::concurrency() : 1;
+    while(st.starts < MAX_STARTS) {
+        std::vector<Start> starts;
+        for(unsigned int i = 0; i < std::min(batch, MAX_STARTS - st.starts); ++i)
+            starts.push_back(init(st.starts + i));
+        NonLinearLeastSquareMultiStart::run(starts.size(),
+            [&](unsigned int i, NonLinearLeastSquare::Workspace &ws) {exec(starts[i], ws);});
+        for(unsigned int i = 0; i < starts.size(); ++i) {
+            st.iterations += starts[i].iterations;
+            if(starts[i].isValid && ( !best || (starts[i].err < best->err))) {
+                best.reset(new Start(starts[i]));
+                st.best = st.starts + i;
+            }
+        }
+        st.starts += starts.size();
+        st.elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - time_start).count();
+        if((best && (best->err < GOOD_ERROR)) || (st.elapsed > TIME_BUDGET))
+            break; //enough good.
+        batch = NonLinearLeastSquareMultiStart::concurrency();
+    }
+    if(stats)
+        *stats = st;
+    if( !best) {
+        fprintf(stderr, "Fitting has not converged.\n");
+        *this = lcr_orig;
+        computeResidualError(s11, fstart, fstep, omega0org, omega_trust_res);
+        return;
+    }
+    *this = best->lcr;
+    m_resErr = best->err;
+    fprintf(stderr, "R1:%.3g+-%.2g, R2:%.3g+-%.2g, L:%.3g, C1:%.3g+-%.2g, C2:%.3g+-%.2g\n",
+            r1(), best->errors[0], r2(), best->errors[3], l1(),
+            c1(), c1err(), c2(), c2err());
+    fprintf(stderr, "rms of residuals = %.3g, elapsed = %f ms, %u starts & %u iterations.\n",
+            residualError(), 1000.0 * st.elapsed, st.starts, st.iterations);
+}
@@ -0,0 +1,130 @@
+/***************************************************************************
+        Copyright (C) 2002-2018 Kentaro Kitagawa
+                           kitagawa@phys.s.u-tokyo.ac.jp
+
+        This program is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        You should have received a copy of the GNU Library General
+        Public License and a list of authors along with this program;
+        see the files COPYING and AUTHORS.
+***************************************************************************/
+#ifndef LCRFIT_H
+#define LCRFIT_H
+
+#include <complex>
+#include <vector>
+#include <utility>
+#include <tuple>
+#include <cmath>
+
+//! Series LCR circuit. Additional R in series with a port.
+class LCRFit {
+public:
+    LCRFit(double f0, double rl, bool tight_couple);
+    LCRFit(const LCRFit &) = default;
+    //! Statistics of the last fit().
+    struct Stats {
+        unsigned int starts = 0; //!< # of starting points tried.
+        unsigned int iterations = 0; //!< total # of iterations.
+        int best = -1; //!< index of the start giving the result.
+        double elapsed = 0.0; //!< [s].
+    };
+    //! Fits from the current values and many other starting points, in parallel.
+    //! The result from each start is fitted again after refining R1, and then R1 and C2, alone.
+    //! \param s11 |S11| at fstart + i * fstep [Hz].
+    //! \param randomize if false, the current values are expected to be close, and are tried alone first.
+    void fit(const std::vector<double> &s11, double fstart, double fstep, bool randomize = true,
+        Stats *stats = nullptr);
+    void computeResidualError(const std::vector<double> &s11, double fstart, double fstep, double omega0, double omega_trust);
+    double r1() const {return m_r1;} //!< R of LCR circuit
+    double r2() const {return m_r2;} //!< R in series with a port.
+    double c1() const {return m_c1;} //!< C of LCR circuit
+    double c2() const {return m_c2;} //!< C in parallel to a port.
+    void setCaps(double c1, double c2) {
+        m_c1 = c1; m_c2 = c2;
+    }
+    double l1() const {return m_l1;} //!< Fixed value for L.
+    double c1err() const {return m_c1_err;}
+    double c2err() const {return m_c2_err;}
+    double coupling() const {return rl(f0() * 2.0 * M_PI).imag();}
+    //! Checks if the R_L appears on the upper half plane of Smith chart.
+    bool isCouplingTight() const {return coupling() > 0;}
+    double residualError() const {return m_resErr;}
+
+    //! Resonance freq.
+    //! The positive root of the quadratic equation for omega^2 from the self-consistent condition,
+    //! omega^2 (L C1 - C1 C2 / (1/(50 + R2)^2 + omega^2 C2^2)) = 1.
+    double f0() const {
+        double g = 1.0 / ((50.0 + r2()) * (50.0 + r2()));
+        double a = l1() * c1() * c2() * c2();
+        double b = l1() * c1() * g - c1() * c2() - c2() * c2();
+        double disc = sqrt(b * b + 4.0 * a * g);
+        double omegasq = (b > 0) ? 2.0 * g / (b + disc) : (disc - b) / (2.0 * a);
+        return sqrt(omegasq) / 2 / M_PI;
+    }
+    double f0err() const {
+        double v = 0.0;
+        LCRFit lcr( *this);
+        lcr.m_c1 += c1err();
+        v += std::norm(lcr.f0() - f0());
+        lcr.m_c1 = m_c1;
+        lcr.m_c2 += c2err();
+        v += std::norm(lcr.f0() - f0());
+        return sqrt(v);
+    }
+    double qValue() const {
+        return 2 * M_PI * f0() * l1() / r1();
+    }
+    //! Reflection
+    std::complex<double> rl(double omega, std::complex<double> zlcr1_inv) const {
+        auto zL =  1.0 / (std::complex<double>(0.0, omega * c2()) + zlcr1_inv) + r2();
+        return (zL - 50.0) / (zL + 50.0);
+    }
+    std::complex<double> rl(double omega) const {
+        return rl(omega, 1.0 / zlcr1(omega));
+    }
+    //! |Reflection| over a trace, in real arithmetic without branches to be vectorized.
+    //! \param omega_inv 1 / omega.
+    void rlpow(const double *omega, const double *omega_inv, size_t n, double *rlpow) const;
+    double rlerr(double omega) const {
+        double v = 0.0;
+        LCRFit lcr( *this);
+        lcr.m_c1 += c1err();
+        v += std::norm(lcr.rl(omega) - rl(omega));
+        lcr.m_c1 = m_c1;
+        lcr.m_c2 += c2err();
+        v += std::norm(lcr.rl(omega) - rl(omega));
+        return sqrt(v);
+    }
+    //! Obtains expected C1 and C2.
+    std::pair<double, double> tuneCaps(double target_freq) const {
+        return tuneCapsInternal(target_freq, 0.0, isCouplingTight());
+    }
+    void setTunedCaps(double target_freq, double target_rl, bool tight_couple) {
+        std::tie(m_c1, m_c2) = tuneCapsInternal(target_freq, target_rl, tight_couple);
+        m_tightCouple = tight_couple;
+    }
+private:
+    double rlpow(double omega) const {
+        return std::abs(rl(omega));
+    }
+    std::complex<double> zlcr1(double omega) const {
+        return std::complex<double>(r1(), omega * l1() - 1.0 / (omega * c1()));
+    }
+    static double isigma(double domega, double omega_trust) {
+//        return 1.0/(pow(rlpow0, 0.5 / POW_ON_FIT) + 0.1) / exp( fabs(domega) / omega_trust / 3);
+//        return sqrt(exp( -std::norm(domega / omega_trust) / 2.0) / (sqrt(2 * M_PI)  * omega_trust)); //a weight during the fit.
+        return sqrt(1.0 / (M_PI * omega_trust * (1.0 + std::norm(domega / omega_trust)))); //a weight during the fit.
+    }
+    std::pair<double, double> tuneCapsInternal(double target_freq, double target_rl0, bool tight_couple) const;
+    double m_r1, m_r2, m_l1;
+    double m_c1, m_c2;
+    double m_c1_err, m_c2_err;
+    double m_resErr;
+    bool m_tightCouple;
+};
+
+#endif // LCRFIT_H
@@ -12,6 +12,7 @@ DEPENDPATH += $$OUT_PWD/../../kame
 
 HEADERS += \
     autolctuner.h \
+    lcrfit.h \
     nmrfspectrum.h \
     nmrpulse.h \
     nmrrelax.h \
@@ -25,6 +26,7 @@ HEADERS += \
 
 SOURCES += \
     autolctuner.cpp \
+    lcrfit.cpp \
     nmrfspectrum.cpp \
     nmrpulse.cpp \
     nmrrelax.cpp \
@@ -116,12 +116,18 @@ XNMRFSpectrum::onActiveChanged(const Snapshot &shot, XValueNodeBase *) {
         m_lastFreqAcquired = -1000.0;
         m_tunedFreq = -1000.0;
         m_lastCycle = 0;
+        m_timeSweepStarted = XTime::now();
+        m_timeThroughputReported = m_timeSweepStarted;
+        m_sweepSteps = 0;
+        m_sweepAcquisitionTime = 0.0;
+        m_sweepRetuneTime = 0.0;
         double newf = getMinFreq(shot_this) * 1e-6; //MHz
         performTuning(shot_this, newf);
         newf += shot_this[ *sg1FreqOffset()];
 		shared_ptr<XSG> sg1__ = shot_this[ *sg1()];
 		if(sg1__)
 			trans( *sg1__->freq()) = newf;
+        m_timeRetuned = XTime::now();
 	}
     else
     	m_lsnOnTuningChanged.reset();
@@ -224,6 +230,11 @@ XNMRFSpectrum::rearrangeInstrum(const Snapshot &shot_this) {
     freq *= 1e-6; //MHz
     //sets new freq
 	if(shot_this[ *active()]) {
+        XTime time_captured = XTime::now();
+        if(m_timeRetuned) {
+            m_sweepAcquisitionTime += time_captured - m_timeRetuned;
+            ++m_sweepSteps;
+        }
 	    double cfreq = shot_this[ *centerFreq()]; //MHz
 		double freq_span = shot_this[ *freqSpan()] * 1e-3; //MHz
 		if(cfreq <= freq_span / 2) {
@@ -258,6 +269,7 @@ XNMRFSpectrum::rearrangeInstrum(const Snapshot &shot_this) {
                 m_lastCycle = 0;
                 newf += shot_this[ *freqStep()] * 1e-3; //shifted.
                 if((newf - getMinFreq(shot_this) * 1e-6) / freq_step > 0.99) {
+                    reportThroughput(shot_this, true);
                     trans( *active()) = false; //finish
                     return;
                 }
@@ -280,9 +292,27 @@ XNMRFSpectrum::rearrangeInstrum(const Snapshot &shot_this) {
         newf += shot_this[ *sg1FreqOffset()]; //modifies SG freq.
         if(sg1__)
             trans( *sg1__->freq()) = newf;
+        m_timeRetuned = XTime::now();
+        m_sweepRetuneTime += m_timeRetuned - time_captured;
+        reportThroughput(shot_this, false);
     }
 }
 void
+XNMRFSpectrum::reportThroughput(const Snapshot &shot_this, bool finished) {
+    XTime now = XTime::now();
+    if( !finished && (now - m_timeThroughputReported < 10.0))
+        return;
+    m_timeThroughputReported = now;
+    double elapsed = now - m_timeSweepStarted;
+    if( !m_sweepSteps || (elapsed <= 0.0))
+        return;
+    //Analysis overlaps the acquisition of the next step.
+    m_statusPrinter->printMessage(getLabel() + " " + formatString(
+        "%.0f steps/h: acquisition %.0f%%, SG/tuning %.0f%%, analysis %.0f%% in parallel.",
+        m_sweepSteps / elapsed * 3600.0, 100.0 * m_sweepAcquisitionTime / elapsed,
+        100.0 * m_sweepRetuneTime / elapsed, 100.0 * shot_this[ *this].analysisTime() / elapsed), false);
+}
+void
 XNMRFSpectrum::onTuningChanged(const Snapshot &shot, XValueNodeBase *) {
     Snapshot shot_this( *this);
     shared_ptr<XPulser> pulser__ = shot_this[ *pulser()];
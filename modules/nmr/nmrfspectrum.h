@@ -43,6 +43,8 @@ protected:
         XDriver *emitter) const override;
 
     virtual void rearrangeInstrum(const Snapshot &shot) override;
+    //! The SG is retuned as soon as a record is captured during a sweep.
+    virtual bool isPipelined(const Snapshot &shot_this) const override {return shot_this[ *active()];}
 public:
 	//! driver specific part below 
 	const shared_ptr<XItemNode<XDriverList, XSG> > &sg1() const {return m_sg1;}
@@ -86,6 +88,12 @@ private:
     double m_lastFreqAcquired; //!< to avoid inifite averaging after a sweep.
     double m_tunedFreq;
     int m_lastCycle; //!< 0-7
+
+    //! Reports steps/hour and a breakdown of the elapsed time in the sweep.
+    void reportThroughput(const Snapshot &shot_this, bool finished);
+    XTime m_timeSweepStarted, m_timeRetuned, m_timeThroughputReported;
+    unsigned int m_sweepSteps = 0;
+    double m_sweepAcquisitionTime = 0.0, m_sweepRetuneTime = 0.0; //!< [s].
 };
 
 
@@ -57,9 +57,11 @@ XNMRPulseAnalyzer::XNMRPulseAnalyzer(const char *name, bool runtime,
 		m_pulser(create<XItemNode<XDriverList, XPulser> >("Pulser", false, ref(tr_meas), meas->drivers(), true)),
         m_form(new FrmNMRPulse),
 		m_statusPrinter(XStatusPrinter::create(m_form.get())),
-        m_spectrumForm(new FrmGraphNURL(m_form.get(), Qt::Window)), m_waveGraph(create<XWaveNGraph>("Wave", true,
+        m_spectrumForm(new FrmGraphNURL(m_form.get(), Qt::Window)),
+        m_echoForm(new FrmGraphNURL(m_form.get(), Qt::Window)), m_waveGraph(create<XWaveNGraph>("Wave", true,
             m_form->m_graph, m_form->m_edDump, m_form->m_tbDump, m_form->m_btnDump)),
 		m_ftWaveGraph(create<XWaveNGraph>("Spectrum", true, m_spectrumForm.get())),
+		m_echoGraph(create<XWaveNGraph>("EchoTrain", true, m_echoForm.get())),
 		m_solver(create<SpectrumSolverWrapper>("SpectrumSolverWrapper", true, m_solverList, m_windowFunc, m_windowWidth)),
 		m_solverPNR(create<SpectrumSolverWrapper>("PNRSpectrumSolverWrapper", true, m_pnrSolverList, shared_ptr<XComboNode>(), shared_ptr<XDoubleNode>(), true)) {
     m_form->m_btnAvgClear->setIcon(QApplication::style()->standardIcon(QStyle::SP_DialogResetButton));
@@ -87,6 +89,7 @@ XNMRPulseAnalyzer::XNMRPulseAnalyzer(const char *name, bool runtime,
 	m_form->setWindowTitle(i18n("NMR Pulse - ") + getLabel() );
 
 	m_spectrumForm->setWindowTitle(i18n("NMR-Spectrum - ") + getLabel() );
+	m_echoForm->setWindowTitle(i18n("NMR-Echo Train - ") + getLabel() );
 
     //Ranges should be preset in prior to connectors.
     m_form->m_dblWindowWidth->setRange(3.0, 200.0);
@@ -191,6 +194,20 @@ XNMRPulseAnalyzer::XNMRPulseAnalyzer(const char *name, bool runtime,
 		}
 		tr[ *ftWaveGraph()].clearPoints();
     });
+    echoGraph()->iterate_commit([=](Transaction &tr){
+		//before PNR, see Payload::echoAmplitudes().
+		const char *labels[] = { "Time [ms]", "Re. [V]", "Im. [V]", "Abs. [V]" };
+		tr[ *echoGraph()].setColCount(4, labels);
+		tr[ *echoGraph()].insertPlot(labels[3], 0, 3);
+		tr[ *echoGraph()].insertPlot(labels[1], 0, 1);
+		tr[ *echoGraph()].insertPlot(labels[2], 0, 2);
+		tr[ *tr[ *echoGraph()].axisy()->label()] = i18n("Echo Intens. w/o PNR [V]");
+		tr[ *tr[ *echoGraph()].plot(0)->label()] = i18n("abs.");
+		tr[ *tr[ *echoGraph()].plot(1)->label()] = i18n("re.");
+		tr[ *tr[ *echoGraph()].plot(2)->label()] = i18n("im.");
+        tr[ *echoGraph()->graph()->persistence()] = 0.0;
+		tr[ *echoGraph()].clearPoints();
+    });
 
 	iterate_commit([=](Transaction &tr){
 		m_lsnOnAvgClear = tr[ *m_avgClear].onTouch().connectWeakly(
@@ -224,55 +241,47 @@ XNMRPulseAnalyzer::~XNMRPulseAnalyzer() {
 void XNMRPulseAnalyzer::onSpectrumShow(const Snapshot &shot, XTouchableNode *) {
     m_spectrumForm->showNormal();
 	m_spectrumForm->raise();
+	if(Snapshot( *this)[ *numEcho()] > 1) {
+		m_echoForm->showNormal();
+		m_echoForm->raise();
+	}
 }
 void XNMRPulseAnalyzer::showForms() {
     m_form->showNormal();
 	m_form->raise();
 }
 
-void XNMRPulseAnalyzer::backgroundSub(Transaction &tr,
+void XNMRPulseAnalyzer::periodicNoiseReduction(Transaction &tr,
 	std::vector<std::complex<double> > &wave,
-	int pos, int length, int bgpos, int bglength) {
-	Snapshot &shot(tr);
-
-	std::complex<double> bg = 0;
-	if(bglength) {
-		double normalize = 0.0;
-		for(int i = 0; i < bglength; i++) {
-			double z = 1.0;
-			if( !shot[ *usePNR()])
-				z = FFT::windowFuncHamming( (double)i / bglength - 0.5);
-			bg += z * wave[pos + i + bgpos];
-			normalize += z;
-		}
-		bg /= normalize;
-	}
-
-	for(int i = 0; i < wave.size(); i++) {
-		wave[i] -= bg;
-	}
-
+	int pos, int length, int bgpos, int bglength, int numechoes, int echoperiod) {
 	SpectrumSolver &solverPNR(tr[ *m_solverPNR].solver());
-	if(bglength) {
-		if(shot[ *usePNR()]) {
-			int dnrlength = FFT::fitLength((bglength + bgpos) * 4);
-			std::vector<std::complex<double> > memin(bglength), memout(dnrlength);
-			for(unsigned int i = 0; i < bglength; i++) {
-				memin[i] = wave[pos + i + bgpos];
-			}
-			try {
-				solverPNR.exec(memin, memout, bgpos, 0.5e-2, &FFT::windowFuncRect, 1.0);
-				int imax = std::min((int)wave.size() - pos, (int)memout.size());
-				for(unsigned int i = 0; i < imax; i++) {
-					wave[i + pos] -= solverPNR.ifft()[i];
+	int dnrlength = FFT::fitLength((bglength + bgpos) * 4);
+	std::vector<std::complex<double> > memin(bglength), memout(dnrlength);
+	for(unsigned int i = 0; i < bglength; i++) {
+		memin[i] = wave[pos + i + bgpos];
+	}
+	try {
+		solverPNR.exec(memin, memout, bgpos, 0.5e-2, &FFT::windowFuncRect, 1.0);
+		const std::vector<std::complex<double> > &model(solverPNR.ifft());
+		int imax = std::min((int)wave.size() - pos, (int)memout.size());
+		for(unsigned int i = 0; i < imax; i++) {
+			std::complex<double> z = model[i];
+			if((numechoes > 1) && (i < length)) {
+				//the averaged echo.
+				for(int k = 1; k < numechoes; k++) {
+					int j = i + k * echoperiod;
+					if(j < (int)model.size())
+						z += model[j];
 				}
+				z /= (double)numechoes;
 			}
-			catch (XKameError &e) {
-				e.print();
-//				throw XSkippedRecordError(e.msg(), __FILE__, __LINE__);
-			}
+			wave[i + pos] -= z;
 		}
 	}
+	catch (XKameError &e) {
+		e.print();
+//				throw XSkippedRecordError(e.msg(), __FILE__, __LINE__);
+	}
 }
 void XNMRPulseAnalyzer::rotNFFT(Transaction &tr, int ftpos, double ph,
 	std::vector<std::complex<double> > &wave,
@@ -469,8 +478,13 @@ void XNMRPulseAnalyzer::analyze(Transaction &tr, const Snapshot &shot_emitter,
 	if(length > (int)shot_this[ *this].m_waveSum.size()) {
 		avgclear = true;
 	}
+	if(numechoes != (int)shot_this[ *this].m_echoAmpsSum.size()) {
+		avgclear = true;
+	}
 	tr[ *this].m_wave.resize(length);
 	tr[ *this].m_waveSum.resize(length);
+	tr[ *this].m_echoAmps.resize(numechoes);
+	tr[ *this].m_echoAmpsSum.resize(numechoes);
 	int fftlen = FFT::fitLength(shot_this[ *fftLen()]);
 	if(fftlen != shot_this[ *this].m_darkPSD.size()) {
 		avgclear = true;		
@@ -501,6 +515,7 @@ void XNMRPulseAnalyzer::analyze(Transaction &tr, const Snapshot &shot_emitter,
 	if(avgclear) {
 		std::fill(tr[ *this].m_waveSum.begin(), tr[ *this].m_waveSum.end(), std::complex<double>(0.0));
 		std::fill(tr[ *this].m_darkPSDSum.begin(), tr[ *this].m_darkPSDSum.end(), 0.0);
+		std::fill(tr[ *this].m_echoAmpsSum.begin(), tr[ *this].m_echoAmpsSum.end(), std::complex<double>(0.0));
 		tr[ *this].m_avcount = 0;
 		if(shot_this[ *exAvgIncr()]) {
 			tr[ *extraAvg()] = 0;
@@ -524,23 +539,32 @@ void XNMRPulseAnalyzer::analyze(Transaction &tr, const Snapshot &shot_emitter,
 	}
 	tr[ *this].m_dsoWaveStartPos = pos;
 
-	//Background subtraction or dynamic noise reduction
-	if(bg_after_last_echo)
-		backgroundSub(tr, tr[ *this].m_dsoWave, pos, length, bgpos, bglength);
-	for(int i = 1; i < numechoes; i++) {
-		int rpos = pos + i * echoperiod;
-		for(int j = 0;
-		j < ( !bg_after_last_echo ? std::max(bgpos + bglength, length) : length); j++) {
-			int k = rpos + j;
-			assert(k < dso_len);
-			if(i == 1)
-				dsowave[pos + j] /= (double)numechoes;
-			dsowave[pos + j] += dsowave[k] / (double)numechoes;
-		}
-	}
-	//Background subtraction or dynamic noise reduction
-	if( !bg_after_last_echo)
-		backgroundSub(tr, tr[ *this].m_dsoWave, pos, length, bgpos, bglength);
+	//Averages the echoes, followed by background subtraction.
+	int sumlength = bg_after_last_echo ? length : std::max(bgpos + bglength, length);
+	FFT::twindowfunc bgfunc = shot_this[ *usePNR()] ? &FFT::windowFuncRect : &FFT::windowFuncHamming;
+	if( !shot_this[ *this].m_echoTrain ||
+		(shot_this[ *this].m_echoTrain->numEchoes() != numechoes) ||
+		(shot_this[ *this].m_echoTrain->period() != echoperiod) ||
+		(shot_this[ *this].m_echoTrain->length() != sumlength) ||
+		(shot_this[ *this].m_echoTrain->echoLength() != length) ||
+		(shot_this[ *this].m_echoTrain->bgPos() != bgpos) ||
+		(shot_this[ *this].m_echoTrain->bgLength() != bglength) ||
+		(shot_this[ *this].m_echoTrain->bgFunc() != bgfunc)) {
+		tr[ *this].m_echoTrain.reset(new EchoTrain(numechoes, echoperiod, sumlength, length,
+			bgpos, bglength, bgfunc));
+	}
+	std::vector<std::complex<double> > echoamps(numechoes, 0.0);
+	std::complex<double> bg = shot_this[ *this].m_echoTrain->exec( &dsowave[pos], &echoamps[0]);
+	//The rest, for display and PNR.
+	for(int i = 0; i < pos; i++)
+		dsowave[i] -= bg;
+	for(int i = pos + sumlength; i < dso_len; i++)
+		dsowave[i] -= bg;
+	//Dynamic noise reduction
+	//The echoes have been averaged before the noise in the background after the last echo is modeled.
+	if(bglength && shot_this[ *usePNR()])
+		periodicNoiseReduction(tr, tr[ *this].m_dsoWave, pos, length, bgpos, bglength,
+			bg_after_last_echo ? numechoes : 1, echoperiod);
 
 	std::complex<double> *wavesum( &tr[ *this].m_waveSum[0]);
 	double *darkpsdsum( &tr[ *this].m_darkPSDSum[0]);
@@ -549,47 +573,17 @@ void XNMRPulseAnalyzer::analyze(Transaction &tr, const Snapshot &shot_emitter,
 		for(int i = 0; i < length; i++) {
 			wavesum[i] += dsowave[pos + i];
 		}
+		for(int i = 0; i < numechoes; i++) {
+			tr[ *this].m_echoAmpsSum[i] += echoamps[i];
+		}
 		if(bglength) {
 			//Estimates power spectral density in the background.
-			if( !shot_this[ *this].m_ftDark ||
-				(shot_this[ *this].m_ftDark->length() != shot_this[ *this].m_darkPSD.size())) {
-				tr[ *this].m_ftDark.reset(new FFT(-1, shot_this[ *fftLen()]));
-			}
-			std::vector<std::complex<double> > darkin(fftlen, 0.0), darkout(fftlen);
-			int bginplen = std::min(bglength, fftlen);
-			double normalize = 0.0;
-			//Twists background not to be affected by the dc subtraction.
-			for(int i = 0; i < bginplen; i++) {
-				double tw = sin(2.0*M_PI*i/(double)bginplen);
-				darkin[i] = dsowave[pos + i + bgpos] * tw;
-				normalize += tw * tw;
-			}
-			normalize = 1.0 / normalize * interval;
-			tr[ *this].m_ftDark->exec(darkin, darkout);
-			//Convolution for the rectangular window.
-			for(int i = 0; i < fftlen; i++) {
-				darkin[i] = std::norm(darkout[i]) * normalize;
-			}
-			tr[ *this].m_ftDark->exec(darkin, darkout); //FT of PSD.
-			std::vector<std::complex<double> > sigma2(darkout);
-			std::fill(darkin.begin(), darkin.end(), std::complex<double>(0.0));
-			double x = sqrt(1.0 / length / fftlen);
-			for(int i = 0; i < length; i++) {
-				darkin[i] = x;
-			}
-			tr[ *this].m_ftDark->exec(darkin, darkout); //FT of rect. window.
-			for(int i = 0; i < fftlen; i++) {
-				darkin[i] = std::norm(darkout[i]);
-			}
-			tr[ *this].m_ftDark->exec(darkin, darkout); //FT of norm of (FT of rect. window).
-			for(int i = 0; i < fftlen; i++) {
-				darkin[i] = std::conj(darkout[i] * sigma2[i]);
-			}
-			tr[ *this].m_ftDark->exec(darkin, darkout); //Convolution.
-			normalize = 1.0 / fftlen;
-			for(int i = 0; i < fftlen; i++) {
-				darkpsdsum[i] += std::real(darkout[i]) * normalize; //[V^2/Hz]
+			if( !shot_this[ *this].m_darkPSDEngine ||
+				(shot_this[ *this].m_darkPSDEngine->fftLength() != fftlen) ||
+				(shot_this[ *this].m_darkPSDEngine->windowLength() != length)) {
+				tr[ *this].m_darkPSDEngine.reset(new DarkPSD(fftlen, length));
 			}
+			tr[ *this].m_darkPSDEngine->accumulate( &dsowave[pos + bgpos], bglength, interval, darkpsdsum);
 		}
 		tr[ *this].m_avcount++;
 		if( shot_this[ *exAvgIncr()]) {
@@ -601,6 +595,9 @@ void XNMRPulseAnalyzer::analyze(Transaction &tr, const Snapshot &shot_emitter,
 	for(int i = 0; i < length; i++) {
 		wave[i] = wavesum[i] * normalize;
 	}
+	for(int i = 0; i < numechoes; i++) {
+		tr[ *this].m_echoAmps[i] = shot_this[ *this].m_echoAmpsSum[i] * normalize;
+	}
 	double darknormalize = normalize * normalize;
 	if(bg_after_last_echo)
 		darknormalize /= (double)numechoes;
@@ -650,6 +647,7 @@ void XNMRPulseAnalyzer::visualize(const Snapshot &shot) {
 
 		tr[ *ftWaveGraph()].clearPoints();
 		tr[ *waveGraph()].clearPoints();
+		tr[ *echoGraph()].clearPoints();
 		tr[ *m_peakPlot->maxCount()] = 0;
         return true;
     });
@@ -700,15 +698,33 @@ void XNMRPulseAnalyzer::visualize(const Snapshot &shot) {
         const std::vector<std::pair<double, double> > &peaks(solver.peaks());
 		int peaks_size = peaks.size();
 		tr[ *m_peakPlot->maxCount()] = peaks_size;
-        auto &points(tr[ *m_peakPlot].points());
-		points.resize(peaks_size);
+        auto &peakplot(tr[ *m_peakPlot]);
+		peakplot.clearPoints();
 		for(int i = 0; i < peaks_size; i++) {
 			double x = peaks[i].second;
 			x = (x > ftsize / 2) ? (x - ftsize) : x;
-			points[i] = XGraph::ValPoint(0.001 * x * dfreq, peaks[i].first * normalize);
+			peakplot.appendPoint(XGraph::ValPoint(0.001 * x * dfreq, peaks[i].first * normalize));
 		}
 		ftWaveGraph()->drawGraph(tr);
 
+		//echoes at the centers of the windows.
+		const std::vector<std::complex<double> > &echoamps(shot[ *this].echoAmplitudes());
+		int numechoes = (echoamps.size() > 1) ? echoamps.size() : 0;
+		double echotime = (shot[ *this].startTime() + 0.5 * shot[ *this].waveWidth() * shot[ *this].interval()) * 1e3;
+		tr[ *echoGraph()].setRowCount(numechoes);
+        std::vector<float> colet(numechoes), coler(numechoes), colei(numechoes), coleabs(numechoes);
+		for(int i = 0; i < numechoes; i++) {
+			coler[i] = std::real(echoamps[i]);
+			colei[i] = std::imag(echoamps[i]);
+			coleabs[i] = std::abs(echoamps[i]);
+			colet[i] = echotime + i * shot[ *echoPeriod()];
+		}
+        tr[ *echoGraph()].setColumn(0, std::move(colet), 7);
+        tr[ *echoGraph()].setColumn(1, std::move(coler), 5);
+        tr[ *echoGraph()].setColumn(2, std::move(colei), 5);
+        tr[ *echoGraph()].setColumn(3, std::move(coleabs), 5);
+        echoGraph()->drawGraph(tr);
+
 		int length = shot[ *this].m_dsoWave.size();
 		const std::complex<double> *dsowave( &shot[ *this].m_dsoWave[0]);
         if(solver.ifft().size() < ftsize)
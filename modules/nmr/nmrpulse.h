@@ -21,6 +21,7 @@
 #include <complex>
 //---------------------------------------------------------------------------
 #include "nmrspectrumsolver.h"
+#include "echotrain.h"
 #include "xwavengraph.h"
 
 class Ui_FrmNMRPulse;
@@ -69,6 +70,11 @@ public:
 		int waveFTPos() const {return m_waveFTPos;}
 		//! Length of FT.
 		int ftWidth() const {return m_ftWave.size();}
+		//! Complex amplitudes of the individual echoes, the means over wave(),
+		//! before the digital IF, the phase advance, and the periodic-noise reduction.
+		//! Hence, periodic noise is not removed from them even if usePNR() is set.
+		//! Shown in the echo-train graph if numEcho() > 1.
+		const std::vector<std::complex<double> > &echoAmplitudes() const {return m_echoAmps;}
 	private:
 		friend class XNMRPulseAnalyzer;
 		std::vector<std::complex<double> > m_wave;
@@ -85,13 +91,16 @@ public:
 		//! Stored Waves for avg.
 		std::vector<std::complex<double> > m_waveSum;
 		std::vector<double> m_darkPSDSum;
+		std::vector<std::complex<double> > m_echoAmps, m_echoAmpsSum;
 		//! time resolution
 		double m_interval;
 		//! time diff. of the first point from trigger
 		double m_startTime;
 
-		//for FFT/MEM.
-		shared_ptr<FFT> m_ftDark;
+		//! Kept until fftLen or the window length changes.
+		shared_ptr<DarkPSD> m_darkPSDEngine;
+		//! Kept until the multi-echo or background settings change.
+		shared_ptr<EchoTrain> m_echoTrain;
 
 		XTime m_timeClearRequested;
 	};
@@ -150,6 +159,8 @@ private:
 	const shared_ptr<XWaveNGraph> &waveGraph() const {return m_waveGraph;}
 	/// Stored FFT Wave for display.
 	const shared_ptr<XWaveNGraph> &ftWaveGraph() const {return m_ftWaveGraph;}
+	/// Amplitudes of the individual echoes for display.
+	const shared_ptr<XWaveNGraph> &echoGraph() const {return m_echoGraph;}
 
 	const shared_ptr<XScalarEntry> m_entryPeakAbs; 
 	const shared_ptr<XScalarEntry> m_entryPeakFreq; 
@@ -193,9 +204,11 @@ private:
 	const qshared_ptr<FrmNMRPulse> m_form;
 	const shared_ptr<XStatusPrinter> m_statusPrinter;
 	const qshared_ptr<FrmGraphNURL> m_spectrumForm;
+	const qshared_ptr<FrmGraphNURL> m_echoForm;
 
 	const shared_ptr<XWaveNGraph> m_waveGraph;
 	const shared_ptr<XWaveNGraph> m_ftWaveGraph;
+	const shared_ptr<XWaveNGraph> m_echoGraph;
   
 	//for FFT/MEM.
 	shared_ptr<SpectrumSolverWrapper> m_solver;
@@ -206,8 +219,12 @@ private:
 	void onSpectrumShow(const Snapshot &shot, XTouchableNode *);
 	void onAvgClear(const Snapshot &shot, XTouchableNode *);
   
-	void backgroundSub(Transaction &tr,
-		std::vector<std::complex<double> > &wave, int pos, int length, int bgpos, int bglength);
+	//! Subtracts a model of periodic noise fitted to the background.
+	//! \param numechoes if > 1, the model is averaged over the echoes within [pos, pos + length),
+	//! where the echoes have been averaged.
+	void periodicNoiseReduction(Transaction &tr,
+		std::vector<std::complex<double> > &wave, int pos, int length, int bgpos, int bglength,
+		int numechoes, int echoperiod);
   
 	void rotNFFT(Transaction &tr, int ftpos, double ph,
 				 std::vector<std::complex<double> > &wave, std::vector<std::complex<double> > &ftwave);
@@ -358,24 +358,23 @@ XNMRT1::onCondChanged(const Snapshot &shot, XValueNodeBase *node) {
 void
 XNMRT1::analyzeSpectrum(Transaction &tr,
 	const std::vector< std::complex<double> >&wave, int origin, double cf,
-	std::deque<std::complex<double> > &value_by_cond) {
-	const Snapshot &shot_this(tr);
+	std::vector<std::complex<double> > &value_by_cond, uint64_t first_stamp) {
+	auto &cache_map(tr[ *this].m_convolutionCache);
+	auto &lru(tr[ *this].m_convolutionLRU);
+	auto &conds(tr[ *this].m_convolutionConds);
+	uint64_t &stamp(tr[ *this].m_convolutionCacheStamp);
 
 	value_by_cond.clear();
+	conds.clear();
 	std::deque<FFT::twindowfunc> funcs;
 	m_solver->windowFuncs(funcs);
 
-	int idx = 0;
 	for(std::deque<double>::const_iterator wit = m_windowWidthList.begin(); wit != m_windowWidthList.end(); wit++) {
 		for(std::deque<FFT::twindowfunc>::iterator fit = funcs.begin(); fit != funcs.end(); fit++) {
-			if(shot_this[ *this].m_convolutionCache.size() <= idx) {
-				tr[ *this].m_convolutionCache.push_back(
-                    std::make_shared<Payload::ConvolutionCache>());
-			}
-			shared_ptr<Payload::ConvolutionCache> cache = tr[ *this].m_convolutionCache[idx];
-			if((cache->windowwidth != *wit) || (cache->origin != origin) ||
-				(cache->windowfunc != *fit) || (cache->cfreq != cf) ||
-				(cache->wave.size() != wave.size())) {
+			Payload::ConvolutionKey key = {*wit, *fit, origin, cf, (unsigned int)wave.size()};
+			auto it = cache_map.find(key);
+			if(it == cache_map.end()) {
+				auto cache = std::make_shared<Payload::ConvolutionCache>();
 				cache->windowwidth = *wit;
 				cache->origin = origin;
 				cache->windowfunc = *fit;
@@ -388,19 +387,37 @@ XNMRT1::analyzeSpectrum(Transaction &tr,
 					cache->wave[i] = std::polar(w, -2.0*M_PI*cf*(i - origin));
 					cache->power += w*w;
 				}
+				it = cache_map.insert(std::make_pair(key, Payload::ConvolutionEntry{cache, 0})).first;
+				tr[ *this].m_convolutionCacheBytes += cache->wave.size() * sizeof(std::complex<double>);
 			}
+			else
+				lru.erase(it->second.lastUsed);
+			it->second.lastUsed = ++stamp;
+			lru.insert(std::make_pair(stamp, key));
+			const shared_ptr<const Payload::ConvolutionCache> &cache(it->second.cache);
 
 			std::complex<double> z(0.0);
+			const std::complex<double> *pw = wave.data(), *pk = cache->wave.data();
 			for(int i = 0; i < (int)cache->wave.size(); i++) {
-				z += wave[i] * cache->wave[i];
+				z += pw[i] * pk[i];
 			}
 
 //			m_solver->solver()->exec(wave, fftout, -origin, 0.0, *fit, *wit);
 //			value_by_cond.push_back(fftout[(cf + fftlen) % fftlen]);
 			value_by_cond.push_back(z);
-			idx++;
+			conds.push_back(cache);
 		}
 	}
+	//Evicts the least recently used kernels, keeping the ones in use.
+	while((tr[ *this].m_convolutionCacheBytes > CONVOLUTION_CACHE_BYTES) && !lru.empty()) {
+		auto oldest = lru.begin();
+		if(oldest->first >= first_stamp)
+			break;
+		auto it = cache_map.find(oldest->second);
+		tr[ *this].m_convolutionCacheBytes -= it->second.cache->wave.size() * sizeof(std::complex<double>);
+		cache_map.erase(it);
+		lru.erase(oldest);
+	}
 }
 bool
 XNMRT1::checkDependency(const Snapshot &shot_this,
@@ -495,7 +512,7 @@ XNMRT1::analyze(Transaction &tr, const Snapshot &shot_emitter, const Snapshot &s
 			throw XSkippedRecordError(__FILE__, __LINE__);
 		}
 
-		std::deque<std::complex<double> > cmp1, cmp2;
+		std::vector<std::complex<double> > cmp1, cmp2;
         double cfreq = shot_this[ *freq()] * 1e3 * shot_pulse1[ *pulse1__].interval();
         if(shot_this[ *trackPeak()]) {
             if(((mode__ == MEAS_T1) && (shot_pulser[ *pulser__].combP1() > distributeP1(shot_this, 0.66))) ||
@@ -506,42 +523,58 @@ XNMRT1::analyze(Transaction &tr, const Snapshot &shot_emitter, const Snapshot &s
             }
         }
 
+		//kernels used by both the pulses from now on are kept.
+		const uint64_t first_stamp = shot_this[ *this].m_convolutionCacheStamp + 1;
 		analyzeSpectrum(tr, shot_pulse1[ *pulse1__].wave(),
-			shot_pulse1[ *pulse1__].waveFTPos(), cfreq, cmp1);        
-        Payload::RawPt pt1, pt2;
+			shot_pulse1[ *pulse1__].waveFTPos(), cfreq, cmp1, first_stamp);
         if(pulse2__) {
 			analyzeSpectrum(tr, shot_pulse2[ *pulse2__].wave(),
-				shot_pulse2[ *pulse2__].waveFTPos(), cfreq, cmp2);
-			pt2.value_by_cond.resize(cmp2.size());
+				shot_pulse2[ *pulse2__].waveFTPos(), cfreq, cmp2, first_stamp);
+		}
+		auto &pts_p1(tr[ *this].m_ptsP1);
+		auto &pts_values(tr[ *this].m_ptsValues);
+		std::vector<std::pair<double, FFT::twindowfunc> > pts_conds;
+		for(auto &&c: shot_this[ *this].m_convolutionConds)
+			pts_conds.push_back(std::make_pair(c->windowwidth, c->windowfunc));
+		if(shot_this[ *this].m_ptsConds != pts_conds) {
+			//Conditions have changed, remapping the points to the new ones. Values for new conditions are zero.
+			const auto &old_conds(shot_this[ *this].m_ptsConds);
+			std::vector<std::complex<double> > values(pts_p1.size() * pts_conds.size());
+			for(unsigned int i = 0; i < pts_conds.size(); i++) {
+				auto cit = std::find(old_conds.begin(), old_conds.end(), pts_conds[i]);
+				if(cit == old_conds.end())
+					continue;
+				unsigned int i_old = cit - old_conds.begin();
+				for(unsigned int j = 0; j < pts_p1.size(); j++)
+					values[j * pts_conds.size() + i] = pts_values[j * old_conds.size() + i_old];
+			}
+			pts_values.swap(values);
+			tr[ *this].m_ptsConds = std::move(pts_conds);
 		}
-        pt1.value_by_cond.resize(cmp1.size());
 		switch(shot_pulser[ *pulser__].combMode()) {
         default:
 			throw XRecordError(i18n("Unknown Comb Mode!"), __FILE__, __LINE__);
         case XPulser::N_COMB_MODE_COMB_ALT:
 			if(mode__ != MEAS_T1) throw XRecordError(i18n("Use T1 mode!"), __FILE__, __LINE__);
 			assert(pulse2__);
-            pt1.p1 = shot_pulser[ *pulser__].combP1();
             for(int i = 0; i < cmp1.size(); i++)
-            	pt1.value_by_cond[i] = (cmp1[i] - cmp2[i]) / cmp1[i];
-            tr[ *this].m_pts.push_back(pt1);
+            	cmp1[i] = (cmp1[i] - cmp2[i]) / cmp1[i];
+            pts_p1.push_back(shot_pulser[ *pulser__].combP1());
+            pts_values.insert(pts_values.end(), cmp1.begin(), cmp1.end());
             break;
         case XPulser::N_COMB_MODE_P1_ALT:
 			if(mode__ == MEAS_T2)
                 throw XRecordError(i18n("Do not use T2 mode!"), __FILE__, __LINE__);
 			assert(pulse2__);
-            pt1.p1 = shot_pulser[ *pulser__].combP1();
-            std::copy(cmp1.begin(), cmp1.end(), pt1.value_by_cond.begin());
-            tr[ *this].m_pts.push_back(pt1);
-            pt2.p1 = shot_pulser[ *pulser__].combP1Alt();
-            std::copy(cmp2.begin(), cmp2.end(), pt2.value_by_cond.begin());
-            tr[ *this].m_pts.push_back(pt2);
+            pts_p1.push_back(shot_pulser[ *pulser__].combP1());
+            pts_values.insert(pts_values.end(), cmp1.begin(), cmp1.end());
+            pts_p1.push_back(shot_pulser[ *pulser__].combP1Alt());
+            pts_values.insert(pts_values.end(), cmp2.begin(), cmp2.end());
             break;
         case XPulser::N_COMB_MODE_ON:
 			if(mode__ != MEAS_T2) {
-                pt1.p1 = shot_pulser[ *pulser__].combP1();
-                std::copy(cmp1.begin(), cmp1.end(), pt1.value_by_cond.begin());
-                tr[ *this].m_pts.push_back(pt1);
+                pts_p1.push_back(shot_pulser[ *pulser__].combP1());
+                pts_values.insert(pts_values.end(), cmp1.begin(), cmp1.end());
                 break;
 			}
 			m_statusPrinter->printWarning(i18n("T2 mode with comb pulse!"));
@@ -551,9 +584,8 @@ XNMRT1::analyze(Transaction &tr, const Snapshot &shot_emitter, const Snapshot &s
 				throw XSkippedRecordError(__FILE__, __LINE__);
 			}
 			//T2 measurement
-            pt1.p1 = 2.0 * shot_pulser[ *pulser__].tau();
-            std::copy(cmp1.begin(), cmp1.end(), pt1.value_by_cond.begin());
-            tr[ *this].m_pts.push_back(pt1);
+            pts_p1.push_back(2.0 * shot_pulser[ *pulser__].tau());
+            pts_values.insert(pts_values.end(), cmp1.begin(), cmp1.end());
             break;
         }
     }
@@ -562,7 +594,8 @@ XNMRT1::analyze(Transaction &tr, const Snapshot &shot_emitter, const Snapshot &s
 
     if(shot_this[ *this].m_timeClearRequested) {
         tr[ *this].m_timeClearRequested = {};
-        tr[ *this].m_pts.clear();
+        tr[ *this].m_ptsP1.clear();
+        tr[ *this].m_ptsValues.clear();
 		tr[ *m_wave].clearPoints();
 		tr[ *m_fitStatus] = "";
 		trans( *pulse1__->avgClear()).touch();
@@ -578,46 +611,49 @@ XNMRT1::analyze(Transaction &tr, const Snapshot &shot_emitter, const Snapshot &s
 
 	tr[ *this].m_sumpts.resize(samples);
 	auto &sumpts(tr[ *this].m_sumpts);
+	const unsigned int num_conds = shot_this[ *this].m_ptsConds.size();
+	const auto &conds(shot_this[ *this].m_convolutionConds);
+	//Sums of the values for the conditions, [samples][num_conds].
+	std::vector<std::complex<double> > sum_values(samples * num_conds);
 
     {
 		Payload::Pt dummy;
 		dummy.c = 0; dummy.p1 = 0; dummy.isigma = 0;
-		dummy.value_by_cond.resize(shot_this[ *this].m_convolutionCache.size());
 		std::fill(tr[ *this].m_sumpts.begin(), tr[ *this].m_sumpts.end(), dummy);
         double k = shot_this[ *this].m_sumpts.size() / log(p1max/p1min);
-		auto pts_begin(shot_this[ *this].m_pts.begin());
-		auto pts_end(shot_this[ *this].m_pts.end());
+		const auto &pts_p1(shot_this[ *this].m_ptsP1);
+		const std::complex<double> *values = shot_this[ *this].m_ptsValues.data();
 		int sum_size = (int)shot_this[ *this].m_sumpts.size();
-		for(auto it = pts_begin; it != pts_end; it++) {
-            int idx = lrint(log(it->p1 / p1min) * k);
+		for(unsigned int j = 0; j < pts_p1.size(); j++, values += num_conds) {
+            int idx = lrint(log(pts_p1[j] / p1min) * k);
 			if((idx < 0) || (idx >= sum_size)) continue;
-			double p1 = it->p1;
+			double p1 = pts_p1[j];
 			//For St.E., T+tau = P1+3*tau.
 			if(mode__ == MEAS_ST_E)
 				p1 += 3 * shot_pulser[ *pulser__].tau() * 1e-3;
 			sumpts[idx].isigma += 1;
 			sumpts[idx].p1 += p1;
-			for(unsigned int i = 0; i < it->value_by_cond.size(); i++)
-				sumpts[idx].value_by_cond[i] += it->value_by_cond[i];
+			std::complex<double> *sum = &sum_values[idx * num_conds];
+			for(unsigned int i = 0; i < num_conds; i++)
+				sum[i] += values[i];
 		}
 	}
 
-	std::deque<std::complex<double> > sum_c(
-		shot_this[ *this].m_convolutionCache.size()), corr(shot_this[ *this].m_convolutionCache.size());
+	std::vector<std::complex<double> > sum_c(num_conds), corr(num_conds);
 	double sum_t = 0.0;
 	int n = 0;
-	for(auto it = shot_this[ *this].m_sumpts.begin();
-		it != shot_this[ *this].m_sumpts.end(); it++) {
-		if(it->isigma == 0) continue;
-        double t = log10(it->p1 / it->isigma);
-		for(unsigned int i = 0; i < it->value_by_cond.size(); i++) {
-			sum_c[i] += it->value_by_cond[i];
-			corr[i] += it->value_by_cond[i] * t;
+	for(unsigned int idx = 0; idx < sumpts.size(); idx++) {
+		if(sumpts[idx].isigma == 0) continue;
+        double t = log10(sumpts[idx].p1 / sumpts[idx].isigma);
+		const std::complex<double> *sum = &sum_values[idx * num_conds];
+		for(unsigned int i = 0; i < num_conds; i++) {
+			sum_c[i] += sum[i];
+			corr[i] += sum[i] * t;
 		}
-        sum_t += t * it->isigma;
-        n += it->isigma;
+        sum_t += t * sumpts[idx].isigma;
+        n += sumpts[idx].isigma;
 	}
-	if(n) {
+	if(n && (conds.size() == num_conds)) {
         //correlation for y_i * log(t_i)
 		for(unsigned int i = 0; i < corr.size(); i++) {
             corr[i] -= sum_c[i]*sum_t/(double)n;
@@ -635,7 +671,7 @@ XNMRT1::analyze(Transaction &tr, const Snapshot &shot_emitter, const Snapshot &s
 			}
 			if(shot_this[ *autoWindow()]) {
 				double sn2 = absfit__ ? std::abs(corr[i]) : std::real(corr[i] * std::polar(1.0, -phase_by_cond[i]));
-				sn2 = sn2 * sn2 / shot_this[ *this].m_convolutionCache[i]->power;
+				sn2 = sn2 * sn2 / conds[i]->power;
 				if(maxsn2 < sn2) {
 					maxsn2 = sn2;
 					cond = i;
@@ -644,9 +680,7 @@ XNMRT1::analyze(Transaction &tr, const Snapshot &shot_emitter, const Snapshot &s
 		}
 		if(cond < 0) {
 			cond = 0;
-			for(std::deque<shared_ptr<Payload::ConvolutionCache> >::const_iterator it
-				= shot_this[ *this].m_convolutionCache.begin();
-				it != shot_this[ *this].m_convolutionCache.end(); ++it) {
+			for(auto it = conds.begin(); it != conds.end(); ++it) {
 				if((m_windowWidthList[std::max(0, (int)shot_this[ *windowWidth()])] == ( *it)->windowwidth) &&
 					(m_solver->windowFunc(shot_this) == ( *it)->windowfunc)) {
 					break;
@@ -654,7 +688,7 @@ XNMRT1::analyze(Transaction &tr, const Snapshot &shot_emitter, const Snapshot &s
 				cond++;
 			}
 		}
-		if(cond >= (shot_this[ *this].m_convolutionCache.size())) {
+		if(cond >= conds.size()) {
 			throw XSkippedRecordError(__FILE__, __LINE__);
 		}
 		double ph = phase_by_cond[cond];
@@ -664,22 +698,23 @@ XNMRT1::analyze(Transaction &tr, const Snapshot &shot_emitter, const Snapshot &s
 		}
 		if(shot_this[ *autoWindow()]) {
 			for(unsigned int i = 0; i < m_windowWidthList.size(); i++) {
-				if(m_windowWidthList[i] == shot_this[ *this].m_convolutionCache[cond]->windowwidth)
+				if(m_windowWidthList[i] == conds[cond]->windowwidth)
 					tr[ *windowWidth()] = i;
 			}
 			std::deque<FFT::twindowfunc> funcs;
 			m_solver->windowFuncs(funcs);
 			for(unsigned int i = 0; i < funcs.size(); i++) {
-				if(funcs[i] == shot_this[ *this].m_convolutionCache[cond]->windowfunc)
+				if(funcs[i] == conds[cond]->windowfunc)
 					tr[ *windowFunc()] = i;
 			}
 			tr.unmark(m_lsnOnCondChanged); //avoiding recursive signaling.
 		}
 		std::complex<double> cph(std::polar(1.0, -phase_by_cond[cond]));
-		for(auto it = sumpts.begin(); it != sumpts.end(); it++) {
+		for(unsigned int idx = 0; idx < sumpts.size(); idx++) {
+			auto it = &sumpts[idx];
 			if(it->isigma == 0) continue;
 			it->p1 = it->p1 / it->isigma;
-			it->c =  it->value_by_cond[cond] * cph / (double)it->isigma;
+			it->c =  sum_values[idx * num_conds + cond] * cph / (double)it->isigma;
 			it->var = (absfit__) ? std::abs(it->c) : std::real(it->c);
 			it->isigma = sqrt(it->isigma);
 		}
@@ -20,6 +20,8 @@
 //#include "nmrpulse.h"
 //#include "nmrrelaxfit.h"
 #include <complex>
+#include <unordered_map>
+#include <map>
 
 #include "nmrspectrumsolver.h"
 
@@ -69,8 +71,8 @@ public:
 			std::complex<double> c;
 			double p1;
 			int isigma; /// weight
-			std::deque<std::complex<double> > value_by_cond;
 		};
+		//! Window kernel for a condition, a pair of window width and function.
 		struct ConvolutionCache {
 			std::vector<std::complex<double> > wave;
 			double windowwidth;
@@ -79,14 +81,45 @@ public:
 			double cfreq;
 			double power;
 		};
-		//! Raw measured points
-		struct RawPt {
-			std::deque<std::complex<double> > value_by_cond;
-			double p1;
+		struct ConvolutionKey {
+			double windowwidth;
+			FFT::twindowfunc windowfunc;
+			int origin;
+			double cfreq;
+			unsigned int length;
+			bool operator==(const ConvolutionKey &x) const {
+				return (windowwidth == x.windowwidth) && (windowfunc == x.windowfunc) &&
+					(origin == x.origin) && (cfreq == x.cfreq) && (length == x.length);
+			}
+		};
+		struct ConvolutionKeyHash {
+			size_t operator()(const ConvolutionKey &x) const {
+				size_t h = std::hash<double>()(x.windowwidth);
+				h = h * 31u + std::hash<FFT::twindowfunc>()(x.windowfunc);
+				h = h * 31u + std::hash<int>()(x.origin);
+				h = h * 31u + std::hash<double>()(x.cfreq);
+				return h * 31u + x.length;
+			}
+		};
+		struct ConvolutionEntry {
+			shared_ptr<const ConvolutionCache> cache;
+			uint64_t lastUsed;
 		};
-		std::deque<shared_ptr<ConvolutionCache> > m_convolutionCache;
+		//! Kernels for pulse analyzers, evicted in LRU order beyond CONVOLUTION_CACHE_BYTES.
+		std::unordered_map<ConvolutionKey, ConvolutionEntry, ConvolutionKeyHash> m_convolutionCache;
+		//! Keys of m_convolutionCache by the last use, the oldest first.
+		//! Stamps instead of list iterators, which would dangle in copies of the payload.
+		std::map<uint64_t, ConvolutionKey> m_convolutionLRU;
+		size_t m_convolutionCacheBytes = 0;
+		uint64_t m_convolutionCacheStamp = 0;
+		//! Kernels used in the last analysis, in the order of conditions.
+		std::vector<shared_ptr<const ConvolutionCache> > m_convolutionConds;
 		//! Stores all measured points.
-		std::deque<RawPt> m_pts;
+		std::vector<double> m_ptsP1;
+		//! Values of the points for the conditions, [# of points][m_ptsConds.size()].
+		std::vector<std::complex<double> > m_ptsValues;
+		//! Pairs of window width and function, for the columns of m_ptsValues.
+		std::vector<std::pair<double, FFT::twindowfunc> > m_ptsConds;
 		//! Stores reduced points to manage fitting and display.
 		std::vector<Pt> m_sumpts;
 		double m_params[3]; //!< fitting parameters; 1/T1, c, a; ex. f(t) = c*exp(-t/T1) + a
@@ -197,9 +230,10 @@ private:
 	void onP1CondChanged (const Snapshot &shot, XValueNodeBase *);
     std::deque<xqcon_ptr> m_conUIs;
 
+	//! \param first_stamp kernels used since this stamp are not evicted.
 	void analyzeSpectrum(Transaction &tr,
 		const std::vector< std::complex<double> >&wave, int origin, double cf,
-		std::deque<std::complex<double> > &value_by_cond);
+		std::vector<std::complex<double> > &value_by_cond, uint64_t first_stamp);
 
 	shared_ptr<SpectrumSolverWrapper> m_solver;
 
@@ -220,7 +254,7 @@ private:
 
 	atomic<int> m_isPulserControlRequested;
 
-	const static int CONVOLUTION_CACHE_SIZE = (3 * 10);
+	const static size_t CONVOLUTION_CACHE_BYTES = 64u * 1024u * 1024u;
 
 	const static char P1DIST_LINEAR[];
 	const static char P1DIST_LOG[];
@@ -18,6 +18,12 @@
 #include "nllsfit.h"
 //---------------------------------------------------------------------------
 
+void
+XRelaxFunc::relaxBatch(double *f, double *dfdt, const double *t, unsigned int n, double it1) {
+    for(unsigned int i = 0; i < n; ++i)
+        relax( &f[i], &dfdt[i], t[i], it1);
+}
+
 class XRelaxFuncPoly : public XRelaxFunc {
 public:
 //! define a term in a relaxation function
@@ -28,7 +34,12 @@ public:
     };
 
     XRelaxFuncPoly(const char *name, bool runtime, const Term *terms)
-        : XRelaxFunc(name, runtime), m_terms(terms) {
+        : XRelaxFunc(name, runtime), m_terms(terms), m_maxBit(0) {
+        for(const Term *term = m_terms; term->p != 0; term++) {
+            assert((term->p > 0) && (term->p < (1 << MAX_BITS)));
+            while(term->p >> (m_maxBit + 1))
+                m_maxBit++;
+        }
     }
     virtual ~XRelaxFuncPoly() {}
 
@@ -50,8 +61,52 @@ public:
         *f = 1.0 - rf;
         *dfdt = -rdf;
     }
+    //! Exponents are integers, so that all the terms are products of
+    //! exp(x), exp(2x), exp(4x), ..., with a single exp() per point.
+    virtual void relaxBatch(double *f, double *dfdt, const double *t, unsigned int n, double it1) override {
+        double pows[MAX_BITS][BLOCK_SIZE]; //exp(x * 2^b).
+        double e[BLOCK_SIZE];
+        for(unsigned int i0 = 0; i0 < n; i0 += BLOCK_SIZE) {
+            unsigned int len = std::min((unsigned int)BLOCK_SIZE, n - i0);
+            double *rf = f + i0, *rdf = dfdt + i0;
+            const double *tb = t + i0;
+            for(unsigned int i = 0; i < len; ++i) {
+                pows[0][i] = exp(std::min(5.0, -tb[i] * it1));
+                rf[i] = 0.0;
+                rdf[i] = 0.0;
+            }
+            for(unsigned int b = 1; b <= m_maxBit; ++b) {
+                for(unsigned int i = 0; i < len; ++i)
+                    pows[b][i] = pows[b - 1][i] * pows[b - 1][i];
+            }
+            for(const Term *term = m_terms; term->p != 0; term++) {
+                unsigned int b = 0;
+                while( !(term->p & (1 << b)))
+                    b++;
+                for(unsigned int i = 0; i < len; ++i)
+                    e[i] = pows[b][i];
+                for(b++; term->p >> b; b++) {
+                    if(term->p & (1 << b)) {
+                        for(unsigned int i = 0; i < len; ++i)
+                            e[i] *= pows[b][i];
+                    }
+                }
+                double a = term->a, ap = term->a * term->p;
+                for(unsigned int i = 0; i < len; ++i) {
+                    rf[i] += a * e[i];
+                    rdf[i] += ap * e[i];
+                }
+            }
+            for(unsigned int i = 0; i < len; ++i) {
+                rf[i] = 1.0 - rf[i];
+                rdf[i] *= tb[i];
+            }
+        }
+    }
 private:
+    enum {MAX_BITS = 7, BLOCK_SIZE = 256};
     const struct Term *m_terms;
+    unsigned int m_maxBit; //!< highest bit in the exponents.
 };
 //! Power exponential.
 class XRelaxFuncPowExp : public XRelaxFunc {
@@ -72,6 +127,32 @@ public:
         *f = 1.0 - a;
         *dfdt = t*rt/(t*it1)*m_pow * a;
     }
+    virtual void relaxBatch(double *f, double *dfdt, const double *t, unsigned int n, double it1) override {
+        it1 = std::max(0.0, it1);
+        //rt into dfdt.
+        if(m_pow == 1.0) {
+            for(unsigned int i = 0; i < n; ++i)
+                dfdt[i] = t[i] * it1;
+        }
+        else if(m_pow == 2.0) {
+            for(unsigned int i = 0; i < n; ++i)
+                dfdt[i] = (t[i] * it1) * (t[i] * it1);
+        }
+        else if(m_pow == 0.5) {
+            for(unsigned int i = 0; i < n; ++i)
+                dfdt[i] = sqrt(t[i] * it1);
+        }
+        else {
+            for(unsigned int i = 0; i < n; ++i)
+                dfdt[i] = pow(t[i] * it1, m_pow);
+        }
+        for(unsigned int i = 0; i < n; ++i) {
+            double rt = dfdt[i];
+            double a = exp(-rt);
+            f[i] = 1.0 - a;
+            dfdt[i] = t[i]*rt/(t[i]*it1)*m_pow * a;
+        }
+    }
 private:
     const double m_pow;
 };
@@ -275,51 +356,63 @@ XNMRT1::iterate(Transaction &tr, shared_ptr<XRelaxFunc> &func, int itercnt) {
     int p = shot_this[ *mInftyFit()] ? 3 : 2;
     if(n <= p) return formatString("%d",n) + i18n(" points, more points needed.");
 
-    const auto &values = tr[ *this].m_sumpts;
-    auto relax_f = [&values, &func](const double*params, size_t n, size_t p,
+    //Points with weights, in arrays for batched evaluation.
+    std::vector<double> ts, vars, isigmas;
+    for(auto &&pt : shot_this[ *this].m_sumpts) {
+        if(pt.isigma == 0) continue;
+        ts.push_back(pt.p1);
+        vars.push_back(pt.var);
+        isigmas.push_back(pt.isigma);
+    }
+    auto relax_f = [&ts, &vars, &isigmas, &func](const double*params, size_t n, size_t p,
             double *f, std::vector<double *> &df) -> bool {
         double iT1 = params[0];
         double c = params[1];
         double a = (p == 3) ? params[2] : -c;
 
-        int i = 0;
-        for(auto &&pt : values) {
-            if(pt.isigma == 0) continue;
-            double t = pt.p1;
-            double yi = 0, dydt = 0;
-            func->relax(&yi, &dydt, t, iT1);
+        //f(t) and df/d(it1) into df[1] and df[0].
+        func->relaxBatch(df[1], df[0], &ts[0], n, iT1);
+        for(size_t i = 0; i < n; ++i) {
+            double yi = df[1][i];
+            double w = isigmas[i];
             if(f) {
-                f[i] = (c * yi + a - pt.var) * pt.isigma;
+                f[i] = (c * yi + a - vars[i]) * w;
             }
-            df[0][i] = (c * dydt) * pt.isigma;
-            df[1][i] = yi * pt.isigma;
+            df[0][i] *= c * w;
+            df[1][i] = yi * w;
             if(p == 3)
-                df[2][i] = pt.isigma;
-            i++;
+                df[2][i] = w;
         }
         return true;
     };
 
+    double p1max = shot_this[ *p1Max()];
+    double p1min = shot_this[ *p1Min()];
+    std::valarray<double> last_params(p);
+    for(int i = 0; i < p; ++i)
+        last_params[i] = shot_this[ *this].m_params[i];
+    //Starts from the last result, refines it for 20 ms, then starts from random ones.
+    auto init = [&](unsigned int start) -> std::valarray<double> {
+        if(start == 0)
+            return last_params;
+        std::valarray<double> params(0.0, p);
+        params[0] = 1.0 / exp(log(p1max/p1min) * randMT19937() + log(p1min));
+        params[1] = (max_var - min_var) * (randMT19937() * 2.0 + 0.9) * ((randMT19937() < 0.5) ? 1 :  -1);
+        return params;
+    };
+    auto accept = [&](const std::valarray<double> &params) {
+        return fabs(params[1]) < (max_var - min_var) * 10;
+    };
+
     XTime firsttime = XTime::now();
-    NonLinearLeastSquare nlls;
-    for(;;) {
-        std::valarray<double> init_params(p);
-        for(int i = 0; i < p; ++i)
-            init_params[i] = tr[ *this].m_params[i];
-        nlls = NonLinearLeastSquare(relax_f, init_params, n, itercnt);
-        for(int i = 0; i < p; ++i) {
-            tr[ *this].m_params[i] = nlls.params()[i];
-            tr[ *this].m_errors[i] = nlls.errors()[i];
-        }
-        if(nlls.isSuccessful() && (fabs(tr[ *this].m_params[1]) < (max_var - min_var) * 10))
-            break;
-        if(XTime::now() - firsttime < 0.02) continue;
-        if(XTime::now() - firsttime > 0.07) break;
-        double p1max = shot_this[ *p1Max()];
-        double p1min = shot_this[ *p1Min()];
-        tr[ *this].m_params[0] = 1.0 / exp(log(p1max/p1min) * randMT19937() + log(p1min));
-        tr[ *this].m_params[1] = (max_var - min_var) * (randMT19937() * 2.0 + 0.9) * ((randMT19937() < 0.5) ? 1 :  -1);
-        tr[ *this].m_params[2] = 0.0;
+    NonLinearLeastSquareMultiStart::Stats stats;
+    NonLinearLeastSquare nlls = NonLinearLeastSquareMultiStart::fit(relax_f, n, init, accept,
+        itercnt, 256, 0.07, 0.02, &stats);
+    if(nlls.params().size() != (size_t)p)
+        return formatString("%u", stats.starts) + i18n(" starts, no fit succeeded."); //keeps the last result.
+    for(int i = 0; i < p; ++i) {
+        tr[ *this].m_params[i] = nlls.params()[i];
+        tr[ *this].m_errors[i] = nlls.errors()[i];
     }
 
     if( !shot_this[ *mInftyFit()])
@@ -355,6 +448,8 @@ XNMRT1::iterate(Transaction &tr, shared_ptr<XRelaxFunc> &func, int itercnt) {
         fabs(100.0 * shot_this[ *this].m_errors[2]/shot_this[ *this].m_params[2]));
     buf += formatString("status = %s\n", nlls.status().c_str());
     buf += formatString("rms of residuals = %.3g\n", sqrt(nlls.chiSquare() / n));
+    buf += formatString("starts = %u, converged = %u, iterations = %u\n",
+        stats.starts, stats.converged, stats.iterations);
     buf += formatString("elapsed time = %.2f ms\n", 1000.0 * (XTime::now() - firsttime));
     return buf;
 }
@@ -32,6 +32,10 @@ public:
 	//! \param data a relaxation function
 	//! \param it1 1/T1 or 1/T2   
 	virtual void relax(double *f, double *dfdt, double t, double it1) = 0;   
+	//! Evaluates relax() for \a n points at once.
+	//! \param f, dfdt arrays of \a n.
+	//! \param t array of \a n.
+	virtual void relaxBatch(double *f, double *dfdt, const double *t, unsigned int n, double it1);
   
 	static int relax_f (const gsl_vector * x, void *params,
 						gsl_vector * f);  
@@ -16,6 +16,7 @@
 //---------------------------------------------------------------------------
 #include <secondarydriver.h>
 #include <xnodeconnector.h>
+#include <xthread.h>
 #include <complex>
 #include "nmrspectrumsolver.h"
 
@@ -58,6 +59,8 @@ public:
 		double res() const {return m_res;}
 		//! Value of the first point [Hz].
 		double min() const {return m_min;}
+		//! Time [s] spent in the accumulation and the solver since the last clear.
+		double analysisTime() const {return m_analysisTime;}
 	private:
 		template <class>
 		friend class XNMRSpectrumBase;
@@ -69,14 +72,39 @@ public:
 		std::vector<std::complex<double> > m_wave;
 
 		enum {ACCUM_BANKS = 3};
-		std::deque<std::complex<double> > m_accum[ACCUM_BANKS];
-		std::deque<double> m_accum_weights[ACCUM_BANKS];
-		std::deque<double> m_accum_dark[ACCUM_BANKS]; //[V^2/Hz].
+		std::vector<std::complex<double> > m_accum[ACCUM_BANKS];
+		std::vector<double> m_accum_weights[ACCUM_BANKS];
+		std::vector<double> m_accum_dark[ACCUM_BANKS]; //[V^2/Hz].
+		//! Indices accumulated since the last solver pass, [begin, end).
+		int m_dirtyBegin = 0, m_dirtyEnd = 0;
+
+		//! Spectrum before phase rotation.
+		std::vector<std::complex<double> > m_solved;
+		double m_psdCoeff = 1.0;
+		//! Time and cost [s] of the last solver pass.
+		XTime m_timeSolved;
+		double m_solverCost = 0.0;
+		//! Only the dirty range has been updated since the last solver pass.
+		bool m_isSolverDeferred = false;
 
 		std::deque<std::pair<double, double> > m_peaks;
 
 		shared_ptr<FFT> m_ift, m_preFFT;
 
+		//! A record of the pulse analyzer at a center freq., to be accumulated.
+		struct Step {
+			int ftWidth;
+			double dFreq;
+			int waveFTPos;
+			std::vector<std::complex<double> > wave;
+			std::vector<double> darkPSD;
+			double cfreq; //!< [Hz].
+			XTime time; //!< of the record.
+		};
+		//! Of the last step accumulated in a pipelined sweep, or dropped by clearing.
+		XTime m_timeLastStep;
+		double m_analysisTime = 0.0;
+
 		XTime m_timeClearRequested;
 	};
 
@@ -111,14 +139,31 @@ protected:
 	//! [Hz]
 	virtual double getCurrentCenterFreq(const Snapshot &shot_this, const Snapshot &shot_others) const = 0;
     virtual void rearrangeInstrum(const Snapshot &) {}
+	//! \return true if records are only captured in analyze(), in order to rearrange the instruments at once.
+	//! The accumulation and the solver are performed later in another thread, overlapping the next acquisition.
+	virtual bool isPipelined(const Snapshot &) const {return false;}
 	virtual void getValues(const Snapshot &shot_this, std::vector<double> &values) const = 0;
 	virtual bool checkDependencyImpl(const Snapshot &shot_this,
 		const Snapshot &shot_emitter, const Snapshot &shot_others,
 		XDriver *emitter) const = 0;
 private:
+	using Step = typename Payload::Step;
+	shared_ptr<const Step> captureStep(const Snapshot &shot_this, const Snapshot &shot_pulse, const Snapshot &shot_others) const;
+	//! Hands a step captured in a pipelined sweep to the pipeline thread.
+	void queueStep(const shared_ptr<const Step> &step);
+	//! \return the steps captured after \a m_timeLastStep, discarding the others.
+	std::deque<shared_ptr<const Step> > pendingSteps(const Snapshot &shot_this);
+	XTime lastQueuedStepTime();
 	//! Fourier Step Summation.
-	void fssum(Transaction &tr, const Snapshot &shot_pulse, const Snapshot &shot_others);
+	void fssum(Transaction &tr, const Step &step);
+	//! Runs the solver over the whole accumulated spectrum.
 	void analyzeIFT(Transaction &tr, const Snapshot &shot_pulse);
+	//! Shows the accumulated spectrum in the dirty range, until the next solver pass.
+	void updateDirtyRange(Transaction &tr);
+	//! \return true if the throttling interval of the solver has been elapsed.
+	bool isSolverDue(const Snapshot &shot_this) const;
+	//! \return end of the throttling interval of the solver.
+	XTime solverDueTime(const Snapshot &shot_this) const;
 
 	const shared_ptr<XItemNode<XDriverList, XNMRPulseAnalyzer> > m_pulse;
  
@@ -139,6 +184,18 @@ private:
 	void onCondChanged(const Snapshot &shot, XValueNodeBase *);
 
 	atomic<int> m_isInstrumControlRequested;
+
+	//! Starts or wakes up the pipeline thread.
+	//! \param solver_due if set, the time for the deferred solver pass, instead of running at once.
+	void kickPipeline(const XTime &solver_due = XTime());
+	//! Drains the captured steps, and runs the deferred solver pass, exiting when idle.
+	void pipelineWorker(const atomic<bool> &terminated);
+	unique_ptr<XThread> m_threadPipeline;
+	XCondition m_condPipeline;
+	bool m_isPipelineRequested = false, m_isPipelineRunning = false; //!< guarded by m_condPipeline.
+	XTime m_timeSolverDue; //!< of the deferred solver pass, unset if none. Guarded by m_condPipeline.
+	//! Steps captured in a pipelined sweep, in order, until marked as accumulated. Guarded by m_condPipeline.
+	std::deque<shared_ptr<const Step> > m_pipelineSteps;
 protected:
 	const qshared_ptr<FRM> m_form;
 	const shared_ptr<XStatusPrinter> m_statusPrinter;
@@ -160,6 +160,20 @@ XNMRSpectrumBase<FRM>::onClear(const Snapshot &shot, XTouchableNode *) {
     requestAnalysis();
 }
 template <class FRM>
+XTime
+XNMRSpectrumBase<FRM>::solverDueTime(const Snapshot &shot_this) const {
+	constexpr double INTERVAL_MIN = 0.5; //[s].
+	constexpr double COST_RATIO = 4.0; //The solver occupies at most 20% of the time.
+	XTime due = shot_this[ *this].m_timeSolved;
+	due += std::max(INTERVAL_MIN, COST_RATIO * shot_this[ *this].m_solverCost);
+	return due;
+}
+template <class FRM>
+bool
+XNMRSpectrumBase<FRM>::isSolverDue(const Snapshot &shot_this) const {
+	return XTime::now() >= solverDueTime(shot_this);
+}
+template <class FRM>
 bool
 XNMRSpectrumBase<FRM>::checkDependency(const Snapshot &shot_this,
 	const Snapshot &shot_emitter, const Snapshot &shot_others,
@@ -185,6 +199,16 @@ XNMRSpectrumBase<FRM>::analyze(Transaction &tr, const Snapshot &shot_emitter, co
 	}
 
     bool clear = (shot_this[ *this].m_timeClearRequested);
+	if((emitter == pulse__.get()) && !clear && isPipelined(shot_this)) {
+		//Only captures the record, letting the instruments go to the next step at once.
+		//The step is handed to the pipeline thread, not written to this payload,
+		//so that this transaction never conflicts with the long one accumulating the steps.
+		auto step = captureStep(shot_this, shot_pulse, shot_others);
+		if(step->time > shot_this[ *this].m_timeLastStep)
+			queueStep(step);
+		m_isInstrumControlRequested = true;
+		throw XSkippedRecordError(__FILE__, __LINE__); //recorded after the accumulation.
+	}
     tr[ *this].m_timeClearRequested = {};
   
 //	double interval = shot_pulse[ *pulse__].interval();
@@ -208,7 +232,9 @@ XNMRSpectrumBase<FRM>::analyze(Transaction &tr, const Snapshot &shot_emitter, co
     //small change is discarded.
 	if(fabs(log(shot_this[ *this].res() / res)) < log(2.0))
 		res = shot_this[ *this].res();
-	if((shot_this[ *this].res() != res) || clear) {
+	//Layout of the spectrum is changed, the solver has to run over the whole range.
+	bool relayout = clear || (shot_this[ *this].res() != res);
+	if(relayout) {
 		tr[ *this].m_res = res;
 		for(int bank = 0; bank < Payload::ACCUM_BANKS; bank++) {
 			tr[ *this].m_accum[bank].clear();
@@ -219,21 +245,22 @@ XNMRSpectrumBase<FRM>::analyze(Transaction &tr, const Snapshot &shot_emitter, co
 	else {
         //expands/shrinks the begining of buffers.
         int diff = lrint(shot_this[ *this].min() / res) - lrint(min__ / res);
+        if(diff)
+            relayout = true;
 		for(int bank = 0; bank < Payload::ACCUM_BANKS; bank++) {
             auto &accum = tr[ *this].m_accum[bank];
             auto &accum_weights = tr[ *this].m_accum_weights[bank];
             auto &accum_dark = tr[ *this].m_accum_dark[bank];
-            for(int i = 0; i < diff; i++) {
-                accum.push_front(0.0);
-                accum_weights.push_front(0);
-                accum_dark.push_front(0.0);
+            if(diff > 0) {
+                accum.insert(accum.begin(), diff, 0.0);
+                accum_weights.insert(accum_weights.begin(), diff, 0.0);
+                accum_dark.insert(accum_dark.begin(), diff, 0.0);
 			}
-			for(int i = 0; i < -diff; i++) {
-                if( !accum.empty()) {
-                    accum.pop_front();
-                    accum_weights.pop_front();
-                    accum_dark.pop_front();
-				}
+            if(diff < 0) {
+                int n = std::min( -diff, (int)accum.size());
+                accum.erase(accum.begin(), accum.begin() + n);
+                accum_weights.erase(accum_weights.begin(), accum_weights.begin() + n);
+                accum_dark.erase(accum_dark.begin(), accum_dark.begin() + n);
 			}
 		}
 	}
@@ -245,35 +272,80 @@ XNMRSpectrumBase<FRM>::analyze(Transaction &tr, const Snapshot &shot_emitter, co
 		tr[ *this].m_accum_weights[bank].resize(length, 0);
 		tr[ *this].m_accum_dark[bank].resize(length, 0.0);
 	}
-	tr[ *this].m_wave.resize(length);
-	std::fill(tr[ *this].m_wave.begin(), tr[ *this].m_wave.end(), std::complex<double>(0.0));
-	tr[ *this].m_weights.resize(length);
-	std::fill(tr[ *this].m_weights.begin(), tr[ *this].m_weights.end(), 0.0);
-	tr[ *this].m_darkPSD.resize(length);
-	std::fill(tr[ *this].m_darkPSD.begin(), tr[ *this].m_darkPSD.end(), 0.0);
+	if(length != (int)shot_this[ *this].m_solved.size())
+		relayout = true;
+	if(relayout) {
+		tr[ *this].m_solved.assign(length, std::complex<double>(0.0));
+		tr[ *this].m_wave.assign(length, std::complex<double>(0.0));
+		tr[ *this].m_weights.assign(length, 0.0);
+		tr[ *this].m_darkPSD.assign(length, 0.0);
+		tr[ *this].m_dirtyBegin = 0;
+		tr[ *this].m_dirtyEnd = 0;
+	}
 
 	if(clear) {
 		tr[ *m_spectrum].clearPoints();
 		tr[ *this].m_peaks.clear();
+		tr[ *this].m_timeLastStep = std::max(shot_this[ *this].m_timeLastStep, lastQueuedStepTime()); //drops them.
+		tr[ *this].m_analysisTime = 0.0;
 		trans( *pulse__->avgClear()).touch();
 		throw XSkippedRecordError(__FILE__, __LINE__);
 	}
 
+	XTime time_start = XTime::now();
+	bool accumulated = false;
 	if(emitter == pulse__.get()) {
-		fssum(tr, shot_pulse, shot_others);
+		fssum(tr, *captureStep(shot_this, shot_pulse, shot_others));
 		m_isInstrumControlRequested = true;
+		accumulated = true;
 	}
-	else
-		m_isInstrumControlRequested = false;
-	
-	analyzeIFT(tr, shot_pulse);
+	else {
+		//Steps captured in a pipelined sweep. The instruments have been rearranged already.
+		//Those accumulated are marked by the time in this payload, to be taken again if this transaction fails.
+		auto steps = pendingSteps(shot_this);
+		if(steps.size())
+			tr[ *this].m_timeLastStep = steps.back()->time;
+		//An invalid step is dropped with a warning, and the following steps are still accumulated.
+		int dropped = 0;
+		XString msg;
+		for(auto &&step: steps) {
+			try {
+				fssum(tr, *step);
+				accumulated = true;
+			}
+			catch (XRecordError &e) {
+				dropped++;
+				msg = e.msg();
+			}
+		}
+		if(dropped)
+			m_statusPrinter->printWarning(i18n("%1 of %2 steps dropped in the pipelined sweep: %3")
+				.arg(dropped).arg((int)steps.size()).arg(QString(msg)));
+	}
+
+	//During accumulation, e.g. a sweep, the solver runs at a throttled rate.
+	//Requests from this driver, i.e. changes in conditions, are served immediately.
+	if(relayout || !accumulated || isSolverDue(shot_this)) {
+		XTime time_solver = XTime::now();
+		analyzeIFT(tr, shot_pulse);
+		tr[ *this].m_timeSolved = XTime::now();
+		tr[ *this].m_solverCost = tr[ *this].m_timeSolved - time_solver;
+		tr[ *this].m_isSolverDeferred = false;
+		tr[ *this].m_dirtyBegin = 0;
+		tr[ *this].m_dirtyEnd = 0;
+	}
+	else {
+		updateDirtyRange(tr);
+		tr[ *this].m_isSolverDeferred = true;
+	}
+	const std::vector<std::complex<double> > &solved(shot_this[ *this].m_solved);
 	std::vector<std::complex<double> > &wave(tr[ *this].m_wave);
 	const std::vector<double> &weights(shot_this[ *this].weights());
 	int wave_size = shot_this[ *this].wave().size();
 	if(shot_this[ *autoPhase()]) {
 		std::complex<double> csum(0.0, 0.0);
 		for(unsigned int i = 0; i < wave_size; i++)
-			csum += wave[i] * weights[i];
+			csum += solved[i] * weights[i];
 		double ph = 180.0 / M_PI * atan2(std::imag(csum), std::real(csum));
 		if(fabs(ph) < 180.0)
 			tr[ *phase()] = ph;
@@ -282,11 +354,19 @@ XNMRSpectrumBase<FRM>::analyze(Transaction &tr, const Snapshot &shot_emitter, co
 	double ph = shot_this[ *phase()] / 180.0 * M_PI;
 	std::complex<double> cph = std::polar(1.0, -ph);
 	for(unsigned int i = 0; i < wave_size; i++)
-		wave[i] *= cph;
+		wave[i] = solved[i] * cph;
+	tr[ *this].m_analysisTime += XTime::now() - time_start;
 }
 template <class FRM>
 void
 XNMRSpectrumBase<FRM>::visualize(const Snapshot &shot) {
+    if(m_isInstrumControlRequested.compare_set_strong((int)true, (int)false))
+		rearrangeInstrum(shot);
+	if(pendingSteps(shot).size()) {
+		kickPipeline();
+		return; //to be drawn after the accumulation.
+	}
+
 	if( !shot[ *this].time()) {
 		iterate_commit([=](Transaction &tr){
 			tr[ *m_spectrum].clearPoints();
@@ -294,9 +374,8 @@ XNMRSpectrumBase<FRM>::visualize(const Snapshot &shot) {
         });
 		return;
 	}
-
-    if(m_isInstrumControlRequested.compare_set_strong((int)true, (int)false))
-		rearrangeInstrum(shot);
+	if(shot[ *this].m_isSolverDeferred)
+		kickPipeline(solverDueTime(shot)); //the solver runs once, off the main thread.
 
 	int length = shot[ *this].wave().size();
 	std::vector<double> values;
@@ -328,14 +407,14 @@ XNMRSpectrumBase<FRM>::visualize(const Snapshot &shot) {
         const auto &peaks(shot[ *this].m_peaks);
 		int peaks_size = peaks.size();
 		tr[ *m_peakPlot->maxCount()] = peaks_size;
-        auto &points(tr[ *m_peakPlot].points());
-		points.resize(peaks_size);
+        auto &peakplot(tr[ *m_peakPlot]);
+		peakplot.clearPoints();
 		for(int i = 0; i < peaks_size; i++) {
 			double x = peaks[i].second;
 			int j = lrint(x - 0.5);
 			j = std::min(std::max(0, j), length - 2);
 			double a = values[j] + (values[j + 1] - values[j]) * (x - j);
-			points[i] = XGraph::ValPoint(a, peaks[i].first);
+			peakplot.appendPoint(XGraph::ValPoint(a, peaks[i].first));
 		}
 		m_spectrum->drawGraph(tr);
     });
@@ -343,15 +422,100 @@ XNMRSpectrumBase<FRM>::visualize(const Snapshot &shot) {
 
 template <class FRM>
 void
-XNMRSpectrumBase<FRM>::fssum(Transaction &tr, const Snapshot &shot_pulse, const Snapshot &shot_others) {
-	const Snapshot &shot_this(tr);
+XNMRSpectrumBase<FRM>::queueStep(const shared_ptr<const Step> &step) {
+	XScopedLock<XCondition> lock(m_condPipeline);
+	//The same record is captured again if the transaction is retried.
+	if(m_pipelineSteps.empty() || (m_pipelineSteps.back()->time < step->time))
+		m_pipelineSteps.push_back(step);
+}
+template <class FRM>
+std::deque<shared_ptr<const typename XNMRSpectrumBase<FRM>::Step> >
+XNMRSpectrumBase<FRM>::pendingSteps(const Snapshot &shot_this) {
+	XScopedLock<XCondition> lock(m_condPipeline);
+	while(m_pipelineSteps.size() && (m_pipelineSteps.front()->time <= shot_this[ *this].m_timeLastStep))
+		m_pipelineSteps.pop_front(); //accumulated.
+	return m_pipelineSteps;
+}
+template <class FRM>
+XTime
+XNMRSpectrumBase<FRM>::lastQueuedStepTime() {
+	XScopedLock<XCondition> lock(m_condPipeline);
+	return m_pipelineSteps.size() ? m_pipelineSteps.back()->time : XTime();
+}
+template <class FRM>
+void
+XNMRSpectrumBase<FRM>::kickPipeline(const XTime &solver_due) {
+	XScopedLock<XCondition> lock(m_condPipeline);
+	if( !solver_due)
+		m_isPipelineRequested = true;
+	else if( !m_timeSolverDue || (solver_due < m_timeSolverDue))
+		m_timeSolverDue = solver_due;
+	if(m_isPipelineRunning) {
+		m_condPipeline.signal();
+		return;
+	}
+	m_isPipelineRunning = true;
+	m_threadPipeline.reset(new XThread{shared_from_this(), &XNMRSpectrumBase<FRM>::pipelineWorker});
+}
+template <class FRM>
+void
+XNMRSpectrumBase<FRM>::pipelineWorker(const atomic<bool> &terminated) {
+	for(;;) {
+		{
+			XScopedLock<XCondition> lock(m_condPipeline);
+			bool waited = false;
+			while( !m_isPipelineRequested && !terminated) {
+				if(m_timeSolverDue) {
+					//sleeps until the deferred solver pass is due.
+					double rest = m_timeSolverDue - XTime::now();
+					if(rest <= 0)
+						break;
+					m_condPipeline.wait(std::max(1000L, lrint(rest * 1e6)));
+				}
+				else {
+					if(waited)
+						break;
+					m_condPipeline.wait(1000000); //awaits the next step for 1 sec.
+					waited = true;
+				}
+			}
+			if(terminated || ( !m_isPipelineRequested && !m_timeSolverDue)) {
+				m_isPipelineRunning = false;
+				return; //idle.
+			}
+			m_isPipelineRequested = false;
+			m_timeSolverDue = XTime(); //a solver pass follows.
+		}
+		requestAnalysis();
+	}
+}
+template <class FRM>
+shared_ptr<const typename XNMRSpectrumBase<FRM>::Step>
+XNMRSpectrumBase<FRM>::captureStep(const Snapshot &shot_this, const Snapshot &shot_pulse, const Snapshot &shot_others) const {
 	shared_ptr<XNMRPulseAnalyzer> pulse__ = shot_this[ *pulse()];
-
-	int len = shot_pulse[ *pulse__].ftWidth();
-	double df = shot_pulse[ *pulse__].dFreq();
-	if((len == 0) || (df == 0)) {
+	auto step = std::make_shared<Step>();
+	step->time = shot_pulse[ *pulse__].time();
+	step->ftWidth = shot_pulse[ *pulse__].ftWidth();
+	step->dFreq = shot_pulse[ *pulse__].dFreq();
+	if((step->ftWidth == 0) || (step->dFreq == 0)) {
 		throw XRecordError(i18n("Invalid waveform."), __FILE__, __LINE__);
 	}
+	step->cfreq = getCurrentCenterFreq(shot_this, shot_others);
+	if(step->cfreq == 0) {
+		throw XRecordError(i18n("Invalid center freq."), __FILE__, __LINE__);
+	}
+	step->waveFTPos = shot_pulse[ *pulse__].waveFTPos();
+	step->wave = shot_pulse[ *pulse__].wave();
+	step->darkPSD = shot_pulse[ *pulse__].darkPSD();
+	return step;
+}
+template <class FRM>
+void
+XNMRSpectrumBase<FRM>::fssum(Transaction &tr, const Step &step) {
+	const Snapshot &shot_this(tr);
+
+	int len = step.ftWidth;
+	double df = step.dFreq;
 	//bw *= 1.8; // for Hamming.
 	//	bw *= 3.6; // for FlatTop.
 	//bw *= 2.2; // for Kaiser3.
@@ -359,34 +523,33 @@ XNMRSpectrumBase<FRM>::fssum(Transaction &tr, const Snapshot &shot_pulse, const
 	if(bw >= len) {
 		throw XRecordError(i18n("BW beyond Nyquist freq."), __FILE__, __LINE__);
 	}
-	double cfreq = getCurrentCenterFreq(shot_this, shot_others);
-	if(cfreq == 0) {
-		throw XRecordError(i18n("Invalid center freq."), __FILE__, __LINE__);
-	}
+	double cfreq = step.cfreq;
 	std::vector<std::complex<double> > ftwavein(len, 0.0), ftwaveout(len);
 	if( !shot_this[ *this].m_preFFT || (shot_this[ *this].m_preFFT->length() != len)) {
 		tr[ *this].m_preFFT.reset(new FFT(-1, len));
 	}
-	int wlen = std::min(len, (int)shot_pulse[ *pulse__].wave().size());
-	int woff = -shot_pulse[ *pulse__].waveFTPos()
-		+ len * ((shot_pulse[ *pulse__].waveFTPos() > 0) ? ((int)shot_pulse[ *pulse__].waveFTPos() / len + 1) : 0);
-	const std::complex<double> *pulse_wave( &shot_pulse[ *pulse__].wave()[0]);
+	int wlen = std::min(len, (int)step.wave.size());
+	int woff = -step.waveFTPos
+		+ len * ((step.waveFTPos > 0) ? (step.waveFTPos / len + 1) : 0);
+	const std::complex<double> *pulse_wave( &step.wave[0]);
 	for(int i = 0; i < wlen; i++) {
 		int j = (i + woff) % len;
 		ftwavein[j] = pulse_wave[i];
 	}
 	tr[ *this].m_preFFT->exec(ftwavein, ftwaveout);
 	bw /= 2.0;
-	double normalize = 1.0 / (double)shot_pulse[ *pulse__].wave().size();
+	double normalize = 1.0 / (double)step.wave.size();
 	double darknormalize = shot_this[ *this].res() / df;
+	int dirty_begin = shot_this[ *this].m_dirtyBegin;
+	int dirty_end = shot_this[ *this].m_dirtyEnd;
 	for(int bank = 0; bank < Payload::ACCUM_BANKS; bank++) {
 		double min = shot_this[ *this].min();
 		double res = shot_this[ *this].res();
 		int size = (int)shot_this[ *this].m_accum[bank].size();
-		std::deque<std::complex<double> > &accum_wave(tr[ *this].m_accum[bank]);
-		std::deque<double> &accum_weights(tr[ *this].m_accum_weights[bank]);
-		std::deque<double> &accum_dark(tr[ *this].m_accum_dark[bank]);
-		const double *pulse_dark( &shot_pulse[ *pulse__].darkPSD()[0]);
+		std::complex<double> *accum_wave( tr[ *this].m_accum[bank].data());
+		double *accum_weights( tr[ *this].m_accum_weights[bank].data());
+		double *accum_dark( tr[ *this].m_accum_dark[bank].data());
+		const double *pulse_dark( &step.darkPSD[0]);
 		for(int i = -bw / 2; i <= bw / 2; i++) {
 			double freq = i * df;
 			int idx = lrint((cfreq + freq - min) / res);
@@ -397,9 +560,17 @@ XNMRSpectrumBase<FRM>::fssum(Transaction &tr, const Snapshot &shot_pulse, const
 			accum_wave[idx] += ftwaveout[j] * w * normalize;
 			accum_weights[idx] += w;
 			accum_dark[idx] += pulse_dark[j] * w * w * darknormalize;
+			if(dirty_begin == dirty_end) {
+				dirty_begin = idx;
+				dirty_end = idx + 1;
+			}
+			dirty_begin = std::min(dirty_begin, idx);
+			dirty_end = std::max(dirty_end, idx + 1);
 		}
 		bw *= 2.0;
 	}
+	tr[ *this].m_dirtyBegin = dirty_begin;
+	tr[ *this].m_dirtyEnd = dirty_end;
 }
 template <class FRM>
 void
@@ -412,9 +583,9 @@ XNMRSpectrumBase<FRM>::analyzeIFT(Transaction &tr, const Snapshot &shot_pulse) {
 	
 	double th = FFT::windowFuncHamming(0.49);
 	int max_idx = 0;
-	const std::deque<std::complex<double> > &accum_wave(shot_this[ *this].m_accum[bank]);
-	const std::deque<double> &accum_weights(shot_this[ *this].m_accum_weights[bank]);
-	const std::deque<double> &accum_dark(shot_this[ *this].m_accum_dark[bank]);
+	const std::vector<std::complex<double> > &accum_wave(shot_this[ *this].m_accum[bank]);
+	const std::vector<double> &accum_weights(shot_this[ *this].m_accum_weights[bank]);
+	const std::vector<double> &accum_dark(shot_this[ *this].m_accum_dark[bank]);
 	int accum_size = accum_wave.size();
 	int min_idx = accum_size - 1;
 	int taps_max = 0; 
@@ -490,10 +661,14 @@ XNMRSpectrumBase<FRM>::analyzeIFT(Transaction &tr, const Snapshot &shot_pulse) {
 		throw XSkippedRecordError(e.msg(), __FILE__, __LINE__);
 	}
 
-	std::vector<std::complex<double> > &wave(tr[ *this].m_wave);
+	std::vector<std::complex<double> > &wave(tr[ *this].m_solved);
 	std::vector<double> &weights(tr[ *this].m_weights);
 	std::vector<double> &darkpsd(tr[ *this].m_darkPSD);
+	std::fill(wave.begin(), wave.end(), std::complex<double>(0.0));
+	std::fill(weights.begin(), weights.end(), 0.0);
+	std::fill(darkpsd.begin(), darkpsd.end(), 0.0);
 	psdcoeff /= wave_period;
+	tr[ *this].m_psdCoeff = psdcoeff;
 	for(int i = min_idx; i <= max_idx; i++) {
 		int k = (i - (max_idx + min_idx) / 2 + iftlen) % iftlen;
         assert(k >= 0);
@@ -515,3 +690,28 @@ XNMRSpectrumBase<FRM>::analyzeIFT(Transaction &tr, const Snapshot &shot_pulse) {
             peaks.emplace_back(solver.peaks()[i].first / (double)iftlen, j);
 	}
 }
+template <class FRM>
+void
+XNMRSpectrumBase<FRM>::updateDirtyRange(Transaction &tr) {
+	const Snapshot &shot_this(tr);
+	int bank = shot_this[ *bwList()];
+	if((bank < 0) || (bank >= Payload::ACCUM_BANKS))
+		throw XSkippedRecordError(__FILE__, __LINE__);
+	const std::vector<std::complex<double> > &accum_wave(shot_this[ *this].m_accum[bank]);
+	const std::vector<double> &accum_weights(shot_this[ *this].m_accum_weights[bank]);
+	const std::vector<double> &accum_dark(shot_this[ *this].m_accum_dark[bank]);
+	double th = FFT::windowFuncHamming(0.49);
+	double psdcoeff = shot_this[ *this].m_psdCoeff;
+	std::complex<double> *wave( tr[ *this].m_solved.data());
+	double *weights( tr[ *this].m_weights.data());
+	double *darkpsd( tr[ *this].m_darkPSD.data());
+	//Plain Fourier step summation, as the input to the solver.
+	for(int i = shot_this[ *this].m_dirtyBegin; i < shot_this[ *this].m_dirtyEnd; i++) {
+		double w = accum_weights[i];
+		weights[i] = w;
+		if(w <= th)
+			continue;
+		wave[i] = accum_wave[i] / w;
+		darkpsd[i] = accum_dark[i] / (w * w) * psdcoeff;
+	}
+}
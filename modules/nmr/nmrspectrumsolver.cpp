@@ -17,6 +17,9 @@
     #include "freqest.h"
 #endif
 #include "freqestleastsquare.h"
+#include "xthread.h"
+#include <functional>
+#include <map>
 
 const char SpectrumSolverWrapper::SPECTRUM_SOLVER_ZF_FFT[] = "ZF-FFT";
 const char SpectrumSolverWrapper::SPECTRUM_SOLVER_MEM_STRICT[] = "Strict MEM";
@@ -47,6 +50,100 @@ const char SpectrumSolverWrapper::WINDOW_FUNC_KAISER_1[] = "Kaiser a=3";
 const char SpectrumSolverWrapper::WINDOW_FUNC_KAISER_2[] = "Kaiser a=7.2";
 const char SpectrumSolverWrapper::WINDOW_FUNC_KAISER_3[] = "Kaiser a=15";
 
+namespace {
+typedef std::function<SpectrumSolver*()> SolverCreator;
+const std::map<XString, SolverCreator> &solverCreators() {
+	static const std::map<XString, SolverCreator> creators = {
+		{SpectrumSolverWrapper::SPECTRUM_SOLVER_ZF_FFT, []() -> SpectrumSolver* {return new FFTSolver;}},
+		{SpectrumSolverWrapper::SPECTRUM_SOLVER_MEM_BURG_AICc,
+			[]() -> SpectrumSolver* {return new MEMBurg( &SpectrumSolver::icAICc);}},
+		{SpectrumSolverWrapper::SPECTRUM_SOLVER_MEM_BURG_MDL,
+			[]() -> SpectrumSolver* {return new MEMBurg( &SpectrumSolver::icMDL);}},
+		{SpectrumSolverWrapper::SPECTRUM_SOLVER_AR_YW_AICc,
+			[]() -> SpectrumSolver* {return new YuleWalkerAR( &SpectrumSolver::icAICc);}},
+		{SpectrumSolverWrapper::SPECTRUM_SOLVER_AR_YW_MDL,
+			[]() -> SpectrumSolver* {return new YuleWalkerAR( &SpectrumSolver::icMDL);}},
+#ifdef USE_FREQ_ESTM
+		{SpectrumSolverWrapper::SPECTRUM_SOLVER_MUSIC_AIC,
+			[]() -> SpectrumSolver* {return new MUSIC( &SpectrumSolver::icAIC);}},
+		{SpectrumSolverWrapper::SPECTRUM_SOLVER_MUSIC_MDL,
+			[]() -> SpectrumSolver* {return new MUSIC( &SpectrumSolver::icMDL);}},
+		{SpectrumSolverWrapper::SPECTRUM_SOLVER_EV_AIC,
+			[]() -> SpectrumSolver* {return new EigenVectorMethod( &SpectrumSolver::icAIC);}},
+		{SpectrumSolverWrapper::SPECTRUM_SOLVER_EV_MDL,
+			[]() -> SpectrumSolver* {return new EigenVectorMethod( &SpectrumSolver::icMDL);}},
+		{SpectrumSolverWrapper::SPECTRUM_SOLVER_MVDL, []() -> SpectrumSolver* {return new MVDL;}},
+		{SpectrumSolverWrapper::SPECTRUM_SOLVER_MEM_STRICT_EV,
+			[]() -> SpectrumSolver* {return new CompositeSpectrumSolver<MEMStrict, EigenVectorMethod>;}},
+#endif
+		{SpectrumSolverWrapper::SPECTRUM_SOLVER_MEM_STRICT, []() -> SpectrumSolver* {return new MEMStrict;}},
+		{SpectrumSolverWrapper::SPECTRUM_SOLVER_MEM_STRICT_BURG,
+			[]() -> SpectrumSolver* {return new CompositeSpectrumSolver<MEMStrict, MEMBurg>;}},
+		{SpectrumSolverWrapper::SPECTRUM_SOLVER_LS_HQ,
+			[]() -> SpectrumSolver* {return new FreqEstLeastSquare( &SpectrumSolver::icHQ);}},
+		{SpectrumSolverWrapper::SPECTRUM_SOLVER_LS_AICc,
+			[]() -> SpectrumSolver* {return new FreqEstLeastSquare( &SpectrumSolver::icAICc);}},
+		{SpectrumSolverWrapper::SPECTRUM_SOLVER_LS_MDL,
+			[]() -> SpectrumSolver* {return new FreqEstLeastSquare( &SpectrumSolver::icMDL);}},
+	};
+	return creators;
+}
+
+//! Idle solvers keyed by (solver type, FFT length), reused with their FFT plans and scratch buffers.
+//! A solver returns here when the last payload sharing it has gone.
+class WorkspacePool : public enable_shared_from_this<WorkspacePool> {
+public:
+	shared_ptr<SpectrumSolver> acquire(const XString &type, unsigned int fftlen) {
+		unique_ptr<SpectrumSolver> solver;
+		{
+			XScopedLock<XMutex> lock(m_mutex);
+			auto it = m_idle.find(Key(type, fftlen));
+			if(it == m_idle.end())
+				it = m_idle.lower_bound(Key(type, 0)); //of another length.
+			if((it != m_idle.end()) && (it->first.first == type)) {
+				solver = std::move(it->second.back());
+				it->second.pop_back();
+				if(it->second.empty())
+					m_idle.erase(it);
+				m_numIdle--;
+			}
+		}
+		if( !solver)
+			solver.reset(solverCreators().at(type)());
+		auto pool = shared_from_this();
+		return shared_ptr<SpectrumSolver>(solver.release(), [pool, type](SpectrumSolver *p){
+			pool->release(type, p);
+		});
+	}
+private:
+	enum {MAX_IDLE = 16};
+	void release(const XString &type, SpectrumSolver *p) {
+		unique_ptr<SpectrumSolver> solver(p); //deleted after unlocking, if not kept.
+		XScopedLock<XMutex> lock(m_mutex);
+		if(m_numIdle >= MAX_IDLE)
+			return;
+		m_idle[Key(type, solver->ifft().size())].push_back(std::move(solver));
+		m_numIdle++;
+	}
+	typedef std::pair<XString, unsigned int> Key;
+	XMutex m_mutex;
+	std::map<Key, std::deque<unique_ptr<SpectrumSolver>>> m_idle;
+	unsigned int m_numIdle = 0;
+};
+
+shared_ptr<SpectrumSolver> acquireWorkspace(const XString &type, unsigned int fftlen) {
+	static const shared_ptr<WorkspacePool> pool = std::make_shared<WorkspacePool>();
+	return pool->acquire(type, fftlen);
+}
+}
+
+SpectrumSolver &
+SpectrumSolverWrapper::Payload::solver() {
+	if(m_solver.use_count() > 1)
+		m_solver = acquireWorkspace(m_solverType, m_solver->ifft().size());
+	return *m_solver;
+}
+
 SpectrumSolverWrapper::SpectrumSolverWrapper(const char *name, bool runtime,
 	const shared_ptr<XComboNode> selector, const shared_ptr<XComboNode> windowfunc,
 	const shared_ptr<XDoubleNode> windowlength, bool leastsquareonly)
@@ -130,68 +227,19 @@ SpectrumSolverWrapper::windowFuncs(std::deque<FFT::twindowfunc> &funcs) const {
 
 void
 SpectrumSolverWrapper::onSolverChanged(const Snapshot &shot, XValueNodeBase *) {
-    shared_ptr<Payload::WrapperBase> wrapper;
+	XString type = SPECTRUM_SOLVER_ZF_FFT;
 	bool has_window = true;
 	bool has_length = true;
-	if(m_selector) {
-		if(shot[ *m_selector].to_str() == SPECTRUM_SOLVER_MEM_BURG_AICc) {
-			wrapper.reset(new Payload::Wrapper<MEMBurg>(new MEMBurg( &SpectrumSolver::icAICc)));
-		}
-		if(shot[ *m_selector].to_str() == SPECTRUM_SOLVER_MEM_BURG_MDL) {
-			wrapper.reset(new Payload::Wrapper<MEMBurg>(new MEMBurg( &SpectrumSolver::icMDL)));
-		}
-		if(shot[ *m_selector].to_str() == SPECTRUM_SOLVER_AR_YW_AICc) {
-			wrapper.reset(new Payload::Wrapper<YuleWalkerAR>(new YuleWalkerAR( &SpectrumSolver::icAICc)));
-		}
-		if(shot[ *m_selector].to_str() == SPECTRUM_SOLVER_AR_YW_MDL) {
-			wrapper.reset(new Payload::Wrapper<YuleWalkerAR>(new YuleWalkerAR( &SpectrumSolver::icMDL)));
-		}
-#ifdef USE_FREQ_ESTM
-        if(shot[ *m_selector].to_str() == SPECTRUM_SOLVER_MUSIC_AIC) {
-			wrapper.reset(new Payload::Wrapper<MUSIC>(new MUSIC( &SpectrumSolver::icAIC)));
-		}
-		if(shot[ *m_selector].to_str() == SPECTRUM_SOLVER_MUSIC_MDL) {
-			wrapper.reset(new Payload::Wrapper<MUSIC>(new MUSIC( &SpectrumSolver::icMDL)));
-		}
-		if(shot[ *m_selector].to_str() == SPECTRUM_SOLVER_EV_AIC) {
-			wrapper.reset(new Payload::Wrapper<EigenVectorMethod>(new EigenVectorMethod( &SpectrumSolver::icAIC)));
-		}
-		if(shot[ *m_selector].to_str() == SPECTRUM_SOLVER_EV_MDL) {
-			wrapper.reset(new Payload::Wrapper<EigenVectorMethod>(new EigenVectorMethod( &SpectrumSolver::icMDL)));
-		}
-		if(shot[ *m_selector].to_str() == SPECTRUM_SOLVER_MVDL) {
-			wrapper.reset(new Payload::Wrapper<MVDL>(new MVDL));
-		}
-        if(shot[ *m_selector].to_str() == SPECTRUM_SOLVER_MEM_STRICT_EV) {
-            wrapper.reset(new Payload::Wrapper<CompositeSpectrumSolver<MEMStrict, EigenVectorMethod> >(
-                new CompositeSpectrumSolver<MEMStrict, EigenVectorMethod>()));
-        }
-#endif
-		if(shot[ *m_selector].to_str() == SPECTRUM_SOLVER_MEM_STRICT) {
-			wrapper.reset(new Payload::Wrapper<MEMStrict>(new MEMStrict));
-		}
-		if(shot[ *m_selector].to_str() == SPECTRUM_SOLVER_MEM_STRICT_BURG) {
-			wrapper.reset(new Payload::Wrapper<CompositeSpectrumSolver<MEMStrict, MEMBurg> >(
-				new CompositeSpectrumSolver<MEMStrict, MEMBurg>()));
-		}
-		if(shot[ *m_selector].to_str() == SPECTRUM_SOLVER_LS_HQ) {
-			wrapper.reset(new Payload::Wrapper<FreqEstLeastSquare>(new FreqEstLeastSquare( &SpectrumSolver::icHQ)));
-		}
-		if(shot[ *m_selector].to_str() == SPECTRUM_SOLVER_LS_AICc) {
-			wrapper.reset(new Payload::Wrapper<FreqEstLeastSquare>(new FreqEstLeastSquare( &SpectrumSolver::icAICc)));
-		}
-		if(shot[ *m_selector].to_str() == SPECTRUM_SOLVER_LS_MDL) {
-			wrapper.reset(new Payload::Wrapper<FreqEstLeastSquare>(new FreqEstLeastSquare( &SpectrumSolver::icMDL)));
-		}
-	}
-	if( !wrapper) {
-		wrapper.reset(new Payload::Wrapper<FFTSolver>(new FFTSolver));
+	if(m_selector && solverCreators().count(shot[ *m_selector].to_str())) {
+		type = shot[ *m_selector].to_str();
 	}
+	shared_ptr<SpectrumSolver> solver = acquireWorkspace(type, 0);
 	if(m_windowfunc)
 		m_windowfunc->setUIEnabled(has_window);
 	if(m_windowlength)
 		m_windowlength->setUIEnabled(has_length);
     iterate_commit([=](Transaction &tr){
-        tr[ *this].m_wrapper = wrapper;
+        tr[ *this].m_solverType = type;
+        tr[ *this].m_solver = solver;
     });
 }
@@ -30,32 +30,16 @@ public:
     virtual ~SpectrumSolverWrapper();
 
 	struct Payload : public XNode::Payload {
-		Payload() : XNode::Payload() {}
-		Payload(const Payload &x) : XNode::Payload(x) {
-			if(x.m_wrapper)
-				m_wrapper.reset(x.m_wrapper->clone());
-		}
-		SpectrumSolver &solver() {return m_wrapper->solver();}
-		const SpectrumSolver &solver() const {return m_wrapper->solver();}
+		//! Solver holding the last results, shared with the former payloads.
+		const SpectrumSolver &solver() const {return *m_solver;}
+		//! \return a solver exclusive to this transaction to be executed,
+		//! taken from the workspace pool unless already taken.
+		SpectrumSolver &solver();
 	private:
 		friend class SpectrumSolverWrapper;
-		struct WrapperBase {
-            virtual ~WrapperBase() = default;
-			virtual WrapperBase *clone() = 0;
-			virtual SpectrumSolver &solver() = 0;
-			virtual const SpectrumSolver &solver() const = 0;
-		};
-		template <class T>
-		struct Wrapper : public WrapperBase {
-			Wrapper(T *p) : m_solver(p) {}
-			virtual Wrapper* clone() { return new Wrapper(new T( *m_solver)); }
-			virtual T &solver() {return *m_solver; }
-			virtual const T &solver() const {return *m_solver; }
-		private:
-			Wrapper();
-			unique_ptr<T> m_solver;
-		};
-        shared_ptr<WrapperBase> m_wrapper;
+		XString m_solverType;
+		//! Copying a payload only shares this.
+		shared_ptr<SpectrumSolver> m_solver;
 	};
 	  
 	static const char SPECTRUM_SOLVER_ZF_FFT[];
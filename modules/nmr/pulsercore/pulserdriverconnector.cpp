@@ -131,15 +131,15 @@ XQPulserDriverConnector::updateGraph(const Snapshot &shot, bool checkselection)
     shared_ptr<XPulser> pulser(m_pulser);
     const XPulser::Payload::RelPatList &relpatlist(shot[ *pulser].relPatList());
 	m_graph->iterate_commit([=](Transaction &tr){
-        auto &barplot_points(tr[ *m_barPlot].points());
+        auto &barplot_points(tr[ *m_barPlot]);
 		tr[ *m_barPlot->maxCount()] = relpatlist.size();
-		barplot_points.clear();
+		barplot_points.clearPoints();
         std::vector<decltype(&barplot_points)> plots_points;
         for(auto it = m_plots.begin();
 			it != m_plots.end(); it++) {
 			tr[ *(*it)->maxCount()] = relpatlist.size() * 2;
-			tr[ **it].points().clear();
-			plots_points.push_back(&tr[ **it].points());
+			tr[ **it].clearPoints();
+			plots_points.push_back(&tr[ **it]);
 		}
 		uint32_t lastpat = relpatlist.empty() ? 0 :
 			relpatlist[relpatlist.size() - 1].pattern;
@@ -154,10 +154,10 @@ XQPulserDriverConnector::updateGraph(const Snapshot &shot, bool checkselection)
 				if(firsttime < 0) firsttime = time;
 				lasttime = time;
 			}
-			barplot_points.push_back(XGraph::ValPoint(time, m_plots.size()));
+			barplot_points.appendPoint(XGraph::ValPoint(time, m_plots.size()));
 			for(int j = 0; j < (int)plots_points.size(); j++) {
-				plots_points[j]->push_back(XGraph::ValPoint(time, j + 0.7 * ((lastpat >> j) % 2)));
-				plots_points[j]->push_back(XGraph::ValPoint(time, j + 0.7 * ((it->pattern >> j) % 2)));
+				plots_points[j]->appendPoint(XGraph::ValPoint(time, j + 0.7 * ((lastpat >> j) % 2)));
+				plots_points[j]->appendPoint(XGraph::ValPoint(time, j + 0.7 * ((it->pattern >> j) % 2)));
 			}
 			lastpat = it->pattern;
 			i++;
@@ -210,9 +210,9 @@ XQPulserDriverConnector::onPulseChanged(const Snapshot &shot, XDriver *) {
     	m_graph->iterate_commit([=](Transaction &tr){
             for(auto it = m_plots.begin();
 				it != m_plots.end(); it++) {
-				tr[ **it].points().clear();
+				tr[ **it].clearPoints();
 			}
-			tr[ *m_barPlot].points().clear();
+			tr[ *m_barPlot].clearPoints();
 			tr.mark(tr[ *m_graph].onUpdate(), m_graph.get());
         });
     }
@@ -0,0 +1,36 @@
+/***************************************************************************
+        Copyright (C) 2002-2017 Kentaro Kitagawa
+                           kitagawa@phys.s.u-tokyo.ac.jp
+
+        This program is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        You should have received a copy of the GNU Library General
+        Public License and a list of authors along with this program;
+        see the files COPYING and AUTHORS.
+***************************************************************************/
+#include "simulatedinterface.h"
+
+SoftwareTriggerManager XSimulatedNMRInterface::s_softwareTriggerManager;
+XMutex XSimulatedNMRInterface::s_mutex;
+std::map<const void *, shared_ptr<const SimulatedExcitations>> XSimulatedNMRInterface::s_excitations;
+
+void
+XSimulatedNMRInterface::setExcitations(const void *pulser, const shared_ptr<const SimulatedExcitations> &excitations) {
+    XScopedLock<XMutex> lock(s_mutex);
+    if(excitations)
+        s_excitations[pulser] = excitations;
+    else
+        s_excitations.erase(pulser);
+}
+
+std::vector<shared_ptr<const SimulatedExcitations>>
+XSimulatedNMRInterface::excitations() {
+    XScopedLock<XMutex> lock(s_mutex);
+    std::vector<shared_ptr<const SimulatedExcitations>> list;
+    for(auto &&x: s_excitations)
+        list.push_back(x.second);
+    return list;
+}
@@ -0,0 +1,56 @@
+/***************************************************************************
+        Copyright (C) 2002-2017 Kentaro Kitagawa
+                           kitagawa@phys.s.u-tokyo.ac.jp
+
+        This program is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        You should have received a copy of the GNU Library General
+        Public License and a list of authors along with this program;
+        see the files COPYING and AUTHORS.
+***************************************************************************/
+#ifndef SIMULATEDINTERFACE_H
+#define SIMULATEDINTERFACE_H
+
+#include "dummydriver.h"
+#include "softtrigger.h"
+#include <map>
+
+//! Excitations of a virtual spin system by one simulated pulser.
+//! Times are counted by the pulser clock from the arm, as software-trigger stamps are.
+struct SimulatedExcitations {
+    double freq; //!< pulser clock [Hz].
+    uint64_t origin; //!< clock count at the beginning of the first period.
+    uint64_t period; //!< clock counts per period of the pattern.
+    struct Event {
+        double center; //!< clock counts from the beginning of a period.
+        double age; //!< clock counts since the excitation (P1), zero for FID.
+        unsigned int phase; //!< 0-3, in unit of pi/2.
+        bool isEcho;
+    };
+    std::vector<Event> events;
+};
+
+//! Interface shared by simulated pulsers and DSOs without any hardware.
+//! Pulsers publish their excitations here, from which DSOs synthesize NMR signals.
+class XSimulatedNMRInterface : public XDummyInterface {
+public:
+    XSimulatedNMRInterface(const char *name, bool runtime, const shared_ptr<XDriver> &driver)
+        : XDummyInterface(name, runtime, driver) {}
+    virtual ~XSimulatedNMRInterface() = default;
+
+    static SoftwareTriggerManager &softwareTriggerManager() {return s_softwareTriggerManager;}
+
+    //! \param excitations null to withdraw.
+    static void setExcitations(const void *pulser, const shared_ptr<const SimulatedExcitations> &excitations);
+    //! \return all excitations currently published.
+    static std::vector<shared_ptr<const SimulatedExcitations>> excitations();
+private:
+    static SoftwareTriggerManager s_softwareTriggerManager;
+    static XMutex s_mutex;
+    static std::map<const void *, shared_ptr<const SimulatedExcitations>> s_excitations;
+};
+
+#endif // SIMULATEDINTERFACE_H
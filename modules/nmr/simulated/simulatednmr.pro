@@ -0,0 +1,30 @@
+PRI_DIR = ../../
+include($${PRI_DIR}/modules.pri)
+
+QT += widgets
+
+INCLUDEPATH += \
+    $${_PRO_FILE_PWD_}/../../../kame/graph\
+
+HEADERS += \
+    simulatedinterface.h \
+    simulatedpulser.h \
+    simulatedrealtimedso.h
+
+SOURCES += \
+    simulatedinterface.cpp \
+    simulatedpulser.cpp \
+    simulatedrealtimedso.cpp
+
+win32:LIBS += -lnmrpulsercore
+
+INCLUDEPATH += $$PWD/../pulsercore
+DEPENDPATH += $$PWD/../pulsercore
+
+win32:LIBS += -ldsocore
+
+INCLUDEPATH += $$PWD/../../dso/core
+DEPENDPATH += $$PWD/../../dso/core
+
+INCLUDEPATH += $$PWD/../../charinterface
+DEPENDPATH += $$PWD/../../charinterface
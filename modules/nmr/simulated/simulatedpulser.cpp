@@ -0,0 +1,111 @@
+/***************************************************************************
+        Copyright (C) 2002-2017 Kentaro Kitagawa
+                           kitagawa@phys.s.u-tokyo.ac.jp
+
+        This program is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        You should have received a copy of the GNU Library General
+        Public License and a list of authors along with this program;
+        see the files COPYING and AUTHORS.
+***************************************************************************/
+#include "simulatedpulser.h"
+
+REGISTER_TYPE(XDriverList, SimulatedPulser, "Simulated NMR pulser without hardware");
+
+#define PREFILLING_SAMPS 1000
+
+XSimulatedPulser::XSimulatedPulser(const char *name, bool runtime,
+    Transaction &tr_meas, const shared_ptr<XMeasure> &meas) :
+    XDummyDriver<XPulser>(name, runtime, ref(tr_meas), meas) {
+
+    const int ports[] = {
+        XPulser::PORTSEL_GATE, XPulser::PORTSEL_PREGATE, XPulser::PORTSEL_TRIG1, XPulser::PORTSEL_PULSE1,
+        XPulser::PORTSEL_PULSE2, XPulser::PORTSEL_ASW, XPulser::PORTSEL_TRIG2, XPulser::PORTSEL_COMB,
+        XPulser::PORTSEL_UNSEL, XPulser::PORTSEL_UNSEL, XPulser::PORTSEL_UNSEL, XPulser::PORTSEL_UNSEL,
+        XPulser::PORTSEL_UNSEL, XPulser::PORTSEL_UNSEL, XPulser::PORTSEL_UNSEL, XPulser::PORTSEL_UNSEL
+    };
+    iterate_commit([=](Transaction &tr){
+        for(unsigned int i = 0; i < sizeof(ports)/sizeof(int); i++) {
+            tr[ *XPulser::portSel(i)] = ports[i];
+        }
+    });
+
+    m_softwareTrigger = XSimulatedNMRInterface::softwareTriggerManager().create(name, NUM_DO_PORTS);
+
+    setPrefillingSampsBeforeArm(PREFILLING_SAMPS);
+}
+XSimulatedPulser::~XSimulatedPulser() {
+    XSimulatedNMRInterface::setExcitations(this, nullptr);
+    XSimulatedNMRInterface::softwareTriggerManager().unregister(m_softwareTrigger);
+}
+
+void
+XSimulatedPulser::changeOutput(const Snapshot &shot, bool output, unsigned int blankpattern) {
+    if(output)
+        XSimulatedNMRInterface::setExcitations(this, createExcitations(shot));
+    else
+        XSimulatedNMRInterface::setExcitations(this, nullptr);
+}
+
+shared_ptr<SimulatedExcitations>
+XSimulatedPulser::createExcitations(const Snapshot &shot) {
+    auto excitations = std::make_shared<SimulatedExcitations>();
+    excitations->freq = 1e3 / resolution();
+    //The free-running counter starts from the prefilled position, as stamps do.
+    excitations->origin = prefillingSampsBeforeArm();
+    const auto &patlist = shot[ *this].relPatList();
+    uint64_t period = 0;
+    for(auto &&pat: patlist)
+        period += pat.toappear;
+    excitations->period = period;
+    if( !period)
+        return excitations;
+
+    const uint32_t p1mask = selectedPorts(shot, PORTSEL_PULSE1);
+    const uint32_t p2mask = selectedPorts(shot, PORTSEL_PULSE2);
+    auto phase_of = [](uint32_t pat) -> unsigned int {
+        return (pat & PAT_QAM_PHASE_MASK) / PAT_QAM_PHASE;
+    };
+    uint32_t oldpat = patlist.back().pattern; //periodic.
+    uint64_t time = 0;
+    double p1_rise = 0.0, p2_rise = 0.0;
+    unsigned int p1_phase = 0, p2_phase = 0;
+    bool excited = false;
+    double excitation = 0.0, last_center = 0.0;
+    unsigned int last_phase = 0;
+    for(auto &&pat: patlist) {
+        time += pat.toappear;
+        uint32_t newpat = pat.pattern;
+        uint32_t rising = newpat & ~oldpat, falling = ~newpat & oldpat;
+        if(rising & p1mask) {
+            p1_rise = time;
+            p1_phase = phase_of(newpat);
+        }
+        if(falling & p1mask) {
+            //pi/2 pulse, FID follows.
+            excitation = (p1_rise + time) / 2;
+            excited = true;
+            last_center = excitation;
+            last_phase = p1_phase;
+            excitations->events.push_back({excitation, 0.0, p1_phase, false});
+        }
+        if(rising & p2mask) {
+            p2_rise = time;
+            p2_phase = phase_of(newpat);
+        }
+        if((falling & p2mask) && excited) {
+            //pi pulse, refocuses the last FID or echo.
+            double center = (p2_rise + time) / 2;
+            double echo = 2 * center - last_center;
+            unsigned int echo_phase = (2 * p2_phase + 6 - last_phase) % 4;
+            excitations->events.push_back({echo, echo - excitation, echo_phase, true});
+            last_center = echo;
+            last_phase = echo_phase;
+        }
+        oldpat = newpat;
+    }
+    return excitations;
+}
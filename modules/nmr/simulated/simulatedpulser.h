@@ -0,0 +1,46 @@
+/***************************************************************************
+        Copyright (C) 2002-2017 Kentaro Kitagawa
+                           kitagawa@phys.s.u-tokyo.ac.jp
+
+        This program is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        You should have received a copy of the GNU Library General
+        Public License and a list of authors along with this program;
+        see the files COPYING and AUTHORS.
+***************************************************************************/
+#ifndef SIMULATEDPULSER_H
+#define SIMULATEDPULSER_H
+
+#include "pulserdriver.h"
+#include "simulatedinterface.h"
+
+//! Software-only pulser, emitting software-trigger stamps for XSimulatedRealTimeDSO.
+//! Rising edges of P1 and P2 ports excite the virtual spins.
+class XSimulatedPulser : public XDummyDriver<XPulser> {
+public:
+    XSimulatedPulser(const char *name, bool runtime,
+        Transaction &tr_meas, const shared_ptr<XMeasure> &meas);
+    virtual ~XSimulatedPulser();
+
+    //! time resolution [ms]
+    virtual double resolution() const override {return RESOLUTION;}
+protected:
+    //! Publishes excitations or withdraws them.
+    virtual void changeOutput(const Snapshot &shot, bool output, unsigned int blankpattern) override;
+    //! Nothing to convert.
+    virtual void createNativePatterns(Transaction &tr) override {}
+    virtual double resolutionQAM() const override {return 0.0;}
+    //! minimum period of pulses [ms]
+    virtual double minPulseWidth() const override {return RESOLUTION;}
+    //! existense of AO ports.
+    virtual bool hasQAMPorts() const override {return false;}
+private:
+    static constexpr double RESOLUTION = 1e-4; //!< 100ns.
+    //! Analyzes the pattern of one period to find FIDs and echoes.
+    shared_ptr<SimulatedExcitations> createExcitations(const Snapshot &shot);
+};
+
+#endif // SIMULATEDPULSER_H
@@ -0,0 +1,288 @@
+/***************************************************************************
+        Copyright (C) 2002-2017 Kentaro Kitagawa
+                           kitagawa@phys.s.u-tokyo.ac.jp
+
+        This program is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        You should have received a copy of the GNU Library General
+        Public License and a list of authors along with this program;
+        see the files COPYING and AUTHORS.
+***************************************************************************/
+
+#include "simulatedrealtimedso.h"
+#include "dsorealtimeacq_impl.h"
+#include "rand.h"
+#include <cstring>
+
+REGISTER_TYPE(XDriverList, SimulatedRealTimeDSO, "Simulated streaming DSO with NMR signals");
+
+constexpr double V_FULL_SCALE = 1.0; //+-1V F.S.
+
+XSimulatedRealTimeDSO::XSimulatedRealTimeDSO(const char *name, bool runtime,
+    Transaction &tr_meas, const shared_ptr<XMeasure> &meas) :
+    XRealTimeAcqDSO<XCharDeviceDriver<XDSO, XSimulatedNMRInterface>>(name, runtime, tr_meas, meas),
+    m_sampleRate(create<XDoubleNode>("SampleRate", false)),
+    m_signalAmplitude(create<XDoubleNode>("SignalAmplitude", false)),
+    m_offsetFreq(create<XDoubleNode>("OffsetFreq", false)),
+    m_t2Star(create<XDoubleNode>("T2Star", false)),
+    m_t2(create<XDoubleNode>("T2", false)),
+    m_noiseLevel(create<XDoubleNode>("NoiseLevel", false)),
+    m_smplPerSec(5e6),
+    m_totalSmpsPerCh(0),
+    m_currRdPos(0),
+    m_signal(ChunkSize) {
+
+    //Box-Muller transform.
+    m_noiseTable.resize(NoiseTableSize);
+    for(unsigned int i = 0; i < NoiseTableSize; i += 2) {
+        double r = sqrt(-2.0 * log(1.0 - randMT19937()));
+        double theta = 2.0 * M_PI * randMT19937();
+        m_noiseTable[i] = r * cos(theta);
+        m_noiseTable[i + 1] = r * sin(theta);
+    }
+
+    std::vector<shared_ptr<XNode>> unnecessary_ui{
+        trace3(), trace4(),
+        vFullScale1(), vFullScale2(), vFullScale3(), vFullScale4(),
+        vOffset1(), vOffset2(), vOffset3(), vOffset4(),
+        trigLevel(),
+        timeWidth()
+    };
+    iterate_commit([=](Transaction &tr){
+        tr[ *sampleRate()] = 5.0;
+        tr[ *signalAmplitude()] = 0.1;
+        tr[ *offsetFreq()] = 10.0;
+        tr[ *t2Star()] = 50.0;
+        tr[ *t2()] = 2000.0;
+        tr[ *noiseLevel()] = 0.02;
+        tr[ *recordLength()] = lrint(5e6 * 0.001);
+        tr[ *fetchMode()] = "Averaging";
+        for(auto &&x: {trace1(), trace2()}) {
+            tr[ *x].add({"CH1", "CH2"});
+        }
+        tr[ *trace1()] = "CH1";
+        tr[ *trace2()] = "CH2";
+        tr[ *average()] = 1;
+        for(auto &&x: unnecessary_ui)
+            tr[ *x].disable();
+    });
+}
+
+void
+XSimulatedRealTimeDSO::startAcquision() {
+    if(m_threadGen)
+        return;
+    commitAcquision();
+    m_origin = XTime::now();
+    m_threadGen.reset(new XThread(shared_from_this(), &XSimulatedRealTimeDSO::executeGeneration));
+}
+void
+XSimulatedRealTimeDSO::commitAcquision() {
+    stopAcquision();
+}
+void
+XSimulatedRealTimeDSO::stopAcquision() {
+    clearAcquision();
+    allocateAcqBuffer(m_ring, NUM_CH * RingSize);
+    m_totalSmpsPerCh = 0;
+    m_currRdPos = 0;
+}
+
+void
+XSimulatedRealTimeDSO::clearAcquision() {
+    if(m_threadGen) {
+        m_threadGen->terminate();
+        m_threadGen->join();
+        m_threadGen.reset();
+    }
+}
+
+unsigned int
+XSimulatedRealTimeDSO::getNumOfChannels() {
+    return NUM_CH;
+}
+
+XString
+XSimulatedRealTimeDSO::getChannelInfoStrings() {
+    return {};
+}
+
+std::deque<XString>
+XSimulatedRealTimeDSO::hardwareTriggerNames() {
+    return {};
+}
+
+double
+XSimulatedRealTimeDSO::setupTimeBase() {
+    Snapshot shot( *this);
+    m_smplPerSec = std::max(1e-3, (double)shot[ *sampleRate()]) * 1e6;
+    return 1.0 / m_smplPerSec;
+}
+
+void
+XSimulatedRealTimeDSO::setupChannels() {
+    for(int ch_num: {0,1,2,3}) {
+        for(unsigned int i = 0; i < CAL_POLY_ORDER; i++)
+            m_coeffAI[ch_num][i] = 0.0;
+        m_coeffAI[ch_num][1] = V_FULL_SCALE / 32768.0;
+    }
+}
+
+void
+XSimulatedRealTimeDSO::setupHardwareTrigger() {
+}
+
+void
+XSimulatedRealTimeDSO::disableHardwareTriggers() {
+}
+
+uint64_t
+XSimulatedRealTimeDSO::getTotalSampsAcquired() {
+    return m_totalSmpsPerCh;
+}
+
+uint32_t
+XSimulatedRealTimeDSO::getNumSampsToBeRead() {
+    uint64_t total = m_totalSmpsPerCh;
+    if(total <= m_currRdPos)
+        return 0;
+    return std::min(total - m_currRdPos, (uint64_t)RingSize);
+}
+
+bool
+XSimulatedRealTimeDSO::setReadPositionAbsolute(uint64_t pos) {
+    uint64_t total = m_totalSmpsPerCh;
+    //keeps a margin for the samples being generated.
+    if(pos + RingSize / 2 < total)
+        return false;
+    m_currRdPos = pos;
+    return true;
+}
+void
+XSimulatedRealTimeDSO::setReadPositionFirstPoint() {
+    m_currRdPos = 0;
+}
+
+uint32_t
+XSimulatedRealTimeDSO::readAcqBuffer(uint32_t size, tRawAI *buf) {
+    uint64_t total = m_totalSmpsPerCh;
+    if(total <= m_currRdPos)
+        return 0;
+    //the chunk being synthesized is also lost.
+    if(total + ChunkSize > m_currRdPos + RingSize)
+        throw XInterface::XInterfaceError(i18n("Ring buffer has been overwritten."), __FILE__, __LINE__);
+    const uint64_t begin = m_currRdPos;
+    size = std::min((uint64_t)size, total - m_currRdPos);
+    for(uint32_t left = size; left;) {
+        unsigned int idx = m_currRdPos % RingSize;
+        unsigned int len = std::min(left, (uint32_t)RingSize - idx);
+        std::memcpy(buf, &m_ring[idx * NUM_CH], len * NUM_CH * sizeof(tRawAI));
+        buf += len * NUM_CH;
+        left -= len;
+        m_currRdPos += len;
+    }
+    //the samples may have been overwritten during the copy.
+    if(m_totalSmpsPerCh + ChunkSize > begin + RingSize)
+        throw XInterface::XInterfaceError(i18n("Ring buffer has been overwritten."), __FILE__, __LINE__);
+    return size;
+}
+
+void
+XSimulatedRealTimeDSO::synthesize(const Snapshot &shot,
+    const std::vector<shared_ptr<const SimulatedExcitations>> &excitations,
+    uint64_t pos, unsigned int len, uint32_t &rnd, tRawAI *buf) {
+    const double lsb = V_FULL_SCALE / 32768.0;
+    const double amp = shot[ *signalAmplitude()] / lsb;
+    const double noise = shot[ *noiseLevel()] / lsb;
+    const double omega = 2.0 * M_PI * shot[ *offsetFreq()] * 1e3 / m_smplPerSec; //[rad/sample].
+    const double t2star = std::max(1.0, shot[ *t2Star()] * 1e-6 * m_smplPerSec); //[sample].
+    const double t2 = std::max(1e-9, shot[ *t2()] * 1e-6); //[s].
+    const double extent = 8.0 * t2star; //tails beyond are negligible.
+    const double begin = pos, end = pos + len;
+    //phasors per sample, for falling and rising envelopes.
+    const auto rot_decay = std::polar(exp(-1.0 / t2star), omega);
+    const auto rot_grow = std::polar(exp(1.0 / t2star), omega);
+
+    std::fill(m_signal.begin(), m_signal.begin() + len, 0.0);
+    for(auto &&ex: excitations) {
+        if( !ex->period || ex->events.empty())
+            continue;
+        const double scale = m_smplPerSec / ex->freq; //DSO samples per pulser clock.
+        const double period = ex->period * scale;
+        const double origin = ex->origin * scale;
+        double ev_min = ex->events.front().center, ev_max = ev_min;
+        for(auto &&ev: ex->events) {
+            ev_min = std::min(ev_min, ev.center);
+            ev_max = std::max(ev_max, ev.center);
+        }
+        //periods which may overlap with [begin, end).
+        long n0 = std::max(0L, (long)floor((begin - origin - ev_max * scale - extent) / period));
+        long n1 = (long)floor((end - origin - ev_min * scale + extent) / period);
+        for(long n = n0; n <= n1; ++n) {
+            for(auto &&ev: ex->events) {
+                double center = origin + n * period + ev.center * scale;
+                double from = std::max(begin, ev.isEcho ? center - extent : center);
+                double to = std::min(end, center + extent);
+                if(from >= to)
+                    continue;
+                double a = amp;
+                if(ev.isEcho)
+                    a *= exp( -ev.age / ex->freq / t2);
+                auto ph = std::polar(a, ev.phase * M_PI / 2);
+                unsigned int i = lrint(ceil(from - begin));
+                unsigned int i_end = lrint(ceil(to - begin));
+                double dt = begin + i - center;
+                if(dt < 0) {
+                    //rising half of an echo.
+                    auto s = ph * std::polar(exp(dt / t2star), omega * dt);
+                    for(; (i < i_end) && (begin + i < center); ++i) {
+                        m_signal[i] += s;
+                        s *= rot_grow;
+                    }
+                    dt = begin + i - center;
+                }
+                auto s = ph * std::polar(exp( -dt / t2star), omega * dt);
+                for(; i < i_end; ++i) {
+                    m_signal[i] += s;
+                    s *= rot_decay;
+                }
+            }
+        }
+    }
+    for(unsigned int i = 0; i < len; ++i) {
+        for(unsigned int ch = 0; ch < NUM_CH; ++ch) {
+            //LCG is good enough to pick up the tabulated deviates.
+            rnd = rnd * 1664525u + 1013904223u;
+            double v = ((ch == 0) ? m_signal[i].real() : m_signal[i].imag())
+                + noise * m_noiseTable[rnd >> 16];
+            *buf++ = std::max(-32768L, std::min(32767L, lrint(v)));
+        }
+    }
+}
+
+void*
+XSimulatedRealTimeDSO::executeGeneration(const atomic<bool> &terminated) {
+    Transactional::setCurrentPriorityMode(Priority::HIGHEST);
+    uint32_t rnd = lrint(randMT19937() * 0xffffffffu);
+    while( !terminated) {
+        msecsleep(5);
+        uint64_t target = (XTime::now() - m_origin) * m_smplPerSec;
+        uint64_t total = m_totalSmpsPerCh;
+        if(total >= target)
+            continue;
+        auto excitations = XSimulatedNMRInterface::excitations();
+        Snapshot shot( *this);
+        //If lagging behind real time, the rest is left for the next turn.
+        for(unsigned int i = 0; (total < target) && (i < 64) && !terminated; ++i) {
+            unsigned int idx = total % RingSize;
+            unsigned int len = std::min(std::min(target - total, (uint64_t)ChunkSize), (uint64_t)(RingSize - idx));
+            synthesize(shot, excitations, total, len, rnd, &m_ring[idx * NUM_CH]);
+            total += len;
+            m_totalSmpsPerCh = total; //after a write barrier.
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,101 @@
+/***************************************************************************
+        Copyright (C) 2002-2017 Kentaro Kitagawa
+                           kitagawa@phys.s.u-tokyo.ac.jp
+
+        This program is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        You should have received a copy of the GNU Library General
+        Public License and a list of authors along with this program;
+        see the files COPYING and AUTHORS.
+***************************************************************************/
+#ifndef SIMULATEDREALTIMEDSO_H
+#define SIMULATEDREALTIMEDSO_H
+
+#include "dsorealtimeacq.h"
+#include "chardevicedriver.h"
+#include "simulatedinterface.h"
+#include <complex>
+
+//! Software DSO synthesizing FIDs and echoes plus noise in real time, without hardware.
+//! Excitations are given by XSimulatedPulser, on the same time origin as its software trigger.
+//! CH1 and CH2 are the in-phase and quadrature components.
+class XSimulatedRealTimeDSO : public XRealTimeAcqDSO<XCharDeviceDriver<XDSO, XSimulatedNMRInterface>> {
+public:
+    XSimulatedRealTimeDSO(const char *name, bool runtime,
+        Transaction &tr_meas, const shared_ptr<XMeasure> &meas);
+    virtual ~XSimulatedRealTimeDSO() = default;
+
+    //! Applied when acquisition is restarted.
+    const shared_ptr<XDoubleNode> &sampleRate() const {return m_sampleRate;} //!< [MS/s]
+    const shared_ptr<XDoubleNode> &signalAmplitude() const {return m_signalAmplitude;} //!< [V]
+    const shared_ptr<XDoubleNode> &offsetFreq() const {return m_offsetFreq;} //!< [kHz]
+    const shared_ptr<XDoubleNode> &t2Star() const {return m_t2Star;} //!< Decay of FID and width of echoes [us].
+    const shared_ptr<XDoubleNode> &t2() const {return m_t2;} //!< Decay of echo trains [us].
+    const shared_ptr<XDoubleNode> &noiseLevel() const {return m_noiseLevel;} //!< [V rms]
+protected:
+    //! Changes the instrument state so that it can wait for a trigger (arm).
+    virtual void startAcquision() override;
+    //! Prepares the instrument state just before startAcquision().
+    virtual void commitAcquision() override;
+    //! From a triggerable state to a commited state.
+    virtual void stopAcquision() override;
+    //! From any state to unconfigured state.
+    virtual void clearAcquision() override;
+    //! \return # of configured channels.
+    virtual unsigned int getNumOfChannels() override;
+    //! \return Additional informations of channels to be stored.
+    virtual XString getChannelInfoStrings() override;
+    //! \return Trigger candidates
+    virtual std::deque<XString> hardwareTriggerNames() override;
+    //! Prepares instrumental setups for timing.
+    virtual double setupTimeBase() override;
+    //! Prepares instrumental setups for channels.
+    virtual void setupChannels() override;
+    //! Prepares instrumental setups for trigger.
+    virtual void setupHardwareTrigger() override;
+    //! Clears trigger settings.
+    virtual void disableHardwareTriggers() override;
+    //! \return # of samples per channel acquired from the arm.
+    virtual uint64_t getTotalSampsAcquired() override;
+    //! \return # of new samples per channel stored in the driver's ring buffer from the current read position.
+    virtual uint32_t getNumSampsToBeRead() override;
+    //! Sets the position for the next reading operated by a readAcqBuffer() function.
+    //! \arg pos position from the hardware arm.
+    //! \return true if the operation is sucessful
+    virtual bool setReadPositionAbsolute(uint64_t pos) override;
+    //! Sets the position for the next reading operated by a readAcqBuffer() function.
+    virtual void setReadPositionFirstPoint() override;
+    //! Copies data from driver's ring buffer from the current read position.
+    //! The position for the next reading will be advanced by the return value.
+    //! \arg buf to which 16bitxChannels stream is stored, packed by channels first.
+    //! \return # of samples per channel read.
+    virtual uint32_t readAcqBuffer(uint32_t size, tRawAI *buf) override;
+private:
+    enum {NUM_CH = 2, RingSize = 1024*1024*8, //per channel, 32MB.
+          ChunkSize = 8192, NoiseTableSize = 65536};
+    const shared_ptr<XDoubleNode> m_sampleRate;
+    const shared_ptr<XDoubleNode> m_signalAmplitude;
+    const shared_ptr<XDoubleNode> m_offsetFreq;
+    const shared_ptr<XDoubleNode> m_t2Star;
+    const shared_ptr<XDoubleNode> m_t2;
+    const shared_ptr<XDoubleNode> m_noiseLevel;
+
+    double m_smplPerSec;
+    AcqBuffer<tRawAI> m_ring; //!< NUM_CH * RingSize.
+    atomic<uint64_t> m_totalSmpsPerCh; //!< # of samples per channel written from the origin.
+    uint64_t m_currRdPos; //!< absolute position for next reading.
+    XTime m_origin; //!< wall-clock time of the arm.
+    std::vector<float> m_noiseTable; //!< standard normal deviates.
+    std::vector<std::complex<double>> m_signal; //!< scratch for synthesize().
+    unique_ptr<XThread> m_threadGen;
+    void *executeGeneration(const atomic<bool> &);
+    //! Synthesizes samples from \a pos into \a buf.
+    void synthesize(const Snapshot &shot,
+        const std::vector<shared_ptr<const SimulatedExcitations>> &excitations,
+        uint64_t pos, unsigned int len, uint32_t &rnd, tRawAI *buf);
+};
+
+#endif // SIMULATEDREALTIMEDSO_H
@@ -90,22 +90,21 @@ XThamwayPROT3DSO::stopAcquision() {
         fprintf(stderr, "stop acq., total=%llu\n", (long long unsigned int)getTotalSampsAcquired());
         //allocates buffers.
         m_chunks.resize(NumChunks);
+        allocateAcqBuffer(m_ringBuffer, (size_t)ChunkSize * NumChunks);
         m_totalSmpsPerCh = 0;
         m_wrChunkEnd = 0;
         m_wrChunkBegin = 0;
         m_currRdChunk = 0;
         m_currRdPos = 0;
-        for(auto &&x: m_chunks) {
-            x.data.reserve(ChunkSize);
-            x.data.clear();
+        for(unsigned int i = 0; i < m_chunks.size(); ++i) {
+            auto &x = m_chunks[i];
+            x.data = &m_ringBuffer[(size_t)i * ChunkSize];
+            x.size = 0;
             x.ioInProgress = false;
             x.posAbsPerCh = 0;
         }
         if(isMemLockAvailable()) {
             mlock(this, sizeof(XThamwayPROT3DSO));
-            for(auto &&x: m_chunks) {
-                mlock(&x.data[0], x.data.capacity() * sizeof(tRawAI));
-            }
         }
     }
 }
@@ -183,7 +182,7 @@ XThamwayPROT3DSO::setReadPositionAbsolute(uint64_t pos) {
     for(m_currRdChunk = m_wrChunkEnd; m_currRdChunk != m_wrChunkBegin;) {
         uint64_t pos_abs_per_ch = m_chunks[m_currRdChunk].posAbsPerCh;
         uint64_t pos_abs_per_ch_end = pos_abs_per_ch +
-            m_chunks[m_currRdChunk].data.size() / getNumOfChannels();
+            m_chunks[m_currRdChunk].size / getNumOfChannels();
         if((pos >= pos_abs_per_ch) && (pos < pos_abs_per_ch_end)) {
             m_currRdPos = (pos - pos_abs_per_ch) * getNumOfChannels();
             fprintf(stderr, "Set readpos at %u, chunk %u, rpos %u.\n", (unsigned int)pos, (unsigned int)m_currRdChunk, (unsigned int)m_currRdPos);
@@ -254,12 +253,12 @@ XThamwayPROT3DSO::readAcqBuffer(uint32_t size, tRawAI *buf) {
             fprintf(stderr, "Unexpected collision\n");
             break; //nothing to read.
         }
-        if(chunk.data.size() < m_currRdPos) {
-            fprintf(stderr, "??? %d < %d\n", chunk.data.size(), m_currRdPos);
+        if(chunk.size < m_currRdPos) {
+            fprintf(stderr, "??? %d < %d\n", (int)chunk.size, m_currRdPos);
             break;
         }
 
-        ssize_t len = std::min((uint32_t)chunk.data.size() - m_currRdPos, size);
+        ssize_t len = std::min((uint32_t)chunk.size - m_currRdPos, size);
         if(m_swapTraces) {
             //copies data with word swapping.
             //test results i7 2.5GHz, OSX10.12, 3.7GB/s
@@ -279,7 +278,7 @@ XThamwayPROT3DSO::readAcqBuffer(uint32_t size, tRawAI *buf) {
             fprintf(stderr, "Ring buffer has been overwritten\n");
             break; //collision.
         }
-        if(m_currRdPos == chunk.data.size()) {
+        if(m_currRdPos == chunk.size) {
             XScopedLock<XMutex> lock(m_acqMutex);
             m_currRdChunk++;
             if(m_currRdChunk == m_chunks.size()) m_currRdChunk = 0;
@@ -313,11 +312,12 @@ XThamwayPROT3DSO::executeAsyncRead(const atomic<bool> &terminated) {
             if(next_idx == m_chunks.size())
                 next_idx = 0;
             m_wrChunkEnd = next_idx;
-            chunk.data.resize(ChunkSize, 0x4f4f);
+            std::fill(chunk.data + chunk.size, chunk.data + ChunkSize, 0x4f4f);
+            chunk.size = ChunkSize;
             chunk.ioInProgress = true;
             writeBarrier();
-            return interface()->asyncReceive( (char*)&chunk.data[0],
-                    chunk.data.size() * sizeof(tRawAI));
+            return interface()->asyncReceive( (char*)chunk.data,
+                    chunk.size * sizeof(tRawAI));
         };
         try {
             auto async = issue_async_read();
@@ -336,13 +336,13 @@ XThamwayPROT3DSO::executeAsyncRead(const atomic<bool> &terminated) {
             {
                 XScopedLock<XMutex> lock(m_acqMutex);
                 chunk.ioInProgress = false;
-                chunk.data.resize(count);
+                chunk.size = count;
                 if(wridx == m_wrChunkBegin) {
                     //rearranges indices to indicate ready for read.
                     while( !m_chunks[wridx].ioInProgress && (wridx != m_wrChunkEnd)) {
                         m_chunks[wridx].posAbsPerCh = m_totalSmpsPerCh;
                         writeBarrier();
-                        m_totalSmpsPerCh += m_chunks[wridx].data.size() / getNumOfChannels();
+                        m_totalSmpsPerCh += m_chunks[wridx].size / getNumOfChannels();
                         wridx++;
                         if(wridx == m_chunks.size()) wridx = 0;
                         m_wrChunkBegin = wridx;
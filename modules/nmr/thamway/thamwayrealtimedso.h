@@ -75,9 +75,11 @@ private:
     struct Chunk {
         bool ioInProgress = false;
         uint64_t posAbsPerCh = 0; //# of samples per channel at data[0] from the origin.
-        std::vector<tRawAI> data;
+        tRawAI *data = nullptr; //ChunkSize samples inside m_ringBuffer.
+        size_t size = 0; //# of samples filled.
     };
     std::vector<Chunk> m_chunks; //Ring buffer, Chunksize * NumChunks * sizeof(tRawAI).
+    AcqBuffer<tRawAI> m_ringBuffer; //Contiguous storage for m_chunks.
     std::vector<unique_ptr<XThread>> m_acqThreads;
     XMutex m_acqMutex;
     bool m_swapTraces;
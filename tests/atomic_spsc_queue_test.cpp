@@ -0,0 +1,136 @@
+/*
+ * atomic_spsc_queue_test.cpp
+ *
+ * Stress test and benchmark of atomic_spsc_chunked_queue, as used for software-trigger stamps.
+ * A writer stamps at 100 kHz (every 10 samples of a 1 MHz clock) in real time,
+ * a reader pops the stamps older than the clock like XRealTimeAcqDSO, and
+ * another thread clears the queue occasionally.
+ */
+
+#include "support.h"
+
+#include <stdint.h>
+#include <thread>
+#include <chrono>
+
+#include "atomic_queue.h"
+
+#define SAMPLE_RATE 1000000uLL
+#define STAMP_INTERVAL 10uLL //100 kHz
+#define DURATION_SEC 2
+#define BURST_SIZE 3000000
+
+typedef atomic_spsc_chunked_queue<uint64_t> Queue;
+Queue g_queue;
+atomic<uint64_t> g_clock = 0; //samples elapsed.
+atomic<uint64_t> g_pushed = 0;
+atomic<int> g_writer_done = 0;
+
+void
+writer_routine(void) {
+    auto start = std::chrono::steady_clock::now();
+    uint64_t cnt = 0;
+    for(;;) {
+        double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if(t > DURATION_SEC) break;
+        uint64_t now = (uint64_t)(t * SAMPLE_RATE);
+        while(cnt + STAMP_INTERVAL <= now) {
+            cnt += STAMP_INTERVAL;
+            g_queue.push(cnt);
+            ++g_pushed;
+        }
+        g_clock = now;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    g_writer_done = 1;
+}
+
+int
+main(int argc, char **argv) {
+    //burst without a reader, beyond a few chunks.
+    {
+        Queue queue;
+        auto start = std::chrono::steady_clock::now();
+        for(uint64_t i = 1; i <= BURST_SIZE; i++)
+            queue.push(i);
+        double t_push = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        uint64_t x, expected = 1;
+        start = std::chrono::steady_clock::now();
+        while(queue.front( &x)) {
+            if(x != expected) {
+                printf("burst:failed at %llu, expected %llu\n", (unsigned long long)x, (unsigned long long)expected);
+                return -1;
+            }
+            queue.pop();
+            expected++;
+        }
+        double t_pop = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if(expected != BURST_SIZE + 1) {
+            printf("burst:failed, %llu items popped\n", (unsigned long long)expected - 1);
+            return -1;
+        }
+        printf("burst: push %.1f ns/item, pop %.1f ns/item\n",
+            t_push * 1e9 / BURST_SIZE, t_pop * 1e9 / BURST_SIZE);
+    }
+
+    //items cleared but not skipped yet are not counted as waiting.
+    {
+        Queue queue;
+        for(uint64_t i = 1; i <= 100; i++)
+            queue.push(i);
+        queue.clear();
+        for(uint64_t i = 101; i <= 105; i++)
+            queue.push(i);
+        uint64_t size = queue.size(), x = 0;
+        if((size != 5) || !queue.front( &x) || (x != 101) || (queue.size() != 5)) {
+            printf("clear:failed, %llu waiting, front %llu\n", (unsigned long long)size, (unsigned long long)x);
+            return -1;
+        }
+    }
+
+    std::thread writer( &writer_routine);
+    std::thread clearer([]{
+        for(int i = 0; i < 4; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(DURATION_SEC * 1000 / 5));
+            g_queue.clear();
+        }
+    });
+
+    //reader, polling like XRealTimeAcqDSO::acquire().
+    uint64_t popped = 0, last = 0, max_pending = 0;
+    double max_latency = 0.0;
+    for(;;) {
+        bool done = g_writer_done;
+        uint64_t threshold = g_clock;
+        max_pending = std::max(max_pending, g_queue.size());
+        auto start = std::chrono::steady_clock::now();
+        uint64_t x;
+        while(g_queue.front( &x) && (x <= threshold)) {
+            if(x <= last) {
+                printf("order:failed %llu after %llu\n", (unsigned long long)x, (unsigned long long)last);
+                return -1;
+            }
+            last = x;
+            g_queue.pop();
+            popped++;
+        }
+        max_latency = std::max(max_latency,
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        if(done && !g_queue.size())
+            break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    writer.join();
+    clearer.join();
+
+    printf("%llu stamps at %llu Hz: %llu popped, %llu discarded, max pending %llu, max drain time %.3f ms\n",
+        (unsigned long long)g_pushed, (unsigned long long)(SAMPLE_RATE / STAMP_INTERVAL),
+        (unsigned long long)popped, (unsigned long long)g_queue.discarded(),
+        (unsigned long long)max_pending, max_latency * 1e3);
+    if(popped + g_queue.discarded() != g_pushed) {
+        printf("failed\n");
+        return -1;
+    }
+    printf("succeeded\n");
+    return 0;
+}
@@ -0,0 +1,11 @@
+TARGET = atomic_spsc_queue_test
+
+include(tests.pri)
+
+HEADERS += \
+    support.h \
+    ../kame/atomic_queue.h
+
+SOURCES += \
+    atomic_spsc_queue_test.cpp \
+    support.cpp
@@ -0,0 +1,177 @@
+/*
+ * chunkedring_test.cpp
+ *
+ * Test of chunked_ring used for XXYPlot, against std::deque.
+ * Appending threads commit copies of a shared ring optimistically, as transactions do.
+ * Bulk fills, as in snapshots of XWaveNGraph, are timed to scale linearly.
+ */
+
+#include "support.h"
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+#include "chunkedring.h"
+
+#define NUM_THREADS 4
+#define NUM_POINTS 200000
+#define NUM_BULK_POINTS 4000000
+
+typedef chunked_ring<long, 64> Ring;
+
+static bool
+equals(const Ring &ring, const std::deque<long> &ref) {
+	if(ring.size() != ref.size())
+		return false;
+	for(size_t i = 0; i < ref.size(); ++i)
+		if(ring[i] != ref[i])
+			return false;
+	size_t i = 0;
+	bool ok = true;
+	ring.for_each_span([&](const long *p, size_t len) {
+		for(size_t k = 0; k < len; ++k)
+			ok = ok && (p[k] == ref[i++]);
+	});
+	return ok && (i == ref.size());
+}
+
+int
+main(int, char**) {
+	std::mt19937 gen;
+	//copies stay intact while others are appended.
+	{
+		Ring ring;
+		std::deque<long> ref;
+		std::vector<std::pair<Ring, std::deque<long>>> copies;
+		size_t capacity = 1000;
+		for(long i = 0; i < NUM_POINTS; ++i) {
+			if(gen() % 5000 == 0)
+				capacity = 1 + gen() % 3000;
+			if(gen() % 1000 == 0)
+				copies.emplace_back(ring, ref);
+			if(copies.size() && (gen() % 3 == 0)) {
+				//appends to a copy, diverging from the others.
+				auto &c(copies[gen() % copies.size()]);
+				c.first.push_back(-i, capacity);
+				c.second.push_back(-i);
+				while(c.second.size() > capacity)
+					c.second.pop_front();
+			}
+			if(gen() % 100 == 0) {
+				//a block, also larger than the capacity.
+				std::vector<long> block(gen() % 4000);
+				for(auto &&x: block) {
+					x = i;
+					ref.push_back(i++);
+				}
+				ring.append(block.data(), block.size(), capacity);
+			}
+			ring.push_back(i, capacity);
+			ref.push_back(i);
+			while(ref.size() > capacity)
+				ref.pop_front();
+		}
+		if( !equals(ring, ref)) {
+			printf("failed\n");
+			return -1;
+		}
+		for(auto &&c: copies) {
+			if( !equals(c.first, c.second)) {
+				printf("copy failed\n");
+				return -1;
+			}
+		}
+		printf("%u copies ok\n", (unsigned int)copies.size());
+	}
+	//bulk fills cost the same per point for any size.
+	{
+		std::vector<long> pts(NUM_BULK_POINTS);
+		for(long i = 0; i < NUM_BULK_POINTS; ++i)
+			pts[i] = i;
+		double t_small = 0.0;
+		for(size_t n: {NUM_BULK_POINTS / 16, NUM_BULK_POINTS}) {
+			Ring ring;
+			Ring copy = ring;
+			auto start = std::chrono::steady_clock::now();
+			ring.assign(pts.data(), n);
+			double t_assign = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			start = std::chrono::steady_clock::now();
+			ring.clear();
+			for(size_t i = 0; i < n; ++i)
+				ring.push_back(pts[i]);
+			double t_push = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			std::deque<long> ref(pts.begin(), pts.begin() + n);
+			if( !equals(ring, ref) || !copy.empty()) {
+				printf("bulk failed\n");
+				return -1;
+			}
+			ring.assign(pts.data(), n);
+			if( !equals(ring, ref)) {
+				printf("bulk failed\n");
+				return -1;
+			}
+			printf("%u points: assign %.2f ns/point, push_back %.2f ns/point\n", (unsigned int)n,
+				t_assign * 1e9 / n, t_push * 1e9 / n);
+			if(t_small && (t_push / n > 8.0 * t_small)) {
+				printf("push_back not linear\n");
+				return -1;
+			}
+			t_small = t_push / n;
+		}
+	}
+	//optimistic commits from threads.
+	{
+		Ring committed;
+		long version = 0; //of committed.
+		std::mutex mutex;
+		atomic<int> retries = 0;
+		auto start = std::chrono::steady_clock::now();
+		std::vector<std::thread> threads;
+		for(int t = 0; t < NUM_THREADS; ++t) {
+			threads.emplace_back([&, t]() {
+				for(long i = 0; i < NUM_POINTS / NUM_THREADS; ++i) {
+					for(;;) {
+						Ring ring;
+						long v;
+						{
+							std::lock_guard<std::mutex> lock(mutex);
+							ring = committed;
+							v = version;
+						}
+						ring.push_back(t * NUM_POINTS + i, NUM_POINTS / 2);
+						std::lock_guard<std::mutex> lock(mutex);
+						if(v == version) {
+							committed = ring;
+							++version;
+							break;
+						}
+						++retries;
+					}
+				}
+			});
+		}
+		for(auto &&th: threads)
+			th.join();
+		double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::vector<long> next(NUM_THREADS, -1);
+		bool ok = (committed.size() == NUM_POINTS / 2);
+		//points from each thread are in order.
+		committed.for_each_span([&](const long *p, size_t len) {
+			for(size_t k = 0; k < len; ++k) {
+				long th = p[k] / NUM_POINTS, i = p[k] % NUM_POINTS;
+				ok = ok && (i > next[th]);
+				next[th] = i;
+			}
+		});
+		printf("%d points by %d threads, %d retries, %.1f ns/point\n", NUM_POINTS, NUM_THREADS,
+			(int)retries, t * 1e9 / NUM_POINTS);
+		if( !ok) {
+			printf("failed\n");
+			return -1;
+		}
+	}
+	printf("succeeded\n");
+	return 0;
+}
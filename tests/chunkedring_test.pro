@@ -0,0 +1,13 @@
+TARGET = chunkedring_test
+
+include(tests.pri)
+
+INCLUDEPATH += $${_PRO_FILE_PWD_}/../kame/graph
+
+HEADERS += \
+    support.h \
+    ../kame/graph/chunkedring.h
+
+SOURCES += \
+    chunkedring_test.cpp \
+    support.cpp
@@ -0,0 +1,108 @@
+/*
+ * darkpsd_test.cpp
+ *
+ * Test and benchmark of DarkPSD against the former five-transform estimation in XNMRPulseAnalyzer.
+ * Reports analysis time per record.
+ * Usage: darkpsd_test [FFT length, default 16384] [signal length, default 4000] [bg length, default 4000]
+ */
+
+#include "support.h"
+
+#include <chrono>
+#include <random>
+#include "fft.h"
+
+#define NUM_RECORDS 200
+
+//! As formerly in XNMRPulseAnalyzer::analyze().
+static void
+darkPSDReference(FFT &ft, const std::complex<double> *bg, int bglength, int length, double interval,
+	double *darkpsdsum) {
+	int fftlen = ft.length();
+	std::vector<std::complex<double> > darkin(fftlen, 0.0), darkout(fftlen);
+	int bginplen = std::min(bglength, fftlen);
+	double normalize = 0.0;
+	for(int i = 0; i < bginplen; i++) {
+		double tw = sin(2.0*M_PI*i/(double)bginplen);
+		darkin[i] = bg[i] * tw;
+		normalize += tw * tw;
+	}
+	normalize = 1.0 / normalize * interval;
+	ft.exec(darkin, darkout);
+	for(int i = 0; i < fftlen; i++) {
+		darkin[i] = std::norm(darkout[i]) * normalize;
+	}
+	ft.exec(darkin, darkout); //FT of PSD.
+	std::vector<std::complex<double> > sigma2(darkout);
+	std::fill(darkin.begin(), darkin.end(), std::complex<double>(0.0));
+	double x = sqrt(1.0 / length / fftlen);
+	for(int i = 0; i < length; i++) {
+		darkin[i] = x;
+	}
+	ft.exec(darkin, darkout); //FT of rect. window.
+	for(int i = 0; i < fftlen; i++) {
+		darkin[i] = std::norm(darkout[i]);
+	}
+	ft.exec(darkin, darkout); //FT of norm of (FT of rect. window).
+	for(int i = 0; i < fftlen; i++) {
+		darkin[i] = std::conj(darkout[i] * sigma2[i]);
+	}
+	ft.exec(darkin, darkout); //Convolution.
+	normalize = 1.0 / fftlen;
+	for(int i = 0; i < fftlen; i++) {
+		darkpsdsum[i] += std::real(darkout[i]) * normalize;
+	}
+}
+
+static double
+elapsed(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int
+main(int argc, char **argv) {
+	int fftlen = FFT::fitLength((argc > 1) ? atoi(argv[1]) : 16384);
+	int length = (argc > 2) ? atoi(argv[2]) : 4000;
+	int bglength = (argc > 3) ? atoi(argv[3]) : 4000;
+	if((length > fftlen) || (bglength < 2)) {
+		printf("invalid lengths\n");
+		return -1;
+	}
+	const double interval = 1e-6;
+
+	std::mt19937 gen;
+	std::uniform_real_distribution<double> uni(-0.5, 0.5);
+	std::vector<std::complex<double> > bg(bglength * NUM_RECORDS);
+	for(auto &&z: bg)
+		z = std::complex<double>(uni(gen), uni(gen));
+	//a line in the noise.
+	for(int i = 0; i < (int)bg.size(); i++)
+		bg[i] += std::polar(0.3, 0.1 * i);
+
+	std::vector<double> sum1(fftlen, 0.0), sum2(fftlen, 0.0);
+	FFT ft(-1, fftlen);
+	auto start = std::chrono::steady_clock::now();
+	for(int k = 0; k < NUM_RECORDS; k++)
+		darkPSDReference(ft, &bg[k * bglength], bglength, length, interval, &sum1[0]);
+	double t_ref = elapsed(start);
+
+	start = std::chrono::steady_clock::now();
+	DarkPSD dark(fftlen, length);
+	for(int k = 0; k < NUM_RECORDS; k++)
+		dark.accumulate( &bg[k * bglength], bglength, interval, &sum2[0]);
+	double t_new = elapsed(start);
+
+	double maxerr = 0.0, maxval = 0.0;
+	for(int i = 0; i < fftlen; i++) {
+		maxerr = std::max(maxerr, fabs(sum1[i] - sum2[i]));
+		maxval = std::max(maxval, fabs(sum1[i]));
+	}
+	printf("fftlen=%d length=%d bglength=%d: five FFTs %.1f us/record, DarkPSD %.1f us/record, rel. err. %g\n",
+		fftlen, length, bglength, t_ref * 1e6 / NUM_RECORDS, t_new * 1e6 / NUM_RECORDS, maxerr / maxval);
+	if( !(maxerr <= 1e-9 * maxval)) {
+		printf("failed\n");
+		return -1;
+	}
+	printf("succeeded\n");
+	return 0;
+}
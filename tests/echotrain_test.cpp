@@ -0,0 +1,138 @@
+/*
+ * echotrain_test.cpp
+ *
+ * Test and benchmark of EchoTrain against the former echo summation and background subtraction
+ * in XNMRPulseAnalyzer. Reports analysis time per record.
+ * Usage: echotrain_test [# of echoes, default 32] [echo period, default 4000] [length, default 2000]
+ */
+
+#include "support.h"
+
+#include <chrono>
+#include <random>
+#include "echotrain.h"
+
+#define NUM_RECORDS 50
+
+//! As formerly in XNMRPulseAnalyzer::backgroundSub(), without PNR.
+static void
+backgroundSubReference(std::vector<std::complex<double> > &wave, int pos, int bgpos, int bglength) {
+	std::complex<double> bg = 0;
+	if(bglength) {
+		double normalize = 0.0;
+		for(int i = 0; i < bglength; i++) {
+			double z = FFT::windowFuncHamming( (double)i / bglength - 0.5);
+			bg += z * wave[pos + i + bgpos];
+			normalize += z;
+		}
+		bg /= normalize;
+	}
+	for(int i = 0; i < wave.size(); i++) {
+		wave[i] -= bg;
+	}
+}
+
+//! As formerly in XNMRPulseAnalyzer::analyze().
+static void
+echoTrainReference(std::vector<std::complex<double> > &wave, int pos, int length, int bgpos, int bglength,
+	int numechoes, int echoperiod) {
+	bool bg_after_last_echo = (echoperiod < bgpos + bglength);
+	std::complex<double> *dsowave = &wave[0];
+	if(bg_after_last_echo)
+		backgroundSubReference(wave, pos, bgpos, bglength);
+	for(int i = 1; i < numechoes; i++) {
+		int rpos = pos + i * echoperiod;
+		for(int j = 0;
+		j < ( !bg_after_last_echo ? std::max(bgpos + bglength, length) : length); j++) {
+			int k = rpos + j;
+			if(i == 1)
+				dsowave[pos + j] /= (double)numechoes;
+			dsowave[pos + j] += dsowave[k] / (double)numechoes;
+		}
+	}
+	if( !bg_after_last_echo)
+		backgroundSubReference(wave, pos, bgpos, bglength);
+}
+
+static double
+elapsed(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool
+test(const std::vector<std::complex<double> > &record, int pos, int length, int bgpos, int bglength,
+	int numechoes, int echoperiod) {
+	bool bg_after_last_echo = (echoperiod < bgpos + bglength);
+	int sumlength = bg_after_last_echo ? length : std::max(bgpos + bglength, length);
+
+	std::vector<std::complex<double> > wave1(record), wave2(record);
+	auto start = std::chrono::steady_clock::now();
+	for(int k = 0; k < NUM_RECORDS; k++) {
+		std::copy(record.begin(), record.end(), wave1.begin());
+		echoTrainReference(wave1, pos, length, bgpos, bglength, numechoes, echoperiod);
+	}
+	double t_ref = elapsed(start);
+
+	EchoTrain engine(numechoes, echoperiod, sumlength, length, bgpos, bglength, &FFT::windowFuncHamming);
+	std::vector<std::complex<double> > amps(numechoes);
+	start = std::chrono::steady_clock::now();
+	for(int k = 0; k < NUM_RECORDS; k++) {
+		std::copy(record.begin(), record.end(), wave2.begin());
+		std::fill(amps.begin(), amps.end(), 0.0);
+		engine.exec( &wave2[pos], &amps[0]);
+	}
+	double t_new = elapsed(start);
+
+	double maxerr = 0.0, maxval = 0.0;
+	for(int i = 0; i < sumlength; i++) {
+		maxerr = std::max(maxerr, std::abs(wave1[pos + i] - wave2[pos + i]));
+		maxval = std::max(maxval, std::abs(wave1[pos + i]));
+	}
+	//The echoes decay as exp(-t/T2), see main().
+	double decay = std::abs(amps[numechoes - 1] / amps[0]);
+	double expected = exp( -(numechoes - 1) * echoperiod / (double)(numechoes * echoperiod));
+	printf("%d echoes, period=%d, length=%d, bg %s: former %.1f us/record, EchoTrain %.1f us/record, rel. err. %g,"
+		" decay %.3f (%.3f)\n",
+		numechoes, echoperiod, length, bg_after_last_echo ? "after the last" : "within echoes",
+		t_ref * 1e6 / NUM_RECORDS, t_new * 1e6 / NUM_RECORDS, maxerr / maxval, decay, expected);
+	return (maxerr <= 1e-12 * maxval) && (fabs(decay - expected) < 0.05);
+}
+
+int
+main(int argc, char **argv) {
+	int numechoes = (argc > 1) ? atoi(argv[1]) : 32;
+	int echoperiod = (argc > 2) ? atoi(argv[2]) : 4000;
+	int length = (argc > 3) ? atoi(argv[3]) : 2000;
+	if((numechoes < 2) || (length * 2 > echoperiod)) {
+		printf("invalid lengths\n");
+		return -1;
+	}
+	int pos = 100;
+	int dso_len = pos + echoperiod * (numechoes + 1);
+
+	std::mt19937 gen;
+	std::normal_distribution<double> gauss;
+	std::vector<std::complex<double> > record(dso_len);
+	for(int i = 0; i < dso_len; i++) {
+		record[i] = std::complex<double>(0.2, -0.1) + 0.05 * std::complex<double>(gauss(gen), gauss(gen));
+		int e = (i - pos) / echoperiod;
+		int j = (i - pos) % echoperiod;
+		if((i >= pos) && (e < numechoes) && (j < length)) {
+			//An echo centered in the window, T2 = numechoes * echoperiod.
+			double dt = j - length / 2;
+			record[i] += std::polar(exp( -fabs(dt) / length * 16.0 - e / (double)numechoes), 0.3);
+		}
+	}
+
+	bool ok = true;
+	//Background within each period.
+	ok = test(record, pos, length, length, echoperiod - length, numechoes, echoperiod) && ok;
+	//Background after the last echo.
+	ok = test(record, pos, length, numechoes * echoperiod, echoperiod / 2, numechoes, echoperiod) && ok;
+	if( !ok) {
+		printf("failed\n");
+		return -1;
+	}
+	printf("succeeded\n");
+	return 0;
+}
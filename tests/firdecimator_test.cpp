@@ -0,0 +1,116 @@
+/*
+ * firdecimator_test.cpp
+ *
+ * Test and benchmark of FIRDecimator, the decimation stage in XRealTimeAcqDSO.
+ * Streamed output is compared with a single call, the gain is checked in the pass and stop bands,
+ * and the channels are checked to be independent. Reports the throughput.
+ * Usage: firdecimator_test [ratio, default 8]
+ */
+
+#include "support.h"
+
+#include <chrono>
+#include <random>
+#include "fir.h"
+
+#define NUM_CHANNELS 2
+#define NUM_SAMPLES 200000
+
+static double
+elapsed(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//! Amplitude of a tone in channel \a ch of the decimated output, skipping the filter warm-up.
+static double
+toneAmplitude(unsigned int ratio, double freq, unsigned int ch) {
+	const double amp = 10000.0;
+	std::vector<int16_t> src(NUM_SAMPLES * NUM_CHANNELS), dst(src.size());
+	for(int i = 0; i < NUM_SAMPLES; i++)
+		for(int c = 0; c < NUM_CHANNELS; c++)
+			src[i * NUM_CHANNELS + c] = (c == (int)ch) ? lrint(amp * cos(2.0 * M_PI * freq * i)) : 0;
+	FIRDecimator dec(ratio, NUM_CHANNELS);
+	unsigned int cnt = dec.exec( &src[0], NUM_SAMPLES, &dst[0], NUM_SAMPLES);
+	double sumsq = 0.0;
+	unsigned int n = 0;
+	for(unsigned int i = cnt / 4; i < cnt; i++, n++) {
+		double y = dst[i * NUM_CHANNELS + ch];
+		sumsq += y * y;
+		for(int c = 0; c < NUM_CHANNELS; c++)
+			if((c != (int)ch) && dst[i * NUM_CHANNELS + c])
+				return -1.0; //leaked into the other channel.
+	}
+	return sqrt(2.0 * sumsq / n) / amp;
+}
+
+int
+main(int argc, char **argv) {
+	unsigned int ratio = (argc > 1) ? atoi(argv[1]) : 8;
+	if(ratio < 2) {
+		printf("invalid ratio\n");
+		return -1;
+	}
+	bool failed = false;
+
+	//A noisy trace with a tone, as a DSO record.
+	std::mt19937 gen(1);
+	std::normal_distribution<double> noise(0.0, 1000.0);
+	std::vector<int16_t> src(NUM_SAMPLES * NUM_CHANNELS);
+	for(int i = 0; i < NUM_SAMPLES; i++)
+		for(int c = 0; c < NUM_CHANNELS; c++)
+			src[i * NUM_CHANNELS + c] = lrint(8000.0 * sin(2.0 * M_PI * 0.1 / ratio * i + c) + noise(gen));
+
+	//# of outputs, the first one after taps() inputs.
+	FIRDecimator dec(ratio, NUM_CHANNELS);
+	std::vector<int16_t> whole(src.size());
+	auto start = std::chrono::steady_clock::now();
+	unsigned int cnt = dec.exec( &src[0], NUM_SAMPLES, &whole[0], NUM_SAMPLES);
+	double t = elapsed(start);
+	unsigned int cnt_expected = (NUM_SAMPLES - dec.taps()) / ratio + 1;
+	if(cnt != cnt_expected) {
+		printf("%u outputs, expected %u\n", cnt, cnt_expected);
+		failed = true;
+	}
+
+	//Streamed in chunks of random sizes, as from the ring buffer, the history is kept.
+	dec.reset();
+	std::vector<int16_t> streamed(src.size());
+	std::uniform_int_distribution<unsigned int> chunk(1, 3 * dec.taps());
+	unsigned int cnt_streamed = 0;
+	for(unsigned int i = 0; i < NUM_SAMPLES;) {
+		unsigned int len = std::min(chunk(gen), NUM_SAMPLES - i);
+		cnt_streamed += dec.exec( &src[i * NUM_CHANNELS], len,
+			&streamed[cnt_streamed * NUM_CHANNELS], NUM_SAMPLES - cnt_streamed);
+		i += len;
+	}
+	if((cnt_streamed != cnt) || !std::equal(whole.begin(), whole.begin() + cnt * NUM_CHANNELS, streamed.begin())) {
+		printf("streamed output differs\n");
+		failed = true;
+	}
+
+	//Output is limited by dst_len.
+	dec.reset();
+	if(dec.exec( &src[0], NUM_SAMPLES, &streamed[0], 3) != 3) {
+		printf("dst_len exceeded\n");
+		failed = true;
+	}
+
+	//Unity gain at DC and in the pass band, attenuated above the decimated Nyquist freq.
+	double gain_dc = toneAmplitude(ratio, 0.0, 0) / sqrt(2.0);
+	double gain_pass = toneAmplitude(ratio, FIRDecimator::passBand(ratio) / 2, 1);
+	double gain_stop = toneAmplitude(ratio, std::min(1.5 / ratio, 0.45), 0);
+	printf("ratio=%u taps=%u: gain %.4f at DC, %.4f in the pass band, %.2g in the stop band\n",
+		ratio, dec.taps(), gain_dc, gain_pass, gain_stop);
+	if((fabs(gain_dc - 1.0) > 1e-3) || (fabs(gain_pass - 1.0) > 0.01) || (gain_stop < 0) || (gain_stop > 0.01)) {
+		printf("gain out of range\n");
+		failed = true;
+	}
+
+	printf("%.1f Msamples/s per channel\n", NUM_SAMPLES / t * 1e-6);
+	if(failed) {
+		printf("failed\n");
+		return -1;
+	}
+	printf("succeeded\n");
+	return 0;
+}
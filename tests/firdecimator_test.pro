@@ -0,0 +1,29 @@
+TARGET = firdecimator_test
+
+include(tests.pri)
+
+#sources in kame/math see support.h here first.
+INCLUDEPATH = $${_PRO_FILE_PWD_} $${INCLUDEPATH} $${_PRO_FILE_PWD_}/../kame/math
+
+HEADERS += \
+    support.h \
+    ../kame/math/fft.h \
+    ../kame/math/fir.h
+
+SOURCES += \
+    firdecimator_test.cpp \
+    ../kame/math/fft.cpp \
+    ../kame/math/fir.cpp \
+    support.cpp
+
+unix {
+    macx {
+        INCLUDEPATH += /opt/local/include
+        LIBS += -L/opt/local/lib/
+        LIBS += -lfftw3 -lgsl
+    }
+    else {
+        CONFIG += link_pkgconfig
+        PKGCONFIG += fftw3 gsl
+    }
+}
@@ -0,0 +1,236 @@
+/*
+ * graphgl_test.cpp
+ *
+ * Benchmark of the two ways of drawing plot vertices in OpenGL, in an offscreen surfaceless EGL context,
+ * e.g. Mesa llvmpipe. XQGraphPainter itself is not linked; the GL calls of both ways are written out here.
+ * Formerly, plots were compiled into a display list and executed on redraws, and the list was called on repaints.
+ * Now, vertices are uploaded in bulk to a buffer on redraws, and the buffer is drawn on repaints.
+ * Reports frame times of the GL calls alone, and checks that both give the same pixels.
+ * The whole painter, with the geometry worker and the widget, is measured by "make graphbench" instead.
+ * Skipped if no OpenGL context is available.
+ * Usage: graphgl_test [# of points, default 1000000] [width, default 1024] [height, default 768]
+ */
+
+#define GL_GLEXT_PROTOTYPES
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+#define NUM_FRAMES 5
+
+//! Same layout as XPlotGeometry::Vertex.
+struct Vertex {
+	GLfloat x, y, z;
+	GLubyte rgba[4];
+};
+
+struct Point {
+	float x, y, z;
+	float r, g, b, a;
+};
+
+static double
+elapsed(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static GLubyte
+toUbyte(float x) {
+	return lrintf(std::min(1.0f, std::max(0.0f, x)) * 255.0f);
+}
+
+//! The GL calls formerly made by XPlot::drawPlot() for a color plot.
+static void
+drawImmediate(const std::vector<Point> &pts) {
+	glLineWidth(1.0);
+	glBegin(GL_LINES);
+	for(size_t i = 1; i < pts.size(); ++i) {
+		for(const Point *p: { &pts[i - 1], &pts[i]}) {
+			glColor4f(p->r, p->g, p->b, p->a);
+			glVertex3f(p->x, p->y, p->z);
+		}
+	}
+	glEnd();
+	glPointSize(2.0);
+	glBegin(GL_POINTS);
+	for(auto &&p: pts) {
+		glColor4f(p.r, p.g, p.b, p.a);
+		glVertex3f(p.x, p.y, p.z);
+	}
+	glEnd();
+}
+
+struct DrawCommand {
+	GLenum primitive;
+	GLfloat size;
+	GLint first;
+	GLsizei count;
+};
+
+//! The GL calls made by XQGraphPainter::drawVertices() with a buffer.
+static void
+drawVertices(GLuint vbo, const std::vector<DrawCommand> &commands) {
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(3, GL_FLOAT, sizeof(Vertex), reinterpret_cast<const GLvoid*>(offsetof(Vertex, x)));
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Vertex), reinterpret_cast<const GLvoid*>(offsetof(Vertex, rgba)));
+	for(auto &&cmd: commands) {
+		if(cmd.primitive == GL_LINES)
+			glLineWidth(cmd.size);
+		if(cmd.primitive == GL_POINTS)
+			glPointSize(cmd.size);
+		glDrawArrays(cmd.primitive, cmd.first, cmd.count);
+	}
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+//! Stages the plot and uploads it at once, with the GL calls of XQGraphPainter::uploadVertices().
+static void
+uploadVertices(GLuint vbo, const std::vector<Point> &pts, std::vector<DrawCommand> &commands) {
+	auto vertex = [](const Point &p) -> Vertex {
+		return {p.x, p.y, p.z, {toUbyte(p.r), toUbyte(p.g), toUbyte(p.b), toUbyte(p.a)}};
+	};
+	std::vector<Vertex> vertices;
+	commands.clear();
+	for(size_t i = 1; i < pts.size(); ++i) {
+		vertices.push_back(vertex(pts[i - 1]));
+		vertices.push_back(vertex(pts[i]));
+	}
+	commands.push_back({GL_LINES, 1.0f, 0, (GLsizei)vertices.size()});
+	for(auto &&p: pts)
+		vertices.push_back(vertex(p));
+	commands.push_back({GL_POINTS, 2.0f, commands.back().count, (GLsizei)pts.size()});
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+//! \return time per frame [s].
+template <class F>
+static double
+benchmark(F draw, int width, int height, std::vector<GLubyte> *pixels = nullptr) {
+	double t = 0.0;
+	for(int k = 0; k < NUM_FRAMES; ++k) {
+		auto start = std::chrono::steady_clock::now();
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		draw();
+		glFinish();
+		t += elapsed(start);
+	}
+	if(pixels) {
+		pixels->resize(width * height * 4);
+		glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, &pixels->at(0));
+	}
+	return t / NUM_FRAMES;
+}
+
+int
+main(int argc, char **argv) {
+	int num_points = (argc > 1) ? atoi(argv[1]) : 1000000;
+	int width = (argc > 2) ? atoi(argv[2]) : 1024;
+	int height = (argc > 3) ? atoi(argv[3]) : 768;
+
+	EGLDisplay dpy = eglGetPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	EGLint major, minor;
+	if((dpy == EGL_NO_DISPLAY) || !eglInitialize(dpy, &major, &minor) || !eglBindAPI(EGL_OPENGL_API)) {
+		printf("no EGL display, skipped\n");
+		return 0;
+	}
+	EGLContext ctx = eglCreateContext(dpy, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, nullptr);
+	if((ctx == EGL_NO_CONTEXT) || !eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx)) {
+		printf("no OpenGL context, skipped\n");
+		return 0;
+	}
+	printf("%s, %s\n", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+
+	GLuint fbo, rb[2];
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glGenRenderbuffers(2, rb);
+	glBindRenderbuffer(GL_RENDERBUFFER, rb[0]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, rb[0]);
+	glBindRenderbuffer(GL_RENDERBUFFER, rb[1]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rb[1]);
+	if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		printf("incomplete framebuffer, skipped\n");
+		return 0;
+	}
+	glViewport(0, 0, width, height);
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	glOrtho(0.0, 1.0, 0.0, 1.0, -1.0, 1.0);
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glEnable(GL_DEPTH_TEST);
+	glDepthFunc(GL_LEQUAL);
+	glClearColor(1.0, 1.0, 1.0, 1.0);
+
+	//A noisy trace in a color plot, as a DSO waveform.
+	std::vector<Point> pts(num_points);
+	srand(1);
+	for(int i = 0; i < num_points; ++i) {
+		float x = (i + 0.5f) / num_points;
+		float y = 0.5f + 0.3f * sinf(2.0f * M_PI * 8.0f * x) + 0.1f * (rand() / (float)RAND_MAX - 0.5f);
+		float t = std::min(1.0f, std::max(0.0f, y));
+		pts[i] = {x, y, 0.0f, t * 255.0f / 256.0f, 0.0f, (1.0f - t) * 255.0f / 256.0f, 0.6f};
+	}
+
+	GLuint list = glGenLists(1);
+	GLuint vbo;
+	glGenBuffers(1, &vbo);
+	std::vector<DrawCommand> commands;
+	std::vector<GLubyte> pixels_imm, pixels_vbo;
+	//Redraws.
+	double t_imm = benchmark([&]{
+		glNewList(list, GL_COMPILE_AND_EXECUTE);
+		drawImmediate(pts);
+		glEndList();
+	}, width, height, &pixels_imm);
+	double t_vbo = benchmark([&]{
+		uploadVertices(vbo, pts, commands);
+		drawVertices(vbo, commands);
+	}, width, height, &pixels_vbo);
+	//Repaints without changes.
+	double t_imm_replay = benchmark([&]{glCallList(list);}, width, height);
+	double t_vbo_replay = benchmark([&]{drawVertices(vbo, commands);}, width, height);
+
+	int maxdiff = 0;
+	size_t ndiff = 0;
+	for(size_t i = 0; i < pixels_imm.size(); ++i) {
+		int d = abs((int)pixels_imm[i] - (int)pixels_vbo[i]);
+		maxdiff = std::max(maxdiff, d);
+		if(d) ++ndiff;
+	}
+	printf("%d points, %dx%d\n", num_points, width, height);
+	printf("redraw: display list %.1f ms/frame, vertex buffer %.1f ms/frame\n", t_imm * 1e3, t_vbo * 1e3);
+	printf("repaint: display list %.1f ms/frame, vertex buffer %.1f ms/frame\n", t_imm_replay * 1e3, t_vbo_replay * 1e3);
+	printf("max. difference %d/255 in %u channels\n", maxdiff, (unsigned int)ndiff);
+	glDeleteBuffers(1, &vbo);
+	glDeleteLists(list, 1);
+	eglDestroyContext(dpy, ctx);
+	eglTerminate(dpy);
+	//Colors are quantized to 8 bits before the interpolation and blending.
+	if(maxdiff > 2) {
+		printf("failed\n");
+		return -1;
+	}
+	printf("succeeded\n");
+	return 0;
+}
@@ -0,0 +1,8 @@
+TARGET = graphgl_test
+
+include(tests.pri)
+
+SOURCES += \
+    graphgl_test.cpp
+
+LIBS += -lEGL -lGL
@@ -0,0 +1,109 @@
+/*
+ * hugepage_allocator_test.cpp
+ *
+ * Test and benchmark of hugepage_allocator against std::allocator, for DSO accumulation banks.
+ * Reports the time for page faults on the first touch, DSO-like sequential accumulation,
+ * and random page-strided reads dominated by TLB misses.
+ * Usage: hugepage_allocator_test [# of samples in M, default 32]
+ */
+
+#include "support.h"
+
+#include <stdint.h>
+#include <vector>
+#include <chrono>
+
+#include "hugepage_allocator.h"
+
+#define NUM_ACCUM 4
+#define NUM_RANDOM_READS (4 * 1024 * 1024)
+#define SRC_SIZE 8192
+
+static double
+elapsed(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <class Vector>
+int64_t
+bench(const char *label, size_t len, const typename Vector::allocator_type &alloc) {
+    auto start = std::chrono::steady_clock::now();
+    Vector record(len, 0, alloc);
+    double t_fault = elapsed(start);
+
+    std::vector<int16_t> src(SRC_SIZE);
+    for(unsigned int i = 0; i < SRC_SIZE; i++)
+        src[i] = (int16_t)(i * 37 - 4096);
+    start = std::chrono::steady_clock::now();
+    for(int k = 0; k < NUM_ACCUM; k++) {
+        for(size_t i = 0; i < len; i += SRC_SIZE) {
+            size_t n = std::min((size_t)SRC_SIZE, len - i);
+            int32_t *p = &record[i];
+            for(size_t j = 0; j < n; j++)
+                p[j] += src[j];
+        }
+    }
+    double t_accum = elapsed(start);
+
+    //one read per random page.
+    uint64_t rnd = 1;
+    int64_t sum = 0;
+    start = std::chrono::steady_clock::now();
+    for(unsigned int i = 0; i < NUM_RANDOM_READS; i++) {
+        rnd = rnd * 6364136223846793005uLL + 1442695040888963407uLL;
+        size_t idx = (size_t)((rnd >> 33) % len);
+        sum += record[idx];
+    }
+    double t_random = elapsed(start);
+    for(size_t i = 0; i < len; i += 4093)
+        sum += record[i];
+
+    printf("%s: first touch %.1f ms (%.2f GB/s), accumulation %.2f GB/s, random read %.1f ns\n",
+        label, t_fault * 1e3, len * sizeof(int32_t) / t_fault * 1e-9,
+        NUM_ACCUM * len * (sizeof(int32_t) * 2 + sizeof(int16_t)) / t_accum * 1e-9,
+        t_random * 1e9 / NUM_RANDOM_READS);
+    return sum;
+}
+
+int
+main(int argc, char **argv) {
+    size_t len = 32;
+    if(argc > 1)
+        len = atoi(argv[1]);
+    len *= 1024 * 1024;
+
+    hugepage_buffer::Backing backing;
+    void *p = hugepage_buffer::allocate(len * sizeof(int32_t), -1, false, &backing);
+    if( !p) {
+        printf("allocation failed\n");
+        return -1;
+    }
+    if(((uintptr_t)p % hugepage_buffer::HUGE_PAGE_SIZE) != 0) {
+        printf("not aligned\n");
+        return -1;
+    }
+    hugepage_buffer::deallocate(p, len * sizeof(int32_t));
+    const char *backings[] = {"heap", "hugetlbfs", "transparent huge pages"};
+    printf("%zu samples, huge pages from %s, NUMA node %d\n", len,
+        backings[(int)backing], hugepage_buffer::currentNUMANode());
+
+    //small ones from the heap.
+    {
+        std::vector<int32_t, hugepage_allocator<int32_t>> small(100, 1);
+        small.resize(200, 2);
+        if((small[99] != 1) || (small[100] != 2)) {
+            printf("failed\n");
+            return -1;
+        }
+    }
+
+    int64_t sum1 = bench<std::vector<int32_t>>("std::allocator", len, std::allocator<int32_t>());
+    int64_t sum2 = bench<std::vector<int32_t, hugepage_allocator<int32_t>>>("hugepage_allocator", len,
+        hugepage_allocator<int32_t>());
+    if(sum1 != sum2) {
+        printf("failed\n");
+        return -1;
+    }
+    printf("succeeded\n");
+    return 0;
+}
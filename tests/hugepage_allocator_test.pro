@@ -0,0 +1,11 @@
+TARGET = hugepage_allocator_test
+
+include(tests.pri)
+
+HEADERS += \
+    support.h \
+    ../kame/hugepage_allocator.h
+
+SOURCES += \
+    hugepage_allocator_test.cpp \
+    support.cpp
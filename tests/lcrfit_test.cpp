@@ -0,0 +1,134 @@
+/*
+ * lcrfit_test.cpp
+ *
+ * Benchmark of LCRFit in XAutoLCTuner, replaying S11 traces offline.
+ * Each trace is fitted from the previous result, as in a tuning loop.
+ * Without a file, a tuning run is synthesized, moving C1 and C2 of a circuit toward the target.
+ * Usage: lcrfit_test [file of traces]
+ * The file has lines of "freq[Hz] |S11|" or "freq[Hz] Re(S11) Im(S11)", traces separated by blank lines.
+ */
+
+#include "support.h"
+
+#include <chrono>
+#include <random>
+#include <fstream>
+#include <sstream>
+#include "lcrfit.h"
+#include "nllsfit.h"
+
+#define NUM_TRACES 12
+#define NUM_POINTS 401
+
+struct Trace {
+	double fstart, fstep;
+	std::vector<double> s11;
+	double f0; //!< of the circuit, 0 if unknown.
+};
+
+static double
+elapsed(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::vector<Trace>
+readTraces(const char *filename) {
+	std::vector<Trace> traces;
+	std::ifstream ifs(filename);
+	std::string line;
+	std::vector<double> freqs;
+	Trace trace = {};
+	auto flush = [&]() {
+		if(freqs.size() > 1) {
+			trace.fstart = freqs.front();
+			trace.fstep = (freqs.back() - freqs.front()) / (freqs.size() - 1);
+			traces.push_back(trace);
+		}
+		freqs.clear();
+		trace = {};
+	};
+	while(std::getline(ifs, line)) {
+		std::istringstream iss(line);
+		double f, x, y;
+		if( !(iss >> f >> x)) {
+			flush();
+			continue;
+		}
+		if(iss >> y)
+			x = std::abs(std::complex<double>(x, y));
+		freqs.push_back(f);
+		trace.s11.push_back(x);
+	}
+	flush();
+	return traces;
+}
+
+//! A probe being tuned at \a f_target, C1 and C2 approaching the tuned ones geometrically.
+static std::vector<Trace>
+synthesizeTraces(double f_target) {
+	std::mt19937 gen;
+	std::normal_distribution<double> gauss;
+	LCRFit probe(f_target, 0.0, true);
+	double c1_tuned = probe.c1(), c2_tuned = probe.c2();
+	std::vector<Trace> traces;
+	for(int k = 0; k < NUM_TRACES; ++k) {
+		double detune = 0.08 * pow(0.6, k);
+		probe.setCaps(c1_tuned * (1.0 + detune), c2_tuned * (1.0 - detune));
+		Trace trace;
+		trace.f0 = probe.f0();
+		trace.fstart = f_target * 0.8;
+		trace.fstep = f_target * 0.4 / NUM_POINTS;
+		for(int i = 0; i < NUM_POINTS; ++i) {
+			double omega = 2.0 * M_PI * (trace.fstart + i * trace.fstep);
+			trace.s11.push_back(std::abs(probe.rl(omega)) + 1e-3 * gauss(gen));
+		}
+		traces.push_back(trace);
+	}
+	return traces;
+}
+
+int
+main(int argc, char **argv) {
+	std::vector<Trace> traces = (argc > 1) ? readTraces(argv[1]) : synthesizeTraces(50e6);
+	if(traces.empty()) {
+		printf("no trace\n");
+		return -1;
+	}
+	printf("%u traces, %u threads\n", (unsigned int)traces.size(), NonLinearLeastSquareMultiStart::concurrency());
+
+	bool ok = true;
+	std::unique_ptr<LCRFit> lcr;
+	double t_total = 0.0;
+	for(unsigned int k = 0; k < traces.size(); ++k) {
+		const Trace &trace(traces[k]);
+		//As in XAutoLCTuner::analyze().
+		unsigned int imin = std::min_element(trace.s11.begin(), trace.s11.end()) - trace.s11.begin();
+		double fmin = trace.fstart + imin * trace.fstep;
+		double rlmin = trace.s11[imin];
+		bool is_tight_cpl = lcr ? lcr->isCouplingTight() : true;
+		if( !lcr)
+			lcr.reset(new LCRFit(fmin, rlmin, is_tight_cpl));
+		lcr->setTunedCaps(fmin, rlmin, is_tight_cpl);
+		LCRFit::Stats stats;
+		auto start = std::chrono::steady_clock::now();
+		lcr->fit(trace.s11, trace.fstart, trace.fstep, k == 0, &stats);
+		double t = elapsed(start);
+		t_total += t;
+		printf("trace %u: %.1f ms, %u starts, %u iterations, f0 = %.5f MHz", k, t * 1e3,
+			stats.starts, stats.iterations, lcr->f0() * 1e-6);
+		if(trace.f0) {
+			printf(" (%.5f MHz)", trace.f0 * 1e-6);
+			if( !(fabs(lcr->f0() - trace.f0) < 2.0 * trace.fstep))
+				ok = false;
+		}
+		printf(", RL = %.1f dB, residual = %.2g\n",
+			20.0 * log10(std::abs(lcr->rl(2.0 * M_PI * lcr->f0()))), lcr->residualError());
+	}
+	printf("total %.1f ms for the tuning loop\n", t_total * 1e3);
+	if( !ok) {
+		printf("failed\n");
+		return -1;
+	}
+	printf("succeeded\n");
+	return 0;
+}
@@ -0,0 +1,28 @@
+TARGET = lcrfit_test
+
+include(tests.pri)
+
+#sources in kame/math see support.h here first.
+INCLUDEPATH = $${_PRO_FILE_PWD_} $${INCLUDEPATH} $${_PRO_FILE_PWD_}/../kame/math $${_PRO_FILE_PWD_}/../modules/nmr
+
+HEADERS += \
+    support.h \
+    ../kame/math/nllsfit.h \
+    ../modules/nmr/lcrfit.h
+
+SOURCES += \
+    lcrfit_test.cpp \
+    ../modules/nmr/lcrfit.cpp \
+    support.cpp
+
+unix {
+    macx {
+        INCLUDEPATH += /opt/local/include
+        LIBS += -L/opt/local/lib/
+        LIBS += -lgsl
+    }
+    else {
+        CONFIG += link_pkgconfig
+        PKGCONFIG += gsl
+    }
+}
@@ -0,0 +1,162 @@
+/*
+ * nllsfit_test.cpp
+ *
+ * Test and benchmark of NonLinearLeastSquareMultiStart against serial random restarts,
+ * with T1 recovery curves fitted from a poor initial guess.
+ * Reports time per fit and convergence statistics.
+ * Usage: nllsfit_test [# of curves, default 100]
+ */
+
+#include "support.h"
+
+#include <chrono>
+#include <random>
+#include "nllsfit.h"
+
+#define NUM_POINTS 40
+#define T1 3.0 //[ms].
+#define MAX_STARTS 256
+
+static double
+elapsed(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct Point {
+	double p1, var, isigma;
+};
+
+int
+main(int argc, char **argv) {
+	int num_curves = (argc > 1) ? atoi(argv[1]) : 100;
+	std::mt19937 gen;
+	std::normal_distribution<double> gauss;
+	std::uniform_real_distribution<double> uni(0.0, 1.0);
+	const double p1min = 0.01, p1max = 100.0;
+
+	std::vector<std::vector<Point>> curves(num_curves);
+	for(auto &&pts: curves) {
+		for(int i = 0; i < NUM_POINTS; i++) {
+			double t = p1min * pow(p1max / p1min, (double)i / (NUM_POINTS - 1));
+			double sigma = 0.01;
+			pts.push_back({t, 2.0 * (1.0 - exp( -t / T1)) - 1.0 + sigma * gauss(gen), 1.0 / sigma});
+		}
+	}
+
+	bool ok = true;
+	double t_serial = 0.0, t_multi = 0.0;
+	unsigned int starts_serial = 0, starts_multi = 0, converged = 0, iterations = 0;
+	for(auto &&pts: curves) {
+		//iT1, c, a.
+		auto relax_f = [&pts](const double *params, size_t n, size_t p,
+			double *f, std::vector<double *> &df) -> bool {
+			double it1 = params[0], c = params[1], a = params[2];
+			for(size_t i = 0; i < n; i++) {
+				double e = exp(std::min(5.0, -pts[i].p1 * it1));
+				double yi = 1.0 - e;
+				if(f)
+					f[i] = (c * yi + a - pts[i].var) * pts[i].isigma;
+				df[0][i] = c * pts[i].p1 * e * pts[i].isigma;
+				df[1][i] = yi * pts[i].isigma;
+				df[2][i] = pts[i].isigma;
+			}
+			return true;
+		};
+		std::mt19937 gen_init;
+		auto init = [&](unsigned int start) -> std::valarray<double> {
+			if(start == 0)
+				return {1e3, -1e-3, 0.0}; //poor guess.
+			double it1 = 1.0 / exp(log(p1max / p1min) * uni(gen_init) + log(p1min));
+			double c = 2.0 * (uni(gen_init) * 2.0 + 0.9) * ((uni(gen_init) < 0.5) ? 1 : -1);
+			return {it1, c, 0.0};
+		};
+		//rejects T1 out of the measured range.
+		auto accept = [=](const std::valarray<double> &params) {
+			return (fabs(params[1]) < 20.0) && (params[0] > 0.1 / p1max) && (params[0] < 10.0 / p1min);
+		};
+
+		//serial restarts, allocating a solver every attempt.
+		auto start = std::chrono::steady_clock::now();
+		NonLinearLeastSquare nlls;
+		for(unsigned int k = 0; k < MAX_STARTS; k++) {
+			starts_serial++;
+			nlls = NonLinearLeastSquare(relax_f, init(k), NUM_POINTS, 30);
+			if(nlls.isSuccessful() && accept(nlls.params()))
+				break;
+		}
+		t_serial += elapsed(start);
+
+		gen_init.seed();
+		start = std::chrono::steady_clock::now();
+		NonLinearLeastSquareMultiStart::Stats stats;
+		auto best = NonLinearLeastSquareMultiStart::fit(relax_f, NUM_POINTS, init, accept,
+			30, MAX_STARTS, 1.0, 0.0, &stats);
+		t_multi += elapsed(start);
+		starts_multi += stats.starts;
+		converged += stats.converged;
+		iterations += stats.iterations;
+
+		double t1 = 1.0 / best.params()[0];
+		if( !best.isSuccessful() || !(fabs(t1 / T1 - 1.0) < 0.05) ||
+			(nlls.isSuccessful() && (best.chiSquare() > nlls.chiSquare() * (1.0 + 1e-6)))) {
+			printf("T1=%g, chi^2=%g, %s\n", t1, best.chiSquare(), best.status().c_str());
+			ok = false;
+		}
+	}
+	//a workspace gives the same result on reuse.
+	{
+		auto &pts = curves[0];
+		auto relax_f = [&pts](const double *params, size_t n, size_t p,
+			double *f, std::vector<double *> &df) -> bool {
+			for(size_t i = 0; i < n; i++) {
+				double yi = 1.0 - exp( -pts[i].p1 * params[0]);
+				if(f)
+					f[i] = (params[1] * yi - params[1] / 2 - pts[i].var) * pts[i].isigma;
+				df[0][i] = params[1] * pts[i].p1 * (1.0 - yi) * pts[i].isigma;
+				df[1][i] = (yi - 0.5) * pts[i].isigma;
+			}
+			return true;
+		};
+		NonLinearLeastSquare::Workspace ws;
+		NonLinearLeastSquare nlls1(ws, relax_f, {0.5, 1.5}, NUM_POINTS);
+		NonLinearLeastSquare nlls2(ws, relax_f, {0.5, 1.5}, NUM_POINTS);
+		NonLinearLeastSquare nlls3(relax_f, {0.5, 1.5}, NUM_POINTS);
+		if((nlls1.chiSquare() != nlls2.chiSquare()) || (nlls1.chiSquare() != nlls3.chiSquare())) {
+			printf("workspace reuse differs\n");
+			ok = false;
+		}
+	}
+	//no fit succeeds, with residuals of NaN.
+	{
+		auto nan_f = [](const double *params, size_t n, size_t p,
+			double *f, std::vector<double *> &df) -> bool {
+			for(size_t i = 0; i < n; i++) {
+				if(f)
+					f[i] = std::numeric_limits<double>::quiet_NaN();
+				for(size_t j = 0; j < p; j++)
+					df[j][i] = std::numeric_limits<double>::quiet_NaN();
+			}
+			return true;
+		};
+		NonLinearLeastSquareMultiStart::Stats stats;
+		auto best = NonLinearLeastSquareMultiStart::fit(nan_f, NUM_POINTS,
+			[](unsigned int) -> std::valarray<double> {return {1.0, 1.0};},
+			[](const std::valarray<double> &) {return true;},
+			30, 8, 1.0, 0.0, &stats);
+		if(best.params().size() || (stats.starts != 8)) {
+			printf("failed fits give a result\n");
+			ok = false;
+		}
+	}
+	printf("%d curves, %u threads: serial %.2f ms/fit (%.1f starts), multi-start %.2f ms/fit (%.1f starts, %.1f converged, %.1f iterations)\n",
+		num_curves, NonLinearLeastSquareMultiStart::concurrency(),
+		t_serial * 1e3 / num_curves, (double)starts_serial / num_curves,
+		t_multi * 1e3 / num_curves, (double)starts_multi / num_curves,
+		(double)converged / num_curves, (double)iterations / num_curves);
+	if( !ok) {
+		printf("failed\n");
+		return -1;
+	}
+	printf("succeeded\n");
+	return 0;
+}
@@ -0,0 +1,26 @@
+TARGET = nllsfit_test
+
+include(tests.pri)
+
+#sources in kame/math see support.h here first.
+INCLUDEPATH = $${_PRO_FILE_PWD_} $${INCLUDEPATH} $${_PRO_FILE_PWD_}/../kame/math
+
+HEADERS += \
+    support.h \
+    ../kame/math/nllsfit.h
+
+SOURCES += \
+    nllsfit_test.cpp \
+    support.cpp
+
+unix {
+    macx {
+        INCLUDEPATH += /opt/local/include
+        LIBS += -L/opt/local/lib/
+        LIBS += -lgsl
+    }
+    else {
+        CONFIG += link_pkgconfig
+        PKGCONFIG += gsl
+    }
+}
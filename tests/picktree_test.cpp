@@ -0,0 +1,114 @@
+/*
+ * picktree_test.cpp
+ *
+ * Test and microbenchmark of PickTree, the k-d tree for XPlot::findPoint(), without a display.
+ * The points found for random rays and points are compared with a scan over all the points,
+ * for 3D clouds, 2D traces, and coincident points.
+ * Usage: picktree_test [# of points, default 100000]
+ */
+
+#include "support.h"
+
+#include <chrono>
+#include <random>
+#include "picktree.h"
+
+#define NUM_QUERIES 2000
+
+static double
+elapsed(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool
+test(const char *name, const std::vector<PickTree::Entry> &entries, bool is_3d, std::mt19937 &gen) {
+	PickTree tree;
+	auto start = std::chrono::steady_clock::now();
+	tree.build(std::vector<PickTree::Entry>(entries));
+	double t_build = elapsed(start);
+	if(tree.size() != entries.size()) {
+		printf("%s: %u entries in the tree, expected %u\n", name, (unsigned int)tree.size(), (unsigned int)entries.size());
+		return false;
+	}
+	std::uniform_real_distribution<float> pos(-0.1f, 1.1f);
+	std::uniform_real_distribution<float> width(0.0f, 0.05f);
+	double t_tree = 0.0, t_scan = 0.0;
+	int nfound = 0, ndiff = 0;
+	for(int i = 0; i < NUM_QUERIES; ++i) {
+		//rays along Z for a 2D plot, slanted rays for 3D, and single points.
+		float p0[3] = {pos(gen), pos(gen), is_3d ? pos(gen) : 0.0f};
+		float p1[3] = {p0[0], p0[1], p0[2]};
+		if(i % 3) {
+			p1[2] += 1.0f;
+			if(is_3d) {
+				p1[0] = pos(gen);
+				p1[1] = pos(gen);
+			}
+		}
+		float w = width(gen);
+		uint64_t min_index = (i % 5) ? 0 : entries.size() / 2;
+		PickTree::LineQuery q_tree(p0, p1, w, min_index), q_scan(p0, p1, w, min_index);
+		start = std::chrono::steady_clock::now();
+		tree.search(q_tree);
+		t_tree += elapsed(start);
+		start = std::chrono::steady_clock::now();
+		for(auto &&e: entries)
+			q_scan.test(e.pos, e.index);
+		t_scan += elapsed(start);
+		if(q_scan.isFound())
+			nfound++;
+		if((q_tree.found != q_scan.found) || (q_tree.best != q_scan.best)) {
+			if(ndiff < 10)
+				printf("%s: mismatch at query %d, found %lld %g, expected %lld %g\n", name, i,
+					(long long)q_tree.found, q_tree.best, (long long)q_scan.found, q_scan.best);
+			ndiff++;
+		}
+	}
+	printf("%s: %u points, build %.2f ms, query %.2f us by the tree, %.2f us by the scan, %d found\n",
+		name, (unsigned int)entries.size(), t_build * 1e3, t_tree / NUM_QUERIES * 1e6, t_scan / NUM_QUERIES * 1e6, nfound);
+	if(ndiff) {
+		printf("%d mismatches\n", ndiff);
+		return false;
+	}
+	return true;
+}
+
+int
+main(int argc, char **argv) {
+	unsigned int num = (argc > 1) ? atoi(argv[1]) : 100000;
+	std::mt19937 gen(1);
+	std::uniform_real_distribution<float> uni(0.0f, 1.0f);
+	std::normal_distribution<float> noise(0.0f, 0.05f);
+	bool failed = false;
+
+	//scattered in the cube.
+	std::vector<PickTree::Entry> entries(num);
+	for(unsigned int i = 0; i < num; ++i)
+		entries[i] = {{uni(gen), uni(gen), uni(gen)}, i};
+	failed |= !test("cloud", entries, true, gen);
+
+	//a noisy trace, as in a 2D plot.
+	for(unsigned int i = 0; i < num; ++i)
+		entries[i] = {{(float)i / num, 0.5f + 0.3f * sinf(20.0f * i / num) + noise(gen), 0.0f}, i};
+	failed |= !test("trace", entries, false, gen);
+
+	//few distinct positions, the smallest index is taken.
+	for(unsigned int i = 0; i < num; ++i)
+		entries[i] = {{(float)(i % 7) / 7, (float)(i % 3) / 3, 0.0f}, i};
+	failed |= !test("coincident", entries, false, gen);
+
+	//small and empty trees.
+	for(unsigned int n: {0u, 1u, 2u, 17u, 33u}) {
+		entries.resize(n);
+		for(unsigned int i = 0; i < n; ++i)
+			entries[i] = {{uni(gen), uni(gen), 0.0f}, i};
+		failed |= !test("small", entries, false, gen);
+	}
+
+	if(failed) {
+		printf("failed\n");
+		return -1;
+	}
+	printf("succeeded\n");
+	return 0;
+}
@@ -0,0 +1,13 @@
+TARGET = picktree_test
+
+include(tests.pri)
+
+INCLUDEPATH += $${_PRO_FILE_PWD_}/../kame/graph
+
+HEADERS += \
+    support.h \
+    ../kame/graph/picktree.h
+
+SOURCES += \
+    picktree_test.cpp \
+    support.cpp
@@ -0,0 +1,173 @@
+/*
+ * plotkernels_test.cpp
+ *
+ * Test and microbenchmark of the batched transforms in XPlot::drawPlot(), without a display.
+ * The kernels are compared with the former per-point path,
+ * i.e., XAxis::valToAxis(), XPlot::graphToScreenFast(), isPtIncluded() and blendColor().
+ * Usage: plotkernels_test [# of points, default 1000000]
+ */
+
+#include "support.h"
+
+#include <chrono>
+#include <random>
+#include "plotkernels.h"
+
+#define NUM_REPEATS 5
+
+struct ValPoint {
+	double x, y, z, w;
+};
+struct GPoint {
+	float x, y, z, w;
+};
+struct CanvasPoint {
+	GPoint graph, scr;
+	bool insidecube;
+	unsigned int color;
+};
+
+//! As XAxis::valToAxis().
+struct Axis {
+	Axis(bool log, double min, double max) : log(log), min(min), max(max),
+		invLogMaxOverMin(-1), invMaxMinusMin(-1) {}
+	bool log;
+	double min, max;
+	double invLogMaxOverMin, invMaxMinusMin;
+	float valToAxis(double x) {
+		float pos;
+		if(log) {
+			if((x <= 0) || (min <= 0) || (max <= min))
+				return std::numeric_limits<float>::lowest();
+			if(invLogMaxOverMin < 0)
+				invLogMaxOverMin = 1 / std::log(max / min);
+			pos = std::log(x / min) * invLogMaxOverMin;
+		}
+		else {
+			if(max <= min) return -1;
+			if(invMaxMinusMin < 0)
+				invMaxMinusMin = 1 / (max - min);
+			pos = (x - min) * invMaxMinusMin;
+		}
+		return pos;
+	}
+	PlotKernels::AxisMap axisMap() const {
+		return log ? PlotKernels::AxisMap::log(min, max) : PlotKernels::AxisMap::linear(min, max);
+	}
+};
+
+//! As XPlot::blendColor(), with t in [0, 1].
+static unsigned int
+blendColor(unsigned int c1, unsigned int c2, float t) {
+	auto ch = [&](int shift) -> unsigned int {
+		return lrintf(((c2 >> shift) & 0xffu) * t + ((c1 >> shift) & 0xffu) * (1.0f - t));
+	};
+	return 0xff000000u | (ch(16) << 16) | (ch(8) << 8) | ch(0);
+}
+
+static const float scr0[] = {0.1f, 0.1f, 0.0f}, len[] = {0.8f, 0.8f, 0.5f};
+static const unsigned int colorlow = 0x0000ffu, colorhigh = 0xff8000u;
+
+//! As the former loop in XPlot::drawPlot().
+static void
+transformPerPoint(const std::vector<ValPoint> &pts, Axis axes[4], std::vector<CanvasPoint> &canvas) {
+	canvas.resize(pts.size());
+	CanvasPoint *cpt = &canvas[0];
+	for(auto &&pt: pts) {
+		GPoint g = {axes[0].valToAxis(pt.x), axes[1].valToAxis(pt.y), axes[2].valToAxis(pt.z), axes[3].valToAxis(pt.w)};
+		cpt->graph = g;
+		cpt->scr = {scr0[0] + len[0] * g.x, scr0[1] + len[1] * g.y, scr0[2] + len[2] * g.z,
+			std::min(std::max(g.w, 0.0f), 1.0f)};
+		cpt->insidecube = (g.x >= 0) && (g.x <= 1) && (g.y >= 0) && (g.y <= 1) && (g.z >= 0) && (g.z <= 1);
+		cpt->color = blendColor(colorlow, colorhigh, std::min(std::max(g.w, 0.0f), 1.0f));
+		cpt++;
+	}
+}
+
+static void
+transformBatched(const std::vector<ValPoint> &pts, Axis axes[4], PlotKernels::Batch &batch) {
+	size_t n = pts.size();
+	batch.resize(n);
+	const PlotKernels::AxisMap maps[] = {axes[0].axisMap(), axes[1].axisMap(), axes[2].axisMap(), axes[3].axisMap()};
+	PlotKernels::valToGraph( &pts[0], n, maps, batch.graph, 0);
+	PlotKernels::Arrays &g(batch.graph);
+	PlotKernels::graphToScreen(batch, n, scr0, len, &g.w[0], colorlow, colorhigh);
+}
+
+template <class F>
+static double
+benchmark(F f) {
+	auto start = std::chrono::steady_clock::now();
+	for(int k = 0; k < NUM_REPEATS; ++k)
+		f();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / NUM_REPEATS;
+}
+
+static bool
+close(float x, float y) {
+	return (x == y) || (fabsf(x - y) <= 1e-5f * std::max(1.0f, fabsf(x)));
+}
+
+int
+main(int argc, char **argv) {
+	int num_points = (argc > 1) ? atoi(argv[1]) : 1000000;
+	std::mt19937 gen;
+	std::uniform_real_distribution<double> uni(-0.2, 1.2);
+	std::vector<ValPoint> pts(num_points);
+	for(auto &&pt: pts)
+		pt = {uni(gen) * 10.0, uni(gen) * 1e3, uni(gen), uni(gen)};
+	int failed = 0;
+	for(bool log: {false, true}) {
+		//X and Y in linear or log scales, Z and W in linear scales.
+		Axis axes[4] = {{log, 1.0, 10.0}, {log, 1.0, 1e3}, {false, 0.0, 1.0}, {false, 0.0, 1.0}};
+		std::vector<CanvasPoint> canvas;
+		PlotKernels::Batch batch;
+		double t_point = benchmark([&]{transformPerPoint(pts, axes, canvas);});
+		double t_batch = benchmark([&]{transformBatched(pts, axes, batch);});
+
+		int ndiff = 0;
+		for(int i = 0; i < num_points; ++i) {
+			const CanvasPoint &c(canvas[i]);
+			bool ok = close(c.graph.x, batch.graph.x[i]) && close(c.graph.y, batch.graph.y[i]) &&
+				close(c.scr.x, batch.screen.x[i]) && close(c.scr.y, batch.screen.y[i]) &&
+				close(c.scr.z, batch.screen.z[i]) && close(c.scr.w, batch.screen.w[i]);
+			//positions on the boundaries may round differently.
+			bool boundary = (fabsf(c.graph.x) < 1e-5f) || (fabsf(c.graph.x - 1) < 1e-5f) ||
+				(fabsf(c.graph.y) < 1e-5f) || (fabsf(c.graph.y - 1) < 1e-5f);
+			if( !boundary)
+				ok = ok && (c.insidecube == !batch.outcodes[i]);
+			ok = ok && (c.color == batch.colors[i]);
+			if( !ok) {
+				if(ndiff++ < 10)
+					printf("mismatch at %d: %g %g -> %g %g, %g %g\n", i, pts[i].x, pts[i].y,
+						c.graph.x, c.graph.y, batch.graph.x[i], batch.graph.y[i]);
+			}
+		}
+		//trivial rejects.
+		int nrejects = 0;
+		for(int i = 0; i + 1 < num_points; ++i) {
+			if(batch.segments[i] == PlotKernels::SEGMENT_OUTSIDE) {
+				nrejects++;
+				const GPoint &g1(canvas[i].graph), &g2(canvas[i + 1].graph);
+				if( !((g1.x < 0) && (g2.x < 0)) && !((g1.x > 1) && (g2.x > 1)) &&
+					!((g1.y < 0) && (g2.y < 0)) && !((g1.y > 1) && (g2.y > 1)) &&
+					!((g1.z < 0) && (g2.z < 0)) && !((g1.z > 1) && (g2.z > 1))) {
+					if(ndiff++ < 10)
+						printf("wrong reject at %d\n", i);
+				}
+			}
+		}
+		printf("%s: %d points, per-point %.2f ns/point, batched %.2f ns/point, %d segments rejected\n",
+			log ? "log" : "linear", num_points, t_point * 1e9 / num_points, t_batch * 1e9 / num_points, nrejects);
+		if(ndiff) {
+			printf("%d mismatches\n", ndiff);
+			failed++;
+		}
+	}
+	if(failed) {
+		printf("failed\n");
+		return -1;
+	}
+	printf("succeeded\n");
+	return 0;
+}
@@ -0,0 +1,13 @@
+TARGET = plotkernels_test
+
+include(tests.pri)
+
+INCLUDEPATH += $${_PRO_FILE_PWD_}/../kame/graph
+
+HEADERS += \
+    support.h \
+    ../kame/graph/plotkernels.h
+
+SOURCES += \
+    plotkernels_test.cpp \
+    support.cpp
@@ -0,0 +1,92 @@
+/*
+ * spectrumsolver_test.cpp
+ *
+ * Benchmark of spectrum solvers at typical lengths of NMR echoes,
+ * checking that the strongest line is found at the right frequency.
+ * Usage: spectrumsolver_test [max. # of points, default 16384]
+ */
+
+#include "support.h"
+
+#include <chrono>
+#include <random>
+#include "spectrumsolver.h"
+#include "ar.h"
+#include "freqest.h"
+
+#define FREQ1 0.1 //cycles per point.
+#define FREQ2 -0.23
+
+static double
+elapsed(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool
+bench(const char *label, SpectrumSolver &solver, const std::vector<std::complex<double> > &memin, int fftlen) {
+	int t = memin.size();
+	std::vector<std::complex<double> > memout(fftlen);
+	auto start = std::chrono::steady_clock::now();
+	try {
+		solver.exec(memin, memout, -t / 2, 1e-3, &FFT::windowFuncRect, 1.0);
+	}
+	catch (XKameError &e) {
+		printf("%s: t=%d, %s\n", label, t, e.what());
+		return true;
+	}
+	double t_exec = elapsed(start);
+	int imax = 0;
+	for(int i = 0; i < fftlen; i++) {
+		if(std::abs(memout[i]) > std::abs(memout[imax]))
+			imax = i;
+	}
+	double freq = (double)imax / fftlen;
+	freq -= floor(freq + 0.5);
+	printf("%s: t=%d, n=%d, %.2f ms, %d peaks, line at %.4f\n", label, t, fftlen, t_exec * 1e3,
+		(int)solver.peaks().size(), freq);
+	return fabs(freq - FREQ1) < 4.0 / fftlen + 1.0 / t;
+}
+
+int
+main(int argc, char **argv) {
+	int tmax = (argc > 1) ? atoi(argv[1]) : 16384;
+	std::mt19937 gen;
+	std::normal_distribution<double> gauss;
+	bool ok = true;
+	for(int t = 512; t <= tmax; t *= 2) {
+		int fftlen = FFT::fitLength(t * 4);
+		std::vector<std::complex<double> > memin(t);
+		for(int i = 0; i < t; i++) {
+			double dt = i - t / 2;
+			memin[i] = std::polar(exp( -fabs(dt) / t * 4.0), 2.0 * M_PI * FREQ1 * dt)
+				+ std::polar(0.3 * exp( -fabs(dt) / t * 8.0), 2.0 * M_PI * FREQ2 * dt)
+				+ 0.05 * std::complex<double>(gauss(gen), gauss(gen));
+		}
+		FFTSolver fft;
+		ok = bench("ZF-FFT", fft, memin, fftlen) && ok;
+		YuleWalkerAR ar;
+		ok = bench("Yule-Walker AR", ar, memin, fftlen) && ok;
+		MEMBurg burg;
+		ok = bench("Burg's MEM", burg, memin, fftlen) && ok;
+		if(t <= 2048) {
+			MEMStrict mem;
+			ok = bench("Strict MEM", mem, memin, fftlen) && ok;
+		}
+#ifdef HAVE_LAPACK
+		if(t <= 1024) {
+			MUSIC music;
+			ok = bench("MUSIC", music, memin, fftlen) && ok;
+			EigenVectorMethod ev;
+			ok = bench("Eigenvector", ev, memin, fftlen) && ok;
+			MVDL mvdl;
+			ok = bench("MVDL", mvdl, memin, fftlen) && ok;
+		}
+#endif
+	}
+	if( !ok) {
+		printf("failed\n");
+		return -1;
+	}
+	printf("succeeded\n");
+	return 0;
+}
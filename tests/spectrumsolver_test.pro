@@ -0,0 +1,35 @@
+TARGET = spectrumsolver_test
+
+include(tests.pri)
+
+#sources in kame/math see support.h here first.
+INCLUDEPATH = $${_PRO_FILE_PWD_} $${INCLUDEPATH} $${_PRO_FILE_PWD_}/../kame/math
+
+HEADERS += \
+    support.h \
+    ../kame/math/spectrumsolver.h \
+    ../kame/math/ar.h \
+    ../kame/math/freqest.h \
+    ../kame/math/matrix.h \
+    ../kame/math/fft.h
+
+SOURCES += \
+    spectrumsolver_test.cpp \
+    ../kame/math/spectrumsolver.cpp \
+    ../kame/math/ar.cpp \
+    ../kame/math/freqest.cpp \
+    ../kame/math/matrix.cpp \
+    ../kame/math/fft.cpp \
+    support.cpp
+
+unix {
+    macx {
+        INCLUDEPATH += /opt/local/include
+        LIBS += -L/opt/local/lib/
+        LIBS += -lfftw3 -lgsl
+    }
+    else {
+        CONFIG += link_pkgconfig
+        PKGCONFIG += fftw3 gsl
+    }
+}
@@ -13,9 +13,34 @@
 ***************************************************************************/
 #include "support.h"
 #include "atomic.h"
+#include <errno.h>
+#include <stdarg.h>
 
 bool g_bUseMLock = false;
 
+XKameError::XKameError(const XString &s, const char *file, int line)
+	: std::runtime_error(s), m_msg(s), m_file(file), m_line(line), m_errno(errno) {
+	errno = 0;
+}
+const XString &
+XKameError::msg() const {
+	return m_msg;
+}
+const char *
+XKameError::what() const throw() {
+	return m_msg.c_str();
+}
+
+XString
+formatString(const char *fmt, ...) {
+	char buf[1024];
+	va_list ap;
+	va_start(ap, fmt);
+	vsnprintf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+	return buf;
+}
+
 int my_assert(char const*s, int d) {
         fprintf(stderr, "Err:%s:%d\n", s, d);
         abort();
@@ -91,5 +91,14 @@ private:
 	const int m_errno;
 };
 
+//! Debugging messages are discarded in tests.
+#define dbgPrint(msg) ((void)0)
+#define i18n(src) XString(src)
+XString formatString(const char *format, ...)
+#if defined __GNUC__ || defined __clang__
+	__attribute__ ((format(printf,1,2)))
+#endif
+;
+
 //---------------------------------------------------------------------------
 #endif
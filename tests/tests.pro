@@ -6,7 +6,18 @@ SUBDIRS += \
     atomic_shared_ptr_test\
     atomic_scoped_ptr_test\
     atomic_queue_test\
+    atomic_spsc_queue_test\
+    chunkedring_test\
+    darkpsd_test\
+    echotrain_test\
+    firdecimator_test\
+    hugepage_allocator_test\
+    lcrfit_test\
     mutex_test\
+    nllsfit_test\
+    picktree_test\
+    plotkernels_test\
+    spectrumsolver_test\
     transaction_test\
     transaction_dynamic_node_test\
     transaction_negotiation_test
@@ -14,7 +25,24 @@ SUBDIRS += \
 atomic_shared_ptr_test.file = atomic_shared_ptr_test.pro
 atomic_scoped_ptr_test.file = atomic_scoped_ptr_test.pro
 atomic_queue_test.file = atomic_queue_test.pro
+atomic_spsc_queue_test.file = atomic_spsc_queue_test.pro
+chunkedring_test.file = chunkedring_test.pro
+darkpsd_test.file = darkpsd_test.pro
+echotrain_test.file = echotrain_test.pro
+firdecimator_test.file = firdecimator_test.pro
+hugepage_allocator_test.file = hugepage_allocator_test.pro
+lcrfit_test.file = lcrfit_test.pro
 mutex_test.file = mutex_test.pro
+nllsfit_test.file = nllsfit_test.pro
+picktree_test.file = picktree_test.pro
+plotkernels_test.file = plotkernels_test.pro
+spectrumsolver_test.file = spectrumsolver_test.pro
 transaction_test.file = transaction_test.pro
 transaction_dynamic_node_test.file = transaction_dynamic_node_test.pro
 transaction_negotiation_test.file = transaction_negotiation_test.pro
+
+#offscreen OpenGL benchmark, with EGL.
+unix:!macx {
+    SUBDIRS += graphgl_test
+    graphgl_test.file = graphgl_test.pro
+}